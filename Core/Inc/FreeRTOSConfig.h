@@ -52,20 +52,22 @@
   extern uint32_t SystemCoreClock;
 #endif
 #define configUSE_PREEMPTION                     1
-#define configSUPPORT_STATIC_ALLOCATION          0
-#define configSUPPORT_DYNAMIC_ALLOCATION         1
+#define configSUPPORT_STATIC_ALLOCATION          1
+#define configSUPPORT_DYNAMIC_ALLOCATION         0
 #define configUSE_IDLE_HOOK                      0
 #define configUSE_TICK_HOOK                      0
+#define configUSE_TICKLESS_IDLE                  2
 #define configCPU_CLOCK_HZ                       ( SystemCoreClock )
 #define configTICK_RATE_HZ                       ((TickType_t)1000)
 #define configMAX_PRIORITIES                     ( 7 )
 #define configMINIMAL_STACK_SIZE                 ((uint16_t)128)
-#define configTOTAL_HEAP_SIZE                    ((size_t)15360)
 #define configMAX_TASK_NAME_LEN                  ( 16 )
 #define configUSE_16_BIT_TICKS                   0
 #define configUSE_MUTEXES                        1
 #define configQUEUE_REGISTRY_SIZE                8
 #define configUSE_PORT_OPTIMISED_TASK_SELECTION  1
+#define configUSE_TRACE_FACILITY                 1
+#define configGENERATE_RUN_TIME_STATS            1
 
 /* Co-routine definitions. */
 #define configUSE_CO_ROUTINES                    0
@@ -121,10 +123,59 @@ standard names. */
 /* IMPORTANT: This define is commented when used with STM32Cube firmware, when the timebase source is SysTick,
               to prevent overwriting SysTick_Handler defined within STM32Cube HAL */
  
-#define xPortSysTickHandler SysTick_Handler
+/* #define xPortSysTickHandler SysTick_Handler */
 
 /* USER CODE BEGIN Defines */   	      
 /* Section where parameter definitions can be added (for instance, to override default ones in FreeRTOS.h) */
+/* The settings above come from the FREERTOS entries of the .ioc; fail the
+build rather than quietly lose tickless idle or the telemetry and trace hooks
+if the file is ever regenerated without them. */
+#if configUSE_TICKLESS_IDLE != 2 || configUSE_TRACE_FACILITY != 1 || configGENERATE_RUN_TIME_STATS != 1
+  #error "FreeRTOSConfig.h regenerated without the FREERTOS settings of IBM_Model_M_1394100_Retrofit.ioc"
+#endif
+/* Everything is statically allocated and Tools/membudget.py counts on there
+being no RTOS heap at all. */
+#if configSUPPORT_STATIC_ALLOCATION != 1 || configSUPPORT_DYNAMIC_ALLOCATION != 0 || defined(configTOTAL_HEAP_SIZE)
+  #error "FreeRTOSConfig.h regenerated with an RTOS heap, see IBM_Model_M_1394100_Retrofit.ioc"
+#endif
+
+/* Tickless idle sleeps on the TIM5 time base instead of reprogramming SysTick,
+see Core/Src/Power/power.c. */
+#if defined(__ICCARM__) || defined(__CC_ARM) || defined(__GNUC__)
+  extern void powerSuppressTicksAndSleep(uint32_t xExpectedIdleTime);
+#endif
+#define portSUPPRESS_TICKS_AND_SLEEP( xExpectedIdleTime ) powerSuppressTicksAndSleep( xExpectedIdleTime )
+
+/* Run time stats count core clock cycles on the DWT, and every context switch
+is timed per task for Core/Src/Telemetry/telemetry.c and logged by the event
+recorder in Core/Src/Trace/trace.c. The 32 bit count wraps every 67 s at
+64 MHz, which the telemetry snapshot period stays well inside. */
+#if defined(__ICCARM__) || defined(__CC_ARM) || defined(__GNUC__)
+  extern void utilsCycleCounterInit(void);
+  extern void telemetryTaskSwitchedIn(uint32_t ulTaskNumber);
+  extern void telemetryTaskSwitchedOut(uint32_t ulTaskNumber);
+  extern void traceTaskCreated(uint32_t ulTaskNumber, const char *pcName);
+  extern void traceTaskSwitchedIn(uint32_t ulTaskNumber);
+  extern void traceTaskSwitchedOut(uint32_t ulTaskNumber);
+  extern void traceTick(uint32_t ulTickCount);
+  extern void traceNotify(uint32_t ulTaskNumber, uint32_t ulFromIsr);
+  extern void traceNotifyWait(uint32_t ulTaskNumber, uint32_t ulBlocking);
+  extern void traceQueue(uint32_t ulQueueNumber, uint32_t ulReceive);
+  extern void traceEventBits(uint32_t ulBits);
+#endif
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS() utilsCycleCounterInit()
+#define portGET_RUN_TIME_COUNTER_VALUE() ( *( volatile uint32_t * ) 0xE0001004UL ) /* DWT->CYCCNT */
+#define traceTASK_SWITCHED_IN() do { telemetryTaskSwitchedIn( pxCurrentTCB->uxTCBNumber ); traceTaskSwitchedIn( pxCurrentTCB->uxTCBNumber ); } while( 0 )
+#define traceTASK_SWITCHED_OUT() do { traceTaskSwitchedOut( pxCurrentTCB->uxTCBNumber ); telemetryTaskSwitchedOut( pxCurrentTCB->uxTCBNumber ); } while( 0 )
+#define traceTASK_CREATE( pxNewTCB ) traceTaskCreated( ( pxNewTCB )->uxTCBNumber, ( pxNewTCB )->pcTaskName )
+#define traceTASK_INCREMENT_TICK( xTickCount ) traceTick( xTickCount )
+#define traceTASK_NOTIFY() traceNotify( pxTCB->uxTCBNumber, 0 )
+#define traceTASK_NOTIFY_FROM_ISR() traceNotify( pxTCB->uxTCBNumber, 1 )
+#define traceTASK_NOTIFY_WAIT_BLOCK() traceNotifyWait( pxCurrentTCB->uxTCBNumber, 1 )
+#define traceTASK_NOTIFY_WAIT() traceNotifyWait( pxCurrentTCB->uxTCBNumber, 0 )
+#define traceQUEUE_SEND( pxQueue ) traceQueue( ( pxQueue )->uxQueueNumber, 0 )
+#define traceQUEUE_RECEIVE( pxQueue ) traceQueue( ( pxQueue )->uxQueueNumber, 1 )
+#define traceEVENT_GROUP_SET_BITS( xEventGroup, uxBitsToSet ) traceEventBits( uxBitsToSet )
 /* USER CODE END Defines */ 
 
 #endif /* FREERTOS_CONFIG_H */
@@ -53,8 +53,10 @@ void MemManage_Handler(void);
 void BusFault_Handler(void);
 void UsageFault_Handler(void);
 void DebugMon_Handler(void);
-void TIM1_UP_TIM10_IRQHandler(void);
+void SysTick_Handler(void);
+void OTG_FS_IRQHandler(void);
 /* USER CODE BEGIN EFP */
+void TIM5_IRQHandler(void);
 
 /* USER CODE END EFP */
 
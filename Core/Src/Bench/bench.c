@@ -0,0 +1,331 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file bench.c
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief Times the hot paths on the cycle counter, in the benchmark build
+ ******************************************************************************/
+// @formatter:off
+
+/* Includes ------------------------------------------------------------------*/
+#include "bench.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "main.h"
+#include "usb_device.h"
+#include "usbd_hid.h"
+#include "../Utilities/utils.h"
+#include "../Keyboard/keyboard.h"
+#include "../UsbInterface/usb_if.h"
+
+#include <string.h>
+
+/**
+ * Each case runs benchWARMUP times untimed, to fill the caches and settle any
+ * first-time paths, then benchREPS times between two reads of the cycle
+ * counter. Interrupts stay on, so the median is the number to quote and the
+ * maximum shows what the rest of the system can add. The cases call the same
+ * static functions the scan and report tasks do, through the keyboardBench
+ * and usbifBench hooks, and those tasks are not started in this build.
+ *
+ * Results land in benchResults for a debugger and are read over USB as HID
+ * feature report 5 (Tools/bench_read.py). In the simulation, DWT->CYCCNT is
+ * the virtual clock, which only GPIO and cycle counter accesses advance, so
+ * the numbers there show the harness working, not the code's speed.
+ */
+
+/* Global variables ----------------------------------------------------------*/
+bench_results_t benchResults;
+
+#if benchENABLE
+extern USBD_HandleTypeDef hUsbDeviceFS;
+
+/* Private types -------------------------------------------------------------*/
+typedef struct _BENCH_CASE_DEF_S_
+{
+	const char *name;
+	void (*setup)(uint32_t rep);	/* Untimed, may be NULL */
+	void (*run)(uint32_t rep);		/* Timed */
+	_Bool (*ready)(void);			/* Whether the case can run, may be NULL */
+} bench_case_def_t;
+
+/* Private variables ---------------------------------------------------------*/
+static StackType_t benchStack[benchSTACK_SIZE];
+static StaticTask_t benchTcb;
+static bench_results_t working;
+static uint32_t samples[benchREPS];
+static usb_hid_kb_rpt_t *sendReport;
+static volatile uint32_t sink;		/* Keeps results the compiler would drop */
+
+/* Static prototypes ---------------------------------------------------------*/
+static void benchTask(void *pvParameters);
+static void benchRun(void);
+static void benchCase(const bench_case_def_t *def, bench_case_t *result,
+		uint32_t overhead);
+static void benchSort(uint32_t *values, uint32_t count);
+static void benchRowRead(uint32_t rep);
+static void benchFrame(uint32_t rep);
+static void benchDebounce(uint32_t rep);
+static void benchReportBuild(uint32_t rep);
+static void benchSendSetup(uint32_t rep);
+static void benchSend(uint32_t rep);
+static _Bool benchUsbReady(void);
+
+static const bench_case_def_t cases[] = {
+		{ .name = "rowread", .run = benchRowRead },
+		{ .name = "frame", .run = benchFrame },
+		{ .name = "debounce", .run = benchDebounce },
+		{ .name = "report", .run = benchReportBuild },
+		{ .name = "sendrpt", .setup = benchSendSetup, .run = benchSend,
+				.ready = benchUsbReady },
+};
+
+_Static_assert(sizeof(cases) / sizeof(cases[0]) <= benchMAX_CASES,
+		"More benchmark cases than the results block holds");
+
+/* Code ----------------------------------------------------------------------*/
+/**
+ * @brief Runs the suite once, then has nothing more to do
+ * @param pvParameters UNUSED, for FreeRTOS consistency only
+ * @retval none
+ */
+static void benchTask(void *pvParameters)
+{
+	UNUSED(pvParameters);
+	keyboardBenchPrepare();
+	benchRun();
+	vTaskDelete(NULL);
+}
+
+/**
+ * @brief Times every case and publishes the results
+ * @param none
+ * @retval none
+ */
+static void benchRun(void)
+{
+	uint32_t start;
+	uint32_t overhead = UINT32_MAX;
+	uint32_t numCases = sizeof(cases) / sizeof(cases[0]);
+
+	/* The cheapest back-to-back pair of counter reads is what every run pays */
+	for (uint32_t ii = 0; ii < benchREPS; ii++)
+	{
+		start = utilsCYCLES();
+		sink = utilsCYCLES() - start;
+		overhead = MIN(overhead, sink);
+	}
+
+	memset(&working, 0, sizeof(working));
+	working.id = HID_BENCH_REPORT_ID;
+	working.overheadCycles = (uint16_t)MIN(overhead, UINT16_MAX);
+	working.cpuHz = SystemCoreClock;
+	for (uint32_t ii = 0; ii < numCases; ii++)
+	{
+		benchCase(&cases[ii], &working.cases[ii], overhead);
+	}
+	working.numCases = (uint8_t)numCases;
+	working.runs = benchResults.runs + 1;
+	working.uptimeMs = HAL_GetTick();
+
+	taskENTER_CRITICAL();
+	benchResults = working;
+	taskEXIT_CRITICAL();
+
+	os_printf("bench: %lu Hz, overhead %u cycles\r\n",
+			(unsigned long)working.cpuHz, working.overheadCycles);
+	for (uint32_t ii = 0; ii < numCases; ii++)
+	{
+		bench_case_t *result = &working.cases[ii];
+
+		os_printf("bench: %-8s %3u reps  min %8lu  median %8lu  max %8lu cycles\r\n",
+				cases[ii].name, result->reps, (unsigned long)result->minCycles,
+				(unsigned long)result->medianCycles, (unsigned long)result->maxCycles);
+	}
+}
+
+/**
+ * @brief Warms up, times and summarizes one case
+ * @param def Case to run
+ * @param result Filled in, reps left at 0 if the case could not run
+ * @param overhead Counter read cost to take off each sample
+ * @retval none
+ */
+static void benchCase(const bench_case_def_t *def, bench_case_t *result,
+		uint32_t overhead)
+{
+	uint32_t start;
+	uint32_t elapsed;
+
+	strncpy(result->name, def->name, benchNAME_LEN);
+	result->warmup = benchWARMUP;
+	if (def->ready != NULL && !def->ready())
+	{
+		return;
+	}
+	for (uint32_t ii = 0; ii < benchWARMUP + benchREPS; ii++)
+	{
+		if (def->setup != NULL)
+		{
+			def->setup(ii);
+		}
+		start = utilsCYCLES();
+		def->run(ii);
+		elapsed = utilsCYCLES() - start;
+		if (ii >= benchWARMUP)
+		{
+			samples[ii - benchWARMUP] = (elapsed > overhead) ? elapsed - overhead : 0;
+		}
+	}
+	benchSort(samples, benchREPS);
+	result->reps = benchREPS;
+	result->minCycles = samples[0];
+	result->medianCycles = samples[benchREPS / 2];
+	result->maxCycles = samples[benchREPS - 1];
+}
+
+/**
+ * @brief Insertion sort, plenty for benchREPS values
+ * @param values Values to sort in place
+ * @param count Number of values
+ * @retval none
+ */
+static void benchSort(uint32_t *values, uint32_t count)
+{
+	uint32_t value;
+	uint32_t jj;
+
+	for (uint32_t ii = 1; ii < count; ii++)
+	{
+		value = values[ii];
+		for (jj = ii; jj > 0 && values[jj - 1] > value; jj--)
+		{
+			values[jj] = values[jj - 1];
+		}
+		values[jj] = value;
+	}
+}
+
+/**
+ * @brief Case: sampling every column of one row
+ * @param rep UNUSED
+ * @retval none
+ */
+static void benchRowRead(uint32_t rep)
+{
+	UNUSED(rep);
+	sink = keyboardBenchReadRow();
+}
+
+/**
+ * @brief Case: a full frame, settle waits and row processing included
+ * @param rep UNUSED
+ * @retval none
+ */
+static void benchFrame(uint32_t rep)
+{
+	UNUSED(rep);
+	keyboardBenchFrame();
+}
+
+/**
+ * @brief Case: debounce and dispatch for a row with nothing pressed
+ * @note The common case; a row in the middle of an edge costs a little more.
+ * @param rep Picks the row
+ * @retval none
+ */
+static void benchDebounce(uint32_t rep)
+{
+	keyboardBenchProcessRow((uint8_t)(rep % keyboardNUM_ROWS), 0);
+}
+
+/**
+ * @brief Case: one key change queued and built into a report
+ * @param rep Even reps press, odd reps release
+ * @retval none
+ */
+static void benchReportBuild(uint32_t rep)
+{
+	sendReport = usbifBenchReport(!(rep & 1));
+}
+
+/**
+ * @brief Waits, untimed, for the IN endpoint to finish the last report
+ * @note The report buffer belongs to the endpoint until then.
+ * @param rep UNUSED
+ * @retval none
+ */
+static void benchSendSetup(uint32_t rep)
+{
+	USBD_HID_HandleTypeDef *hhid = (USBD_HID_HandleTypeDef *)hUsbDeviceFS.pClassData;
+
+	UNUSED(rep);
+	while (hhid != NULL && hhid->state != HID_IDLE && usbifIsConfigured())
+	{
+		vTaskDelay(1);
+	}
+	sendReport = usbifBenchReport(0);
+}
+
+/**
+ * @brief Case: handing a report to the IN endpoint
+ * @param rep UNUSED
+ * @retval none
+ */
+static void benchSend(uint32_t rep)
+{
+	UNUSED(rep);
+	sink = USBD_HID_SendReport(&hUsbDeviceFS, (uint8_t *)sendReport,
+			sizeof(usb_hid_kb_rpt_t));
+}
+
+/**
+ * @brief Waits for the host to configure us, for the USB cases
+ * @param none
+ * @retval 1 if configured within benchUSB_WAIT_MS
+ */
+static _Bool benchUsbReady(void)
+{
+	uint32_t start = HAL_GetTick();
+
+	while (!usbifIsConfigured() && HAL_GetTick() - start < benchUSB_WAIT_MS)
+	{
+		vTaskDelay(pdMS_TO_TICKS(10));
+	}
+	return usbifIsConfigured();
+}
+#endif
+
+/**
+ * @brief Copies the results block
+ * @note Safe to call from the USB interrupt.
+ * @param results Destination for the results
+ * @retval none
+ */
+void benchGetResults(bench_results_t *results)
+{
+	UBaseType_t mask = taskENTER_CRITICAL_FROM_ISR();
+	*results = benchResults;
+	taskEXIT_CRITICAL_FROM_ISR(mask);
+}
+
+/**
+ * @brief Clears the results and, in the benchmark build, starts the runner
+ * @note In any other build the block reads back with no cases.
+ * @param none
+ * @retval none
+ */
+void benchInit(void)
+{
+	benchResults = (bench_results_t) {
+		.id = HID_BENCH_REPORT_ID,
+				.cpuHz = SystemCoreClock
+	};
+#if benchENABLE
+	utilsCycleCounterInit();
+	xTaskCreateStatic(benchTask, "bench", benchSTACK_SIZE, NULL,
+			benchPRIORITY, benchStack, &benchTcb);
+#endif
+}
+/* EOF */
@@ -0,0 +1,78 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file bench.h
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief Definitions and prototypes for the cycle counter microbenchmarks
+ ******************************************************************************/
+// @formatter:off
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __BENCH_H
+#define __BENCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx_hal.h"
+#include "main.h"
+
+/* Defines -------------------------------------------------------------------*/
+/**
+ * The benchmark build: define benchENABLE=1 in the compiler's preprocessor
+ * symbols (or make BENCH=1 in Simulation/). The runner then takes the place
+ * of the scan and report tasks and the keyboard does not type.
+ */
+#ifndef benchENABLE
+#define benchENABLE					( 0 )
+#endif
+
+#define benchSTACK_SIZE				( 512 )
+#define benchPRIORITY				( tskIDLE_PRIORITY + 3 )
+#define benchWARMUP					( 8 )	/* Runs thrown away per case */
+#define benchREPS					( 64 )	/* Runs timed per case */
+#define benchUSB_WAIT_MS			( 5000 )	/* For the host to configure us */
+#define benchMAX_CASES				( 6 )
+#define benchNAME_LEN				( 8 )
+
+/* Structures ----------------------------------------------------------------*/
+typedef struct _BENCH_CASE_S_
+{
+	char name[benchNAME_LEN];	/* Truncated, not terminated */
+	uint16_t reps;			/* Runs timed, 0 if the case could not run */
+	uint16_t warmup;		/* Runs thrown away first */
+	uint32_t minCycles;		/* Timer overhead already taken off */
+	uint32_t medianCycles;
+	uint32_t maxCycles;
+} bench_case_t;
+
+/**
+ * The results block, in RAM for a debugger and exported as-is as HID feature
+ * report 5, so the layout is the wire format. Little endian throughout.
+ */
+typedef struct _BENCH_RESULTS_S_
+{
+	uint8_t id;				/* HID report ID */
+	uint8_t numCases;		/* Valid entries in cases[], 0 until a run is done */
+	uint16_t overheadCycles;/* Cost of reading the counter twice, taken off */
+	uint32_t cpuHz;			/* Cycle counter rate */
+	uint32_t runs;			/* Completed runs since boot */
+	uint32_t uptimeMs;		/* HAL tick when the last run finished */
+	bench_case_t cases[benchMAX_CASES];
+} bench_results_t;
+
+/* Prototypes ----------------------------------------------------------------*/
+void benchInit(void);
+void benchGetResults(bench_results_t *results);
+
+/* Exported variables --------------------------------------------------------*/
+extern bench_results_t benchResults;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BENCH_H */
+/* EOF */
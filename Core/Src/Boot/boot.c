@@ -0,0 +1,155 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file boot.c
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief Times the way from power-on to the first keystroke the host sees
+ ******************************************************************************/
+// @formatter:off
+
+/* Includes ------------------------------------------------------------------*/
+#include "boot.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "main.h"
+#include "../Utilities/utils.h"
+
+/**
+ * The startup order is laid out for the first keystroke:
+ *
+ *   main()            clocks and GPIO, then every module's init; none of
+ *                     them waits on hardware, and interrupts stay masked
+ *                     until the scheduler starts
+ *   defaultTask       highest priority, so the first thing to run: starts
+ *                     the USB device and turns the pull-up on
+ *   kbscan            calibrates the settle times and starts scanning while
+ *                     the host is still waiting out its attach debounce
+ *   USB interrupt     enumeration is answered entirely from descriptors and
+ *                     needs nothing from the keyboard
+ *   usbrpt            key changes queued before configuration are replayed
+ *                     in order once it happens (usb_if.c)
+ *
+ * Each step marks the HAL tick it got to in bootTimes, for a debugger, and
+ * bootLog() prints them against the budgets in boot.h.
+ */
+
+/* Global variables ----------------------------------------------------------*/
+boot_times_t bootTimes;		/* In .bss, so valid before main() runs */
+
+/* Private variables ---------------------------------------------------------*/
+static const char *const markNames[bootMARKS] = {
+		"clocks", "usb", "frame", "configured", "edge", "report"
+};
+static const uint16_t budgetMs[bootMARKS] = {
+		bootBUDGET_CLOCKS_MS, bootBUDGET_USB_MS, bootBUDGET_FRAME_MS,
+		bootBUDGET_CONFIGURED_MS, 0, bootBUDGET_REPORT_MS
+};
+static uint32_t logged;		/* Marks bootLog() has printed */
+
+/* Static prototypes ---------------------------------------------------------*/
+static uint32_t bootDeadline(boot_mark_t mark);
+
+/* Code ----------------------------------------------------------------------*/
+/**
+ * @brief Works out when a mark was due
+ * @note The first report can't go out before both the host and a key are
+ *       ready, so its budget runs from the later of the two.
+ * @param mark Mark
+ * @retval HAL tick it was due by, UINT32_MAX if it has no budget
+ */
+static uint32_t bootDeadline(boot_mark_t mark)
+{
+	uint32_t from = 0;
+
+	if (budgetMs[mark] == 0)
+	{
+		return UINT32_MAX;
+	}
+	if (mark == bootMARK_FIRST_REPORT)
+	{
+		from = bootTimes.atMs[bootMARK_CONFIGURED];
+		if (bootTimes.atMs[bootMARK_FIRST_EDGE] > from)
+		{
+			from = bootTimes.atMs[bootMARK_FIRST_EDGE];
+		}
+	}
+	return from + budgetMs[mark];
+}
+
+/**
+ * @brief Notes the first time a milestone is reached
+ * @note Callable from any context, before the scheduler starts too. Later
+ *       calls for the same mark are ignored, so it can sit on a hot path.
+ * @param mark Milestone
+ * @retval none
+ */
+void bootMark(boot_mark_t mark)
+{
+	UBaseType_t mask;
+	uint32_t now;
+
+	if (bootTimes.seen & (1UL << mark))
+	{
+		return;
+	}
+	mask = portSET_INTERRUPT_MASK_FROM_ISR();
+	if (!(bootTimes.seen & (1UL << mark)))
+	{
+		now = HAL_GetTick();
+		bootTimes.atMs[mark] = now;
+		bootTimes.seen |= 1UL << mark;
+		if (now > bootDeadline(mark))
+		{
+			bootTimes.overBudget |= 1UL << mark;
+		}
+	}
+	portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+}
+
+/**
+ * @brief Tells whether a milestone has been reached
+ * @param mark Milestone
+ * @retval 1 if it has
+ */
+_Bool bootReached(boot_mark_t mark)
+{
+	return (bootTimes.seen & (1UL << mark)) != 0;
+}
+
+/**
+ * @brief Prints the milestones reached since the last call
+ * @note Call from a task, never from an interrupt.
+ * @param none
+ * @retval none
+ */
+void bootLog(void)
+{
+	uint32_t fresh = bootTimes.seen & ~logged;
+
+	if (fresh == 0)
+	{
+		return;
+	}
+	logged |= fresh;
+	for (uint32_t ii = 0; ii < bootMARKS; ii++)
+	{
+		if (!(fresh & (1UL << ii)))
+		{
+			continue;
+		}
+		if (budgetMs[ii] == 0)
+		{
+			os_printf("boot: %-10s %5lu ms\r\n", markNames[ii],
+					(unsigned long)bootTimes.atMs[ii]);
+		}
+		else
+		{
+			os_printf("boot: %-10s %5lu ms, due by %lu%s\r\n", markNames[ii],
+					(unsigned long)bootTimes.atMs[ii],
+					(unsigned long)bootDeadline((boot_mark_t)ii),
+					(bootTimes.overBudget & (1UL << ii)) ? ", OVER BUDGET" : "");
+		}
+	}
+}
+/* EOF */
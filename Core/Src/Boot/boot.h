@@ -0,0 +1,70 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file boot.h
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief Definitions and prototypes for the startup milestones and budget
+ ******************************************************************************/
+// @formatter:off
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __BOOT_H
+#define __BOOT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx_hal.h"
+#include "main.h"
+
+/* Defines -------------------------------------------------------------------*/
+/**
+ * Budgets, in ms of HAL tick, which starts at HAL_Init(). Enumeration is
+ * mostly the host's time: it waits 100 ms after attach before the bus reset,
+ * and a typical host configures us 20 to 50 ms after that.
+ */
+#define bootBUDGET_CLOCKS_MS		( 2 )
+#define bootBUDGET_USB_MS			( 5 )	/* Pull-up on, the host can see us */
+#define bootBUDGET_FRAME_MS			( 20 )	/* First full matrix frame */
+#define bootBUDGET_CONFIGURED_MS	( 200 )
+/**
+ * First report out, after the later of the first key edge and configuration.
+ * A combo key waits out its window (40 ms) before it reports anything.
+ */
+#define bootBUDGET_REPORT_MS		( 50 )
+
+/* Structures ----------------------------------------------------------------*/
+typedef enum
+{
+	bootMARK_CLOCKS = 0,	/* SystemClock_Config() done */
+	bootMARK_USB_STARTED,	/* MX_USB_DEVICE_Init() done, pull-up on */
+	bootMARK_FIRST_FRAME,	/* Scan task finished its first frame */
+	bootMARK_CONFIGURED,	/* Host set a configuration */
+	bootMARK_FIRST_EDGE,	/* First debounced key edge */
+	bootMARK_FIRST_REPORT,	/* First report delivered after that edge */
+	bootMARKS
+} boot_mark_t;
+
+typedef struct _BOOT_TIMES_S_
+{
+	uint32_t seen;			/* Bit per boot_mark_t reached */
+	uint32_t overBudget;	/* Bit per boot_mark_t reached later than budgeted */
+	uint32_t atMs[bootMARKS];	/* HAL tick each mark was reached at */
+} boot_times_t;
+
+/* Prototypes ----------------------------------------------------------------*/
+void bootMark(boot_mark_t mark);
+_Bool bootReached(boot_mark_t mark);
+void bootLog(void);
+
+/* Exported variables --------------------------------------------------------*/
+extern boot_times_t bootTimes;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BOOT_H */
+/* EOF */
@@ -0,0 +1,351 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file indicator.c
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief Lock and status LEDs, run by the timers with no help from the CPU
+ ******************************************************************************/
+// @formatter:off
+
+/* Includes ------------------------------------------------------------------*/
+#include "indicator.h"
+
+#include "main.h"
+
+/**
+ * Each pattern is set up once and then left to the hardware; nothing wakes
+ * the core to keep an LED going, so tickless idle is not cut short by it.
+ *
+ *   LD0  PB1   TIM1_CH3N  blink and blip as PWM over the whole period; the
+ *                         breath is a 1 kHz PWM whose duty DMA2 stream 5
+ *                         steps through a table on every repetition update
+ *   LD1  PB2   none       PB2 has no timer channel, so on or off only
+ *   LD2  PB10  TIM2_CH3   blink and blip; no repetition counter to pace a
+ *                         breath with, so it blinks instead
+ *
+ * The pins are set up as outputs by MX_GPIO_Init() and handed to the timers
+ * here. While the host has not configured us LD0 breathes; after that the
+ * LEDs follow the lock state of the host's output reports.
+ *
+ * The .ioc has TIM1 and TIM2 on these pins so CubeMX keeps them free, but
+ * not the breath DMA: hdmaBreath runs without an interrupt and nothing
+ * generated may link its own handle into htim1.
+ */
+
+/* Defines -------------------------------------------------------------------*/
+#define BLINK_TICK_HZ		( 10000 )	/* Counter clock for blink and blip */
+#define BLIP_MS				( 50 )
+#define BREATH_TICK_HZ		( 1000000 )	/* Counter clock for the breath */
+#define BREATH_PWM_TICKS	( 1000 )	/* 1 kHz, well above any flicker */
+#define BREATH_PEAK			( indicatorBREATH_STEPS / 2 - 1 )
+#define BREATH_LED			( indicatorLD0 )	/* Only TIM1 can pace the DMA */
+
+/* Private variables ---------------------------------------------------------*/
+static TIM_HandleTypeDef htim1;
+static TIM_HandleTypeDef htim2;
+static DMA_HandleTypeDef hdmaBreath;
+
+static TIM_HandleTypeDef *const timers[indicatorLEDS] = { &htim1, NULL, &htim2 };
+static uint32_t timerHz[indicatorLEDS];
+static indicator_mode_t modes[indicatorLEDS];
+static uint16_t periods[indicatorLEDS];
+static uint16_t breath[indicatorBREATH_STEPS];	/* Read by DMA, keep in SRAM */
+
+static _Bool hostConfigured;
+static uint8_t hostLocks;
+
+/* Static prototypes ---------------------------------------------------------*/
+static uint32_t indicatorTimerClock(TIM_TypeDef *tim);
+static void indicatorProgram(indicator_led_t led, uint32_t tickHz, uint32_t ticks,
+		uint32_t onTicks, uint8_t repeat);
+static void indicatorShow(void);
+
+/* Code ----------------------------------------------------------------------*/
+/**
+ * @brief Works out a timer's counter clock
+ * @param tim Timer
+ * @retval Clock in Hz: APB timers run at twice PCLK unless the APB is undivided
+ */
+static uint32_t indicatorTimerClock(TIM_TypeDef *tim)
+{
+	RCC_ClkInitTypeDef clk;
+	uint32_t latency;
+	uint32_t pclk;
+	uint32_t divider;
+
+	HAL_RCC_GetClockConfig(&clk, &latency);
+	if (tim == TIM1)
+	{
+		pclk = HAL_RCC_GetPCLK2Freq();
+		divider = clk.APB2CLKDivider;
+	}
+	else
+	{
+		pclk = HAL_RCC_GetPCLK1Freq();
+		divider = clk.APB1CLKDivider;
+	}
+	return (divider == RCC_HCLK_DIV1) ? pclk : 2U * pclk;
+}
+
+/**
+ * @brief Reloads an LED's timer with a new period and duty
+ * @note The update event restarts the period, so the new pattern starts
+ *       with its on phase rather than wherever the old one had got to.
+ * @param led A timer driven LED
+ * @param tickHz Counter clock
+ * @param ticks Counts per period
+ * @param onTicks Counts per period the LED is lit, ticks or more for always
+ * @param repeat Periods per update event, less one, where the timer has a
+ *        repetition counter
+ * @retval none
+ */
+static void indicatorProgram(indicator_led_t led, uint32_t tickHz, uint32_t ticks,
+		uint32_t onTicks, uint8_t repeat)
+{
+	TIM_TypeDef *tim = timers[led]->Instance;
+
+	tim->PSC = timerHz[led] / tickHz - 1U;
+	tim->ARR = ticks - 1U;
+	tim->CCR3 = onTicks;
+	if (IS_TIM_REPETITION_COUNTER_INSTANCE(tim))
+	{
+		tim->RCR = repeat;
+	}
+	tim->EGR = TIM_EGR_UG;
+}
+
+/**
+ * @brief Shows the host's state on the LEDs
+ * @param none
+ * @retval none
+ */
+static void indicatorShow(void)
+{
+	if (!hostConfigured)
+	{
+		indicatorSet(indicatorLD0, indicatorBREATHE, indicatorBREATHE_MS);
+		indicatorSet(indicatorLD1, indicatorOFF, 0);
+		indicatorSet(indicatorLD2, indicatorOFF, 0);
+		return;
+	}
+	indicatorSet(indicatorLD0, (hostLocks & indicatorLOCK_NUM) ? indicatorON
+			: indicatorOFF, 0);
+	indicatorSet(indicatorLD1, (hostLocks & indicatorLOCK_CAPS) ? indicatorON
+			: indicatorOFF, 0);
+	indicatorSet(indicatorLD2, (hostLocks & indicatorLOCK_SCROLL) ? indicatorON
+			: indicatorOFF, 0);
+}
+
+/**
+ * @brief Starts a pattern on an LED
+ * @note Call from the USB interrupt, or before the scheduler starts; the host
+ *       state changes that end up here come from there. A pattern an LED's
+ *       hardware can't run falls back to the nearest one it can: a breath
+ *       on LD2 blinks, and LD1 is simply on. Setting the pattern already
+ *       running leaves it alone rather than restarting it.
+ * @param led LED
+ * @param mode Pattern
+ * @param periodMs Blink, blip or breath period, 0 for the default
+ * @retval none
+ */
+void indicatorSet(indicator_led_t led, indicator_mode_t mode, uint16_t periodMs)
+{
+	TIM_HandleTypeDef *htim = timers[led];
+	uint32_t ticks;
+
+	if (htim == NULL)
+	{
+		mode = (mode == indicatorOFF) ? indicatorOFF : indicatorON;
+	}
+	else if (mode == indicatorBREATHE && led != BREATH_LED)
+	{
+		mode = indicatorBLINK;
+	}
+	if (periodMs == 0)
+	{
+		periodMs = (mode == indicatorBREATHE) ? indicatorBREATHE_MS : indicatorBLINK_MS;
+	}
+	if (periodMs > indicatorMAX_PERIOD_MS)
+	{
+		periodMs = indicatorMAX_PERIOD_MS;
+	}
+	if (mode == modes[led] && periodMs == periods[led])
+	{
+		return;
+	}
+
+	if (htim == NULL)
+	{
+		HAL_GPIO_WritePin(LD1_GPIO_Port, LD1_Pin,
+				(mode == indicatorON) ? GPIO_PIN_SET : GPIO_PIN_RESET);
+	}
+	else
+	{
+		if (modes[led] == indicatorBREATHE)
+		{
+			__HAL_TIM_DISABLE_DMA(htim, TIM_DMA_UPDATE);
+			HAL_DMA_Abort(&hdmaBreath);
+		}
+		ticks = (uint32_t)periodMs * (BLINK_TICK_HZ / 1000U);
+		switch (mode)
+		{
+		case indicatorON:
+			indicatorProgram(led, BLINK_TICK_HZ, ticks, ticks, 0);
+			break;
+		case indicatorBLINK:
+			indicatorProgram(led, BLINK_TICK_HZ, ticks, ticks / 2U, 0);
+			break;
+		case indicatorBLIP:
+			indicatorProgram(led, BLINK_TICK_HZ, ticks,
+					(periodMs > 2U * BLIP_MS) ? BLIP_MS * (BLINK_TICK_HZ / 1000U)
+					: ticks / 2U, 0);
+			break;
+		case indicatorBREATHE:
+			/* One table step per repeat + 1 PWM periods of 1 ms */
+			ticks = periodMs / indicatorBREATH_STEPS;
+			indicatorProgram(led, BREATH_TICK_HZ, BREATH_PWM_TICKS, breath[0],
+					(ticks > 256U) ? 255U : (ticks == 0U) ? 0U : (uint8_t)(ticks - 1U));
+			HAL_DMA_Start(&hdmaBreath, (uint32_t)breath,
+					(uint32_t)&htim->Instance->CCR3, indicatorBREATH_STEPS);
+			__HAL_TIM_ENABLE_DMA(htim, TIM_DMA_UPDATE);
+			break;
+		case indicatorOFF:
+		default:
+			indicatorProgram(led, BLINK_TICK_HZ, ticks, 0, 0);
+			break;
+		}
+	}
+	modes[led] = mode;
+	periods[led] = periodMs;
+}
+
+/**
+ * @brief Tells which pattern an LED is running
+ * @param led LED
+ * @retval Pattern, after any fallback indicatorSet() made
+ */
+indicator_mode_t indicatorGet(indicator_led_t led)
+{
+	return modes[led];
+}
+
+/**
+ * @brief Shows the lock state from the host's keyboard output report
+ * @note Runs in the USB interrupt.
+ * @param locks indicatorLOCK_x bits
+ * @retval none
+ */
+void indicatorSetLocks(uint8_t locks)
+{
+	hostLocks = locks;
+	indicatorShow();
+}
+
+/**
+ * @brief Switches between the waiting pattern and the lock LEDs
+ * @note Runs in the USB interrupt. The host sends the locks again after it
+ *       configures us, so they are forgotten here when it lets go.
+ * @param configured 1 once the host has set a configuration
+ * @retval none
+ */
+void indicatorSetHost(_Bool configured)
+{
+	hostConfigured = configured;
+	if (!configured)
+	{
+		hostLocks = 0;
+	}
+	indicatorShow();
+}
+
+/**
+ * @brief Hands LD0 and LD2 to their timers and shows the waiting pattern
+ * @note Call after MX_GPIO_Init(), before the USB device starts.
+ * @param none
+ * @retval none
+ */
+void indicatorInit(void)
+{
+	GPIO_InitTypeDef gpio = {0};
+	TIM_OC_InitTypeDef oc = {0};
+	uint32_t level;
+
+	/* Squared, so the fade looks even to the eye rather than to the meter */
+	for (uint32_t ii = 0; ii < indicatorBREATH_STEPS; ii++)
+	{
+		level = (ii <= BREATH_PEAK) ? ii : indicatorBREATH_STEPS - 1U - ii;
+		breath[ii] = (uint16_t)(level * level * BREATH_PWM_TICKS
+				/ (BREATH_PEAK * BREATH_PEAK));
+	}
+
+	__HAL_RCC_TIM1_CLK_ENABLE();
+	__HAL_RCC_TIM2_CLK_ENABLE();
+	__HAL_RCC_DMA2_CLK_ENABLE();
+	htim1.Instance = TIM1;
+	htim2.Instance = TIM2;
+
+	oc.OCMode = TIM_OCMODE_PWM1;
+	oc.Pulse = 0;
+	oc.OCPolarity = TIM_OCPOLARITY_HIGH;
+	oc.OCNPolarity = TIM_OCNPOLARITY_HIGH;
+	oc.OCFastMode = TIM_OCFAST_DISABLE;
+	oc.OCIdleState = TIM_OCIDLESTATE_RESET;
+	oc.OCNIdleState = TIM_OCNIDLESTATE_RESET;
+	for (uint32_t led = 0; led < indicatorLEDS; led++)
+	{
+		if (timers[led] == NULL)
+		{
+			continue;
+		}
+		timerHz[led] = indicatorTimerClock(timers[led]->Instance);
+		timers[led]->Init.Prescaler = timerHz[led] / BLINK_TICK_HZ - 1U;
+		timers[led]->Init.CounterMode = TIM_COUNTERMODE_UP;
+		timers[led]->Init.Period = indicatorBLINK_MS * (BLINK_TICK_HZ / 1000U) - 1U;
+		timers[led]->Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+		timers[led]->Init.RepetitionCounter = 0;
+		/* Preloaded, so a new duty or period takes effect on a period boundary */
+		timers[led]->Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_ENABLE;
+		if (HAL_TIM_PWM_Init(timers[led]) != HAL_OK
+				|| HAL_TIM_PWM_ConfigChannel(timers[led], &oc, TIM_CHANNEL_3) != HAL_OK)
+		{
+			Error_Handler();
+		}
+		periods[led] = indicatorBLINK_MS;
+	}
+	/* Complementary output alone: OC3N follows OC3REF, CC3NP picks polarity */
+	if (HAL_TIMEx_PWMN_Start(&htim1, TIM_CHANNEL_3) != HAL_OK
+			|| HAL_TIM_PWM_Start(&htim2, TIM_CHANNEL_3) != HAL_OK)
+	{
+		Error_Handler();
+	}
+
+	/* TIM1_UP is DMA2 stream 5 channel 6 */
+	hdmaBreath.Instance = DMA2_Stream5;
+	hdmaBreath.Init.Channel = DMA_CHANNEL_6;
+	hdmaBreath.Init.Direction = DMA_MEMORY_TO_PERIPH;
+	hdmaBreath.Init.PeriphInc = DMA_PINC_DISABLE;
+	hdmaBreath.Init.MemInc = DMA_MINC_ENABLE;
+	hdmaBreath.Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
+	hdmaBreath.Init.MemDataAlignment = DMA_MDATAALIGN_HALFWORD;
+	hdmaBreath.Init.Mode = DMA_CIRCULAR;
+	hdmaBreath.Init.Priority = DMA_PRIORITY_LOW;
+	hdmaBreath.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+	if (HAL_DMA_Init(&hdmaBreath) != HAL_OK)
+	{
+		Error_Handler();
+	}
+
+	/* The timers now hold the pins low, as MX_GPIO_Init() left them */
+	gpio.Mode = GPIO_MODE_AF_PP;
+	gpio.Pull = GPIO_NOPULL;
+	gpio.Speed = GPIO_SPEED_FREQ_LOW;
+	gpio.Pin = LD0_Pin;
+	gpio.Alternate = GPIO_AF1_TIM1;
+	HAL_GPIO_Init(LD0_GPIO_Port, &gpio);
+	gpio.Pin = LD2_Pin;
+	gpio.Alternate = GPIO_AF1_TIM2;
+	HAL_GPIO_Init(LD2_GPIO_Port, &gpio);
+
+	indicatorSetHost(0);
+}
+/* EOF */
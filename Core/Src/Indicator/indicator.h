@@ -0,0 +1,66 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file indicator.h
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief Definitions and prototypes for the timer driven indicator LEDs
+ ******************************************************************************/
+// @formatter:off
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __INDICATOR_H
+#define __INDICATOR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx_hal.h"
+#include "main.h"
+
+/* Defines -------------------------------------------------------------------*/
+#define indicatorBLINK_MS			( 1000 )	/* Default blink period */
+#define indicatorBREATHE_MS			( 3000 )	/* Default breath, in to in */
+#define indicatorMAX_PERIOD_MS		( 6500 )	/* Longest blink the timers can count */
+#define indicatorBREATH_STEPS		( 128 )		/* Brightness steps per breath */
+
+/* Lock LED bits of the keyboard output report, HID usage page 0x08 */
+#define indicatorLOCK_NUM			( 1U << 0 )
+#define indicatorLOCK_CAPS			( 1U << 1 )
+#define indicatorLOCK_SCROLL		( 1U << 2 )
+
+/* Structures ----------------------------------------------------------------*/
+/* In the order of the Model M's LED board */
+typedef enum
+{
+	indicatorLD0 = 0,		/* Num Lock, PB1, TIM1_CH3N */
+	indicatorLD1,			/* Caps Lock, PB2, GPIO only */
+	indicatorLD2,			/* Scroll Lock, PB10, TIM2_CH3 */
+	indicatorLEDS
+} indicator_led_t;
+
+typedef enum
+{
+	indicatorOFF = 0,
+	indicatorON,
+	indicatorBLINK,			/* Half the period on, half off */
+	indicatorBLIP,			/* A short flash once a period */
+	indicatorBREATHE		/* Fades in and out over the period */
+} indicator_mode_t;
+
+/* Prototypes ----------------------------------------------------------------*/
+void indicatorInit(void);
+void indicatorSet(indicator_led_t led, indicator_mode_t mode, uint16_t periodMs);
+indicator_mode_t indicatorGet(indicator_led_t led);
+void indicatorSetLocks(uint8_t locks);
+void indicatorSetHost(_Bool configured);
+
+/* Exported variables --------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __INDICATOR_H */
+/* EOF */
@@ -0,0 +1,428 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file combo.c
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief Combo matching by bitmask containment, indexed per key
+ ******************************************************************************/
+// @formatter:off
+
+/* Includes ------------------------------------------------------------------*/
+#include "combo.h"
+
+#include "keymap.h"
+#include "../Settings/settings.h"
+
+#include <string.h>
+
+/**
+ * Like taphold.c, this only sees key indices and times, so it runs the same
+ * on a host.
+ *
+ * Each combo is compiled into a bitmap over the whole matrix. Keys that start
+ * or extend a combo are held back while some combo still contains every held
+ * key. Every candidate contains the key just pressed, so only the combos in
+ * that key's index are tested and the cost does not grow with the table.
+ *
+ * The stock firmware has no combos. They come from the settingsKEY_COMBOS
+ * record, read once at boot.
+ */
+
+/* Defines -------------------------------------------------------------------*/
+#define BIT(m, k)			( ((m)[(k) >> 5] >> ((k) & 31)) & 1UL )
+#define SET(m, k)			( (m)[(k) >> 5] |= 1UL << ((k) & 31) )
+#define CLR(m, k)			( (m)[(k) >> 5] &= ~(1UL << ((k) & 31)) )
+#define NO_COMBO			( 0xFFFF )
+
+/* Private variables ---------------------------------------------------------*/
+static combo_def_t comboTable[comboMAX_COMBOS];
+static uint8_t comboCount;
+
+/* Compiled at init */
+static uint32_t masks[comboMAX_COMBOS][comboWORDS];
+static uint16_t indexStart[keyboardNUM_KEYS + 1];	/* Into indexList, per key */
+static uint16_t indexList[comboMAX_COMBOS * comboMAX_KEYS];
+
+static combo_ops_t ops;
+
+/* Member presses held back, always a subset of some combo */
+static struct
+{
+	uint16_t key;
+	uint32_t timeMs;
+} held[comboMAX_KEYS];
+static uint8_t heldCount;
+static uint32_t heldMask[comboWORDS];
+static uint32_t heldDeadline;
+
+/* Combos that fired and still have keys down */
+static struct
+{
+	uint16_t owner;			/* Key the action was pressed as */
+	uint16_t combo;
+	_Bool released;
+} active[comboMAX_ACTIVE];
+static uint32_t consumed[comboWORDS];
+
+/* Static prototypes ---------------------------------------------------------*/
+static _Bool comboSubset(const uint32_t *a, const uint32_t *b);
+static void comboFlush(void);
+static void comboFire(uint16_t combo, uint32_t nowMs);
+static void comboPress(uint16_t key, uint32_t nowMs);
+static void comboRelease(uint16_t key, uint32_t nowMs);
+static uint16_t comboExact(void);
+static void comboLoad(void);
+
+/* Code ----------------------------------------------------------------------*/
+/**
+ * @brief Bitmask containment
+ * @param a Candidate subset
+ * @param b Candidate superset
+ * @retval 1 if every bit of a is set in b
+ */
+static _Bool comboSubset(const uint32_t *a, const uint32_t *b)
+{
+	uint32_t stray = 0;
+
+	for (int ww = 0; ww < comboWORDS; ww++)
+	{
+		stray |= a[ww] & ~b[ww];
+	}
+	return stray == 0;
+}
+
+/**
+ * @brief Lets the held back presses through as ordinary keys, in order
+ * @param none
+ * @retval none
+ */
+static void comboFlush(void)
+{
+	uint8_t count = heldCount;
+
+	heldCount = 0;
+	memset(heldMask, 0, sizeof(heldMask));
+	for (int ii = 0; ii < count; ii++)
+	{
+		ops.emit(held[ii].key, 1, keymapTRNS, held[ii].timeMs);
+	}
+}
+
+/**
+ * @brief Sends a combo's action in place of the held keys
+ * @param combo Index into comboTable
+ * @param nowMs Time of the decision
+ * @retval none
+ */
+static void comboFire(uint16_t combo, uint32_t nowMs)
+{
+	int slot;
+
+	for (slot = 0; slot < comboMAX_ACTIVE; slot++)
+	{
+		if (active[slot].combo == NO_COMBO)
+		{
+			break;
+		}
+	}
+	if (slot == comboMAX_ACTIVE)
+	{
+		comboFlush();
+		return;
+	}
+	active[slot].owner = held[0].key;
+	active[slot].combo = combo;
+	active[slot].released = 0;
+	for (int ww = 0; ww < comboWORDS; ww++)
+	{
+		consumed[ww] |= heldMask[ww];
+	}
+	heldCount = 0;
+	memset(heldMask, 0, sizeof(heldMask));
+	ops.emit(active[slot].owner, 1, comboTable[combo].action, nowMs);
+}
+
+/**
+ * @brief Finds the combo made of exactly the held keys
+ * @param none
+ * @retval Index into comboTable, or NO_COMBO
+ */
+static uint16_t comboExact(void)
+{
+	uint16_t key = held[0].key;
+
+	for (int ii = indexStart[key]; ii < indexStart[key + 1]; ii++)
+	{
+		uint16_t cc = indexList[ii];
+
+		if (comboSubset(masks[cc], heldMask) && comboSubset(heldMask, masks[cc]))
+		{
+			return cc;
+		}
+	}
+	return NO_COMBO;
+}
+
+/**
+ * @brief Handles a press
+ * @param key Index of the key in the matrix
+ * @param nowMs Time of the press
+ * @retval none
+ */
+static void comboPress(uint16_t key, uint32_t nowMs)
+{
+	uint16_t exact = NO_COMBO;
+	_Bool larger = 0;
+	uint8_t window = 0;
+
+	if (indexStart[key] == indexStart[key + 1])
+	{
+		/* Not in any combo: whatever is held cannot complete any more */
+		comboFlush();
+		ops.emit(key, 1, keymapTRNS, nowMs);
+		return;
+	}
+
+	held[heldCount].key = key;
+	held[heldCount].timeMs = nowMs;
+	heldCount++;
+	SET(heldMask, key);
+	for (int ii = indexStart[key]; ii < indexStart[key + 1]; ii++)
+	{
+		uint16_t cc = indexList[ii];
+
+		if (!comboSubset(heldMask, masks[cc]))
+		{
+			continue;
+		}
+		if (comboSubset(masks[cc], heldMask))
+		{
+			exact = cc;
+		}
+		else
+		{
+			larger = 1;
+		}
+		if (comboTable[cc].windowMs > window)
+		{
+			window = comboTable[cc].windowMs;
+		}
+	}
+
+	if (exact == NO_COMBO && !larger)
+	{
+		/* No combo has all of these, start over from this key alone */
+		heldCount--;
+		CLR(heldMask, key);
+		comboFlush();
+		comboPress(key, nowMs);
+		return;
+	}
+	if (exact != NO_COMBO && !larger)
+	{
+		comboFire(exact, nowMs);
+		return;
+	}
+	heldDeadline = held[0].timeMs + window;
+}
+
+/**
+ * @brief Handles a release
+ * @param key Index of the key in the matrix
+ * @param nowMs Time of the release
+ * @retval none
+ */
+static void comboRelease(uint16_t key, uint32_t nowMs)
+{
+	if (BIT(heldMask, key))
+	{
+		uint16_t exact = comboExact();
+
+		if (exact == NO_COMBO)
+		{
+			/* Let go before any combo completed, so it was typed on its own */
+			comboFlush();
+			ops.emit(key, 0, keymapTRNS, nowMs);
+			return;
+		}
+		/* Held back for a larger combo, but what is down is one too */
+		comboFire(exact, nowMs);
+	}
+	if (!BIT(consumed, key))
+	{
+		ops.emit(key, 0, keymapTRNS, nowMs);
+		return;
+	}
+
+	/* The first member up releases the action, the rest are swallowed */
+	CLR(consumed, key);
+	for (int slot = 0; slot < comboMAX_ACTIVE; slot++)
+	{
+		uint16_t cc = active[slot].combo;
+		uint32_t left = 0;
+
+		if (cc == NO_COMBO || !BIT(masks[cc], key))
+		{
+			continue;
+		}
+		if (!active[slot].released)
+		{
+			active[slot].released = 1;
+			ops.emit(active[slot].owner, 0, keymapTRNS, nowMs);
+		}
+		for (int ww = 0; ww < comboWORDS; ww++)
+		{
+			left |= masks[cc][ww] & consumed[ww];
+		}
+		if (left == 0)
+		{
+			active[slot].combo = NO_COMBO;
+		}
+		break;
+	}
+}
+
+/**
+ * @brief Feeds a debounced key edge into the combo matcher
+ * @note Keys that belong to no combo pass straight through. Member keys wait
+ *       at most their combos' window, or until released.
+ * @param key Index of the key in the matrix
+ * @param pressed 1 on press, 0 on release
+ * @param nowMs Time of the edge
+ * @retval none
+ */
+void comboEvent(uint16_t key, _Bool pressed, uint32_t nowMs)
+{
+	comboTick(nowMs);
+	if (pressed)
+	{
+		comboPress(key, nowMs);
+	}
+	else
+	{
+		comboRelease(key, nowMs);
+	}
+}
+
+/**
+ * @brief Gives up on held keys whose window has passed
+ * @note Call regularly from the scan task while comboPending() is true.
+ * @param nowMs Current time
+ * @retval none
+ */
+void comboTick(uint32_t nowMs)
+{
+	uint16_t exact;
+
+	if (heldCount == 0 || (int32_t)(nowMs - heldDeadline) <= 0)
+	{
+		return;
+	}
+	exact = comboExact();
+	if (exact != NO_COMBO)
+	{
+		comboFire(exact, nowMs);
+	}
+	else
+	{
+		comboFlush();
+	}
+}
+
+/**
+ * @brief Tells whether presses are being held back
+ * @param none
+ * @retval 1 if comboTick() has work to do
+ */
+_Bool comboPending(void)
+{
+	return heldCount != 0;
+}
+
+/**
+ * @brief Copies the stored combos into comboTable
+ * @note Entries that could never match are dropped, the rest keep their
+ *       order. A record of the wrong size is from some other firmware.
+ * @param none
+ * @retval none
+ */
+static void comboLoad(void)
+{
+	uint16_t length = 0;
+	const combo_def_t *saved = settingsGet(settingsKEY_COMBOS, &length);
+
+	comboCount = 0;
+	if (saved == NULL || length % sizeof(combo_def_t) != 0
+			|| length > sizeof(comboTable))
+	{
+		return;
+	}
+	for (int cc = 0; cc < length / sizeof(combo_def_t); cc++)
+	{
+		_Bool valid = saved[cc].count >= 2 && saved[cc].count <= comboMAX_KEYS;
+
+		for (int ii = 0; valid && ii < saved[cc].count; ii++)
+		{
+			valid = saved[cc].keys[ii] < keyboardNUM_KEYS;
+			for (int jj = 0; valid && jj < ii; jj++)
+			{
+				valid = saved[cc].keys[jj] != saved[cc].keys[ii];
+			}
+		}
+		if (valid)
+		{
+			comboTable[comboCount] = saved[cc];
+			if (comboTable[comboCount].windowMs == 0)
+			{
+				comboTable[comboCount].windowMs = comboDEFAULT_WINDOW_MS;
+			}
+			comboCount++;
+		}
+	}
+}
+
+/**
+ * @brief Loads the combo table and compiles it into bitmaps and the per-key
+ *        index
+ * @note Must run after settingsInit().
+ * @param callbacks Event output, copied
+ * @retval none
+ */
+void comboInit(const combo_ops_t *callbacks)
+{
+	uint16_t fill[keyboardNUM_KEYS];
+
+	ops = *callbacks;
+	comboLoad();
+	memset(masks, 0, sizeof(masks));
+	memset(indexStart, 0, sizeof(indexStart));
+	for (int cc = 0; cc < comboCount; cc++)
+	{
+		for (int ii = 0; ii < comboTable[cc].count; ii++)
+		{
+			SET(masks[cc], comboTable[cc].keys[ii]);
+			indexStart[comboTable[cc].keys[ii] + 1]++;
+		}
+	}
+	for (int kk = 0; kk < keyboardNUM_KEYS; kk++)
+	{
+		indexStart[kk + 1] += indexStart[kk];
+		fill[kk] = indexStart[kk];
+	}
+	for (int cc = 0; cc < comboCount; cc++)
+	{
+		for (int ii = 0; ii < comboTable[cc].count; ii++)
+		{
+			indexList[fill[comboTable[cc].keys[ii]]++] = cc;
+		}
+	}
+
+	heldCount = 0;
+	memset(heldMask, 0, sizeof(heldMask));
+	memset(consumed, 0, sizeof(consumed));
+	for (int slot = 0; slot < comboMAX_ACTIVE; slot++)
+	{
+		active[slot].combo = NO_COMBO;
+	}
+}
+/* EOF */
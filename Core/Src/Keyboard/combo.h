@@ -0,0 +1,61 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file combo.h
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief Definitions and prototypes for key combos (chords)
+ ******************************************************************************/
+// @formatter:off
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __COMBO_H
+#define __COMBO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include "keyboard.h"
+
+/* Defines -------------------------------------------------------------------*/
+#define comboMAX_KEYS				( 4 )	/* Keys in one combo */
+#define comboMAX_ACTIVE				( 4 )	/* Combos held down at once */
+#define comboMAX_COMBOS				( 16 )	/* Entries of settingsKEY_COMBOS */
+#define comboWORDS					( (keyboardNUM_KEYS + 31) / 32 )
+#define comboDEFAULT_WINDOW_MS		( 40 )
+
+/* Structures ----------------------------------------------------------------*/
+/* One entry of the settingsKEY_COMBOS record, which is an array of these */
+typedef struct _COMBO_DEF_S_
+{
+	uint8_t keys[comboMAX_KEYS];	/* Matrix indices, count of them used */
+	uint8_t count;
+	uint8_t windowMs;		/* All keys must go down within this, 0 for the default */
+	uint16_t action;		/* Keymap action sent instead of the keys */
+} combo_def_t;
+
+/**
+ * Events leave through emit(). override is keymapTRNS for a key passed
+ * through untouched, or the combo's action, sent as the first member key.
+ */
+typedef struct _COMBO_OPS_S_
+{
+	void (*emit)(uint16_t key, _Bool pressed, uint16_t override, uint32_t timeMs);
+} combo_ops_t;
+
+/* Prototypes ----------------------------------------------------------------*/
+void comboInit(const combo_ops_t *callbacks);
+void comboEvent(uint16_t key, _Bool pressed, uint32_t nowMs);
+void comboTick(uint32_t nowMs);
+_Bool comboPending(void);
+
+/* Exported variables --------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __COMBO_H */
+/* EOF */
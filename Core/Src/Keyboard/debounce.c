@@ -0,0 +1,190 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file debounce.c
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief Per-key debounce times learned from each switch's own chatter
+ ******************************************************************************/
+// @formatter:off
+
+/* Includes ------------------------------------------------------------------*/
+#include "debounce.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "main.h"
+#include "../Settings/settings.h"
+
+#include <string.h>
+
+/**
+ * One debounce time for the whole board means the worst switch sets the
+ * latency of every other one. Here each key gets its own, learned:
+ *  - a change the debounce throws away (health.c calls it chatter) shows
+ *    the key needs longer, so it goes up debounceRAISE_LEVELS at once;
+ *  - so does a press shorter than the ceiling, which the old global time
+ *    would have filtered and which is more likely ringing than typing;
+ *  - debounceCLEAN_PRESSES presses in a row without either earn a level
+ *    down, never below debounceFLOOR_MS.
+ * Up is fast and down is slow, so a switch starting to fail is caught within
+ * a press or two. The levels are saved through the settings log now and then.
+ */
+
+/* Defines -------------------------------------------------------------------*/
+#define LEVEL_MAX			( debounceLEVELS - 1 )
+
+/* Private variables ---------------------------------------------------------*/
+static uint8_t levels[debounceMAP_BYTES];		/* Two keys a byte, low nibble first */
+static uint8_t cleanPresses[keyboardNUM_KEYS];
+static uint16_t windowMs[debounceLEVELS];
+static uint16_t ceiling;
+static _Bool dirty;
+static uint32_t lastSaveMs;
+
+/* Static prototypes ---------------------------------------------------------*/
+static uint8_t debounceGetLevel(uint16_t key);
+static void debounceSetLevel(uint16_t key, uint8_t level);
+
+/* Code ----------------------------------------------------------------------*/
+/**
+ * @brief Reads a key's level
+ * @param key Key index, row major
+ * @retval Level, 0 to LEVEL_MAX
+ */
+static uint8_t debounceGetLevel(uint16_t key)
+{
+	return (levels[key >> 1] >> ((key & 1) * 4)) & 0x0F;
+}
+
+/**
+ * @brief Changes a key's level
+ * @param key Key index, row major
+ * @param level New level, 0 to LEVEL_MAX
+ * @retval none
+ */
+static void debounceSetLevel(uint16_t key, uint8_t level)
+{
+	uint8_t shift = (key & 1) * 4;
+
+	if (debounceGetLevel(key) != level)
+	{
+		levels[key >> 1] = (uint8_t)((levels[key >> 1] & ~(0x0F << shift))
+				| (level << shift));
+		dirty = 1;
+	}
+}
+
+/**
+ * @brief Debounce time for a key
+ * @note Called for every key in every frame, keep it cheap.
+ * @param key Key index, row major
+ * @retval Time in ms
+ */
+uint16_t debounceWindowMs(uint16_t key)
+{
+	return windowMs[debounceGetLevel(key)];
+}
+
+/**
+ * @brief A change on this key did not last the debounce time
+ * @param key Key index, row major
+ * @retval none
+ */
+void debounceChatter(uint16_t key)
+{
+	uint8_t level;
+
+	if (key >= keyboardNUM_KEYS)
+	{
+		return;
+	}
+	level = debounceGetLevel(key);
+	debounceSetLevel(key, (level + debounceRAISE_LEVELS < LEVEL_MAX)
+			? level + debounceRAISE_LEVELS : LEVEL_MAX);
+	cleanPresses[key] = 0;
+}
+
+/**
+ * @brief A debounced press on this key has ended
+ * @param key Key index, row major
+ * @param heldMs Time from press to release, both as first seen
+ * @retval none
+ */
+void debounceRelease(uint16_t key, uint32_t heldMs)
+{
+	uint8_t level;
+
+	if (key >= keyboardNUM_KEYS)
+	{
+		return;
+	}
+	if (heldMs <= ceiling)
+	{
+		debounceChatter(key);
+		return;
+	}
+	if (++cleanPresses[key] < debounceCLEAN_PRESSES)
+	{
+		return;
+	}
+	cleanPresses[key] = 0;
+	level = debounceGetLevel(key);
+	if (level > 0)
+	{
+		debounceSetLevel(key, level - 1);
+	}
+}
+
+/**
+ * @brief Saves the levels if they have changed, at most every debounceSAVE_MS
+ * @note Call from the scan task, once per frame. Only stages the write; the
+ *       settings task programs the flash.
+ * @param none
+ * @retval none
+ */
+void debouncePersist(void)
+{
+	uint32_t now = HAL_GetTick();
+
+	if (!dirty || now - lastSaveMs < debounceSAVE_MS)
+	{
+		return;
+	}
+	if (settingsWrite(settingsKEY_DEBOUNCE_MAP, levels, sizeof(levels)) == pdPASS)
+	{
+		dirty = 0;
+		lastSaveMs = now;
+	}
+}
+
+/**
+ * @brief Spreads the levels between the floor and the configured time and
+ *        loads the learned levels
+ * @note Must run after settingsInit().
+ * @param ceilingMs Configured debounce time, the longest any key gets
+ * @retval none
+ */
+void debounceInit(uint16_t ceilingMs)
+{
+	uint16_t length = 0;
+	const uint8_t *saved = settingsGet(settingsKEY_DEBOUNCE_MAP, &length);
+	uint16_t floorMs = (ceilingMs > debounceFLOOR_MS) ? debounceFLOOR_MS : ceilingMs;
+
+	ceiling = ceilingMs;
+	for (uint8_t ii = 0; ii < debounceLEVELS; ii++)
+	{
+		windowMs[ii] = floorMs + (uint16_t)((ceilingMs - floorMs) * ii / LEVEL_MAX);
+	}
+	if (saved != NULL && length == sizeof(levels))
+	{
+		memcpy(levels, saved, sizeof(levels));
+	}
+	else
+	{
+		memset(levels, 0xFF, sizeof(levels));
+	}
+	memset(cleanPresses, 0, sizeof(cleanPresses));
+	dirty = 0;
+	lastSaveMs = HAL_GetTick();
+}
+/* EOF */
@@ -0,0 +1,48 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file debounce.h
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief Definitions and prototypes for the learned per-key debounce times
+ ******************************************************************************/
+// @formatter:off
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __DEBOUNCE_H
+#define __DEBOUNCE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "keyboard.h"
+
+/* Defines -------------------------------------------------------------------*/
+/**
+ * Each key has a 4 bit level: 15 is the configured debounce time, the
+ * ceiling, and 0 is debounceFLOOR_MS, evenly spaced in between. Keys start
+ * at the ceiling and earn their way down.
+ */
+#define debounceLEVELS				( 16 )
+#define debounceFLOOR_MS			( 5 )	/* Longer than a clean switch bounces */
+#define debounceCLEAN_PRESSES		( 32 )	/* In a row to step a level down */
+#define debounceRAISE_LEVELS		( 4 )	/* Per chatter event */
+#define debounceSAVE_MS				( 10UL * 60UL * 1000UL )	/* At most this often */
+#define debounceMAP_BYTES			( (keyboardNUM_KEYS + 1) / 2 )
+
+/* Prototypes ----------------------------------------------------------------*/
+void debounceInit(uint16_t ceilingMs);
+uint16_t debounceWindowMs(uint16_t key);
+void debounceChatter(uint16_t key);
+void debounceRelease(uint16_t key, uint32_t heldMs);
+void debouncePersist(void);
+
+/* Exported variables --------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __DEBOUNCE_H */
+/* EOF */
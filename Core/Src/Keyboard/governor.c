@@ -0,0 +1,158 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file governor.c
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief Slows the matrix scan down while nobody is typing
+ ******************************************************************************/
+// @formatter:off
+
+/* Includes ------------------------------------------------------------------*/
+#include "governor.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "main.h"
+#include "keyboard.h"
+#include "../Trace/trace.h"
+#include "../UsbInterface/usb_if.h"
+
+/**
+ * The scan task asks after every frame how long to sleep before the next.
+ * For activeMs after the last activity that is keyboardFRAME_DELAY_MS; then
+ * each further stretch of idle, twice as long as the one before, steps one
+ * level slower, down to the last. The first frame that sees anything goes
+ * straight back to full rate, so only that first change pays for the slower
+ * scan, by at most its frame delay. Debounce and the edge clock run on the
+ * tick, not on frame counts, and don't mind the rate.
+ *
+ * Full rate follows the host: governorSCANS_PER_POLL frames to each of its
+ * polls is plenty, so a host polling every 8 ms gets a frame every 2 ms, and
+ * one polling every ms gets keyboardFRAME_DELAY_MS. The exception is a key
+ * in its debounce window, which always gets keyboardFRAME_DELAY_MS: the
+ * debounce decides on the reading at the end of the window, and a late
+ * reading can land in a bounce and throw away a real press.
+ *
+ * Longer sleeps between frames are what lets tickless idle save anything.
+ * Each change of level is a traceEVT_SCAN_RATE event; governorGetStats()
+ * has the time spent and wakes taken at each level.
+ */
+
+/* Private variables ---------------------------------------------------------*/
+static const uint8_t framePeriodMs[governorLEVELS] = {
+		keyboardFRAME_DELAY_MS, 2, 4, 8, 16
+};
+
+static governor_stats_t governorStats;
+static uint16_t activeMs;
+static uint8_t level;
+static uint32_t lastActiveMs;
+static uint32_t lastFrameMs;
+
+/* Static prototypes ---------------------------------------------------------*/
+static void governorSetLevel(uint8_t newLevel);
+
+/* Code ----------------------------------------------------------------------*/
+/**
+ * @brief Moves to a new level and records the change
+ * @param newLevel Level to move to
+ * @retval none
+ */
+static void governorSetLevel(uint8_t newLevel)
+{
+	level = newLevel;
+	taskENTER_CRITICAL();
+	governorStats.level = newLevel;
+	governorStats.transitions++;
+	taskEXIT_CRITICAL();
+	traceEvent(traceEVT_SCAN_RATE, newLevel, framePeriodMs[newLevel]);
+}
+
+/**
+ * @brief Accounts for a frame and picks the delay before the next
+ * @note Called by the scan task only.
+ * @param active 1 if the frame saw a change, a key down or a pending timer
+ * @param settling 1 if a key is in its debounce window
+ * @retval Time to sleep before the next frame, in ms
+ */
+uint32_t governorFrame(_Bool active, _Bool settling)
+{
+	uint32_t now = HAL_GetTick();
+	uint32_t idleMs;
+	uint32_t floorMs = settling ? 0 : usbifPollMs() / governorSCANS_PER_POLL;
+	uint8_t target = 0;
+
+	taskENTER_CRITICAL();
+	governorStats.msAt[level] += now - lastFrameMs;
+	taskEXIT_CRITICAL();
+	lastFrameMs = now;
+
+	if (active)
+	{
+		lastActiveMs = now;
+		if (level != 0)
+		{
+			taskENTER_CRITICAL();
+			governorStats.wakes[level]++;
+			taskEXIT_CRITICAL();
+			governorSetLevel(0);
+		}
+	}
+	else if (activeMs != 0)
+	{
+		idleMs = now - lastActiveMs;
+		while (target + 1 < governorLEVELS
+				&& idleMs >= ((uint32_t)activeMs << target))
+		{
+			target++;
+		}
+		if (target > level)
+		{
+			governorSetLevel(target);
+		}
+	}
+	return (framePeriodMs[level] > floorMs) ? framePeriodMs[level] : floorMs;
+}
+
+/**
+ * @brief Copies the residency counters
+ * @param stats Destination for the counters
+ * @retval none
+ */
+void governorGetStats(governor_stats_t *stats)
+{
+	taskENTER_CRITICAL();
+	*stats = governorStats;
+	taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief Clears the residency counters and restarts the window
+ * @param none
+ * @retval none
+ */
+void governorClearStats(void)
+{
+	taskENTER_CRITICAL();
+	governorStats = (governor_stats_t) {
+		.level = level,
+				.activeMs = activeMs,
+				.since = HAL_GetTick()
+	};
+	taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief Starts at full rate
+ * @param activeWindowMs Full rate window after any activity, 0 to never slow down
+ * @retval none
+ */
+void governorInit(uint16_t activeWindowMs)
+{
+	activeMs = activeWindowMs;
+	level = 0;
+	lastActiveMs = HAL_GetTick();
+	lastFrameMs = lastActiveMs;
+	governorClearStats();
+}
+/* EOF */
@@ -0,0 +1,57 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file governor.h
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief Definitions and prototypes for the scan rate governor
+ ******************************************************************************/
+// @formatter:off
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __GOVERNOR_H
+#define __GOVERNOR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx_hal.h"
+#include "main.h"
+
+/* Defines -------------------------------------------------------------------*/
+#define governorLEVELS				( 5 )	/* Full rate, then slower and slower */
+#define governorDEFAULT_ACTIVE_MS	( 1000 )	/* Full rate after the last activity */
+#define governorSCANS_PER_POLL		( 4 )	/* Full rate frames per host poll */
+
+/* Structures ----------------------------------------------------------------*/
+/**
+ * Residency counters. Time at a level against the wakes from it is the
+ * trade: a wake from level n is a first keystroke seen up to that level's
+ * frame delay late.
+ */
+typedef struct _GOVERNOR_STATS_S_
+{
+	uint8_t level;			/* Current level, 0 is full rate */
+	uint8_t reserved;
+	uint16_t activeMs;		/* Full rate window, 0 if the governor is off */
+	uint32_t transitions;	/* Level changes, either way */
+	uint32_t msAt[governorLEVELS];	/* Time spent at each level */
+	uint32_t wakes[governorLEVELS];	/* Stretches at each level ended by activity */
+	uint32_t since;			/* HAL tick at which the counters were cleared */
+} governor_stats_t;
+
+/* Prototypes ----------------------------------------------------------------*/
+void governorInit(uint16_t activeWindowMs);
+uint32_t governorFrame(_Bool active, _Bool settling);
+void governorGetStats(governor_stats_t *stats);
+void governorClearStats(void);
+
+/* Exported variables --------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __GOVERNOR_H */
+/* EOF */
@@ -0,0 +1,207 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file health.c
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief Per-key press, chatter and press duration counters
+ ******************************************************************************/
+// @formatter:off
+
+/* Includes ------------------------------------------------------------------*/
+#include "health.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "main.h"
+
+#include <string.h>
+
+/**
+ * A membrane contact going bad shows up first as chatter: the scan sees the
+ * key change, and by the end of the debounce time it has changed back. The
+ * debounce throws those away and nobody notices until it starts missing or
+ * doubling keystrokes. Counting them per key, next to its presses and how
+ * long it is held, shows which switches are going and what debounce time the
+ * board really needs. Everything is fed from keyboardRefresh().
+ */
+
+/* Defines -------------------------------------------------------------------*/
+#define SATURATE16(x)		( (uint16_t)((x) < UINT16_MAX ? (x) + 1 : UINT16_MAX) )
+
+/* Global variables ---------------------------------------------------------*/
+health_counters_t healthCounters;
+
+/* Private variables ---------------------------------------------------------*/
+static uint32_t pressedAt[keyboardNUM_KEYS];	/* Edge time of the last press */
+static uint16_t readOffset;
+
+/* Static prototypes ---------------------------------------------------------*/
+static uint8_t healthBin(uint32_t heldMs);
+static void healthClear(void);
+
+/* Code ----------------------------------------------------------------------*/
+/**
+ * @brief Picks the duration bin for a press
+ * @param heldMs Time from press to release
+ * @retval Bin index
+ */
+static uint8_t healthBin(uint32_t heldMs)
+{
+	uint32_t log2;
+
+	if (heldMs >> healthBIN0_LOG2 == 0)
+	{
+		return 0;
+	}
+	log2 = 31U - (uint32_t)__builtin_clz(heldMs);
+	if (log2 - healthBIN0_LOG2 + 1U >= healthBINS)
+	{
+		return healthBINS - 1U;
+	}
+	return (uint8_t)(log2 - healthBIN0_LOG2 + 1U);
+}
+
+/**
+ * @brief Zeroes every counter
+ * @note Caller masks interrupts.
+ * @param none
+ * @retval none
+ */
+static void healthClear(void)
+{
+	memset(healthCounters.presses, 0, sizeof(healthCounters.presses));
+	memset(healthCounters.chatter, 0, sizeof(healthCounters.chatter));
+	memset(healthCounters.durations, 0, sizeof(healthCounters.durations));
+	healthCounters.clearedMs = HAL_GetTick();
+}
+
+/**
+ * @brief Counts a debounced edge
+ * @note Scan task only. Masked against the USB interrupt, which can clear.
+ * @param key Key index, row major
+ * @param pressed 1 for a press, 0 for a release
+ * @param timeMs When the change was first seen
+ * @retval For a release, how long the key was held in ms, otherwise 0
+ */
+uint32_t healthEdge(uint16_t key, _Bool pressed, uint32_t timeMs)
+{
+	UBaseType_t mask;
+	uint32_t heldMs;
+	uint8_t *bins;
+	uint8_t bin;
+
+	if (key >= keyboardNUM_KEYS)
+	{
+		return 0;
+	}
+	if (pressed)
+	{
+		pressedAt[key] = timeMs;
+		mask = portSET_INTERRUPT_MASK_FROM_ISR();
+		healthCounters.presses[key] = SATURATE16(healthCounters.presses[key]);
+		portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+		return 0;
+	}
+	heldMs = timeMs - pressedAt[key];
+	bins = healthCounters.durations[key];
+	bin = healthBin(heldMs);
+	mask = portSET_INTERRUPT_MASK_FROM_ISR();
+	if (bins[bin] == UINT8_MAX)
+	{
+		for (uint8_t ii = 0; ii < healthBINS; ii++)
+		{
+			bins[ii] >>= 1;
+		}
+	}
+	bins[bin]++;
+	portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+	return heldMs;
+}
+
+/**
+ * @brief Counts a change the debounce rejected
+ * @note Scan task only.
+ * @param key Key index, row major
+ * @retval none
+ */
+void healthChatter(uint16_t key)
+{
+	UBaseType_t mask;
+
+	if (key >= keyboardNUM_KEYS)
+	{
+		return;
+	}
+	mask = portSET_INTERRUPT_MASK_FROM_ISR();
+	healthCounters.chatter[key] = SATURATE16(healthCounters.chatter[key]);
+	portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+}
+
+/**
+ * @brief Acts on a command from the host
+ * @note Runs in the USB interrupt.
+ * @param cmd healthCMD_x
+ * @retval none
+ */
+void healthCommand(uint8_t cmd)
+{
+	UBaseType_t mask = portSET_INTERRUPT_MASK_FROM_ISR();
+
+	switch (cmd)
+	{
+	case healthCMD_REWIND:
+		readOffset = 0;
+		break;
+	case healthCMD_CLEAR:
+		healthClear();
+		break;
+	default:
+		break;
+	}
+	portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+}
+
+/**
+ * @brief Copies the next piece of the counters for export
+ * @note Reads walk the whole health_counters_t and wrap to the start. Counters
+ *       keep counting between pieces, but no single one is ever torn.
+ * @param dst Destination buffer
+ * @param len Bytes wanted
+ * @param offset Set to the offset the copied bytes came from
+ * @retval Number of bytes copied
+ */
+uint16_t healthRead(uint8_t *dst, uint16_t len, uint16_t *offset)
+{
+	uint16_t count;
+
+	*offset = readOffset;
+	count = sizeof(health_counters_t) - readOffset;
+	if (count > len)
+	{
+		count = len;
+	}
+	memcpy(dst, (uint8_t *)&healthCounters + readOffset, count);
+	readOffset += count;
+	if (readOffset >= sizeof(health_counters_t))
+	{
+		readOffset = 0;
+	}
+	return count;
+}
+
+/**
+ * @brief Fills in the header and zeroes the counters
+ * @param none
+ * @retval none
+ */
+void healthInit(void)
+{
+	healthCounters.magic = healthMAGIC;
+	healthCounters.version = healthVERSION;
+	healthCounters.numRows = keyboardNUM_ROWS;
+	healthCounters.numCols = keyboardNUM_COLS;
+	healthCounters.bins = healthBINS;
+	healthCounters.bin0Log2 = healthBIN0_LOG2;
+	healthClear();
+}
+/* EOF */
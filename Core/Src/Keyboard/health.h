@@ -0,0 +1,73 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file health.h
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief Definitions and prototypes for per-key switch health counters
+ ******************************************************************************/
+// @formatter:off
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __HEALTH_H
+#define __HEALTH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "keyboard.h"
+
+/* Defines -------------------------------------------------------------------*/
+#define healthMAGIC					( 0x31544C48UL )	/* "HLT1" */
+#define healthVERSION				( 1 )
+
+/**
+ * Press duration bins, log2 of the ms held: bin 0 is under 2^healthBIN0_LOG2
+ * ms, each bin after it twice as wide, the last one open ended.
+ */
+#define healthBINS					( 8 )
+#define healthBIN0_LOG2				( 5 )	/* Bin 0 < 32 ms, bin 7 >= 2 s */
+
+/* Commands accepted by healthCommand() */
+#define healthCMD_REWIND			( 0 )	/* Read back from offset 0 */
+#define healthCMD_CLEAR				( 1 )	/* Zero every counter */
+
+/* Structures ----------------------------------------------------------------*/
+/**
+ * The counters are the export format read by Tools/health_read.py, so field
+ * order and sizes here are the wire format. Little endian throughout. Keys
+ * are indexed row major, as everywhere else. Counters saturate; a key whose
+ * histogram bin fills up has all its bins halved, which keeps the shape.
+ */
+typedef struct _HEALTH_COUNTERS_S_
+{
+	uint32_t magic;
+	uint16_t version;
+	uint8_t numRows;
+	uint8_t numCols;
+	uint8_t bins;			/* Entries per key in durations[] */
+	uint8_t bin0Log2;		/* Upper edge of bin 0 is 2^bin0Log2 ms */
+	uint16_t reserved;
+	uint32_t clearedMs;		/* HAL tick when the counters were last zeroed */
+	uint16_t presses[keyboardNUM_KEYS];		/* Debounced presses */
+	uint16_t chatter[keyboardNUM_KEYS];		/* Changes debounce threw away */
+	uint8_t durations[keyboardNUM_KEYS][healthBINS];
+} health_counters_t;
+
+/* Prototypes ----------------------------------------------------------------*/
+void healthInit(void);
+uint32_t healthEdge(uint16_t key, _Bool pressed, uint32_t timeMs);
+void healthChatter(uint16_t key);
+void healthCommand(uint8_t cmd);
+uint16_t healthRead(uint8_t *dst, uint16_t len, uint16_t *offset);
+
+/* Exported variables --------------------------------------------------------*/
+extern health_counters_t healthCounters;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HEALTH_H */
+/* EOF */
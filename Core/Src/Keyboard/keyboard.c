@@ -12,89 +12,255 @@
 #include "main.h"
 #include "cmsis_os.h"
 #include "keyboard.h"
+#include "keymap.h"
+#include "taphold.h"
+#include "combo.h"
+#include "settle.h"
+#include "health.h"
+#include "debounce.h"
+#include "governor.h"
 #include "../Utilities/utils.h"
 
 #include <stdio.h>
 #include <string.h>
 #include "usb_hid_keys.h"
 #include "../UsbInterface/usb_if.h"
+#include "../Trace/trace.h"
+#include "../Settings/settings.h"
+#include "../Bench/bench.h"
+#include "../Boot/boot.h"
 
 /* Defines -------------------------------------------------------------------*/
 #define ROW_MASK	( 0x0003 )
+#define DEFAULT_DEBOUNCE_MS	( 30 )
+
+/* Private types -------------------------------------------------------------*/
+typedef struct _KEYBOARD_EDGE_S_
+{
+	uint16_t key;
+	GPIO_PinState state;
+	uint32_t timeMs;		/* When the change was first seen, before debounce */
+} key_edge_t;
 
 /* Private variables ---------------------------------------------------------*/
 static key_matrix_t keeb;
+static key_struct_t keys[keyboardNUM_KEYS];
+#if !benchENABLE
+static StackType_t keyboardScanStack[keyboardSCAN_STACK_SIZE];
+static StaticTask_t keyboardScanTcb;
+#endif
+static volatile uint32_t lastEdge;		/* Tick of the last debounced change */
+static volatile uint16_t keysDown;
+
+/**
+ * Raw state of the latest read of every row, bit per column. Without diodes,
+ * three keys on the corners of a rectangle make the fourth read as pressed,
+ * so a new press that shares two columns with another row is ambiguous.
+ */
+static uint32_t frame[keyboardNUM_ROWS];
+static uint8_t blockedRows;		/* Rows holding back an ambiguous press */
+static uint16_t overflowKeys;	/* Keys down that did not fit in the report */
+
+/* Edges debounced in the current row, dispatched in the order they happened */
+static key_edge_t rowEdges[keyboardNUM_COLS];
+static uint8_t rowEdgeCount;
+
+/* Scan pipeline, the row last released and when, carried between frames */
+static uint32_t releasedAt;
+static uint8_t released;
+static _Bool changing;		/* A key is in debounce, or read differently from its state */
+
+/**
+ * Keys debounce for different times, so a later change on a fast key can
+ * clear before an earlier one on a slow key. First-seen time of the oldest
+ * change still waiting, as of the last frame; nothing newer is let through
+ * until it has gone, so edges leave debounce in the order they were seen.
+ */
+static uint32_t oldestWaiting;
+static _Bool waiting;
+static uint32_t nextOldest;		/* Being gathered in this frame */
+static _Bool nextWaiting;
 
 /* Static prototypes ---------------------------------------------------------*/
 static void keyboardRefresh(key_matrix_t *kb, uint8_t rowNo, uint8_t colNo,
-		GPIO_PinState rowVal);
+		GPIO_PinState rowVal, _Bool ambiguous);
+static uint32_t keyboardGhostMask(uint8_t rowNo);
+static void keyboardDispatchEdges(void);
+static void keyboardNoteWaiting(uint32_t timeMs);
+static void keyboardSettleSince(uint32_t start, uint32_t us);
+static void keyboardUpdateRollOver(void);
 static void keyboardScanTask(void *pvParameters);
-static void keyboardUpdateReport(key_matrix_t *kb, key_struct_t *key);
+static _Bool keyboardScanFrame(key_matrix_t *kb);
+static uint32_t keyboardReadRow(key_matrix_t *kb);
+static void keyboardProcessRow(key_matrix_t *kb, uint8_t rowNo, uint32_t rowBits);
+static void keyboardUpdateReport(key_matrix_t *kb, key_struct_t *key,
+		GPIO_PinState keyState, uint16_t override);
+static void keyboardEmit(uint16_t key, _Bool pressed, uint16_t override);
+static void keyboardComboEmit(uint16_t key, _Bool pressed, uint16_t override,
+		uint32_t timeMs);
 
 /* Code ----------------------------------------------------------------------*/
 /**
- * @brief Scans each key and records current status and changes
+ * @brief Scans the matrix, as often as the governor says
  * @param pvParameters key_matrix_t* of keyboard struct being scanned
  * @retval none
  */
 static void keyboardScanTask(void *pvParameters)
 {
 	key_matrix_t *kb = (key_matrix_t *)pvParameters;
-	static GPIO_PinState lastRead;
+	_Bool active;
 
+	settleCalibrate(kb);
+	releasedAt = utilsCYCLES();
 	for (;;)
 	{
 		/**
 		 * Ye who optimize before having a working prototype shall be subject to
 		 * ten thousand years of debugging in the bog of eternal stench.
 		 */
-		for (int rr = 0; rr < kb->numRows; rr++)
+		active = keyboardScanFrame(kb);
+		bootMark(bootMARK_FIRST_FRAME);
+		/* Give the rest of the system the CPU between frames */
+		vTaskDelay(pdMS_TO_TICKS(governorFrame(active, changing)));
+	}
+}
+
+/**
+ * @brief Scans each key and records current status and changes
+ * @note Pipelined: as soon as a row is sampled it is released and the next one
+ *       driven, and the sampled row is processed while the next one settles.
+ *       A frame then costs about rows x settle time, the processing is free.
+ * @param kb Pointer to keyboard struct being scanned
+ * @retval 1 if anything is going on that wants the full scan rate
+ */
+static _Bool keyboardScanFrame(key_matrix_t *kb)
+{
+	uint32_t rowBits;
+	uint32_t drivenAt;
+
+	/**
+	 * Switches are active low, so we sink the pin of the target row.
+	 */
+	changing = 0;
+	nextWaiting = 0;
+	HAL_GPIO_WritePin(kb->rowPins[0]->port, kb->rowPins[0]->pin,
+			GPIO_PIN_RESET);
+	drivenAt = utilsCYCLES();
+	for (int rr = 0; rr < kb->numRows; rr++)
+	{
+		/**
+		 * This wait is EXTREMELY FUCKING IMPORTANT! The voltage on the
+		 * output pins doesn't flip fast enough between rows, essentially
+		 * shorting the readings for row 1 and row 2. The previous row has
+		 * to have let go of the columns and this one has to be down before
+		 * we look. It used to be a flat 5 ms after every row; settle.c now
+		 * measures how long this board really needs, per row, and falls
+		 * back to the 5 ms if it can't tell. Whatever the last row's
+		 * processing took already counts towards it.
+		 */
+		keyboardSettleSince(releasedAt, settleReleaseUs(released));
+		keyboardSettleSince(drivenAt, settleDriveUs(rr));
+		/*
+							  /´¯/)
+							,/¯../
+						   /..../
+					 /´¯/'...'/´¯¯`·¸
+				  /'/.../..../......./¨¯\
+				('(...´...´.... ¯~/'...')
+				 \................'...../
+				  ''...\.......... _.·´
+					\..............(
+					  \.............\
+		 */
+		rowBits = keyboardReadRow(kb);
+		/**
+		 * Clean up after ourselves by sourcing the current row pin, and get
+		 * the next row settling while this one is worked through.
+		 */
+		HAL_GPIO_WritePin(kb->rowPins[rr]->port, kb->rowPins[rr]->pin,
+				GPIO_PIN_SET);
+		releasedAt = utilsCYCLES();
+		released = rr;
+		if (rr + 1 < kb->numRows)
 		{
-			/**
-			 * Switches are active low, so we sink the pin of the target row.
-			 */
-			HAL_GPIO_WritePin(kb->rowPins[rr]->port, kb->rowPins[rr]->pin,
-					GPIO_PIN_RESET);
-			for (int cc = 0; cc < kb->numCols; cc++)
-			{
-				/**
-				 * This will report reverse of actual since the switches are
-				 * active low. It is the responsibility of the refresh function
-				 * to handle this, as the raw reading will be reported to that
-				 * function.
-				 */
-				lastRead = HAL_GPIO_ReadPin(kb->colPins[cc]->port,
-						kb->colPins[cc]->pin);
-				keyboardRefresh(kb, rr, cc, lastRead);
-			}
-			/**
-			 * Clean up after ourselves by sourcing the current row pin before
-			 * moving on.
-			 */
-			HAL_GPIO_WritePin(kb->rowPins[rr]->port, kb->rowPins[rr]->pin,
-					GPIO_PIN_SET);
-			/**
-			 * This delay is EXTREMELY FUCKING IMPORTANT! The voltage on the
-			 * output pins doesn't flip fast enough between row scan loops,
-			 * essentially shorting the readings for row 1 and row 2. I spent
-			 * three fucking hours debugging this, so out of respect to me and
-			 * that segment of life I'll never get back don't you dare fucking
-			 * touch this line of code. Thank you have have a great day.
-			 */
-			vTaskDelay(pdMS_TO_TICKS(5));
-			/*
-								  /´¯/)
-								,/¯../
-							   /..../
-						 /´¯/'...'/´¯¯`·¸
-					  /'/.../..../......./¨¯\
-					('(...´...´.... ¯~/'...')
-					 \................'...../
-					  ''...\.......... _.·´
-						\..............(
-						  \.............\
-			 */
+			HAL_GPIO_WritePin(kb->rowPins[rr + 1]->port,
+					kb->rowPins[rr + 1]->pin, GPIO_PIN_RESET);
+			drivenAt = utilsCYCLES();
 		}
+		keyboardProcessRow(kb, rr, rowBits);
+	}
+	oldestWaiting = nextOldest;
+	waiting = nextWaiting;
+	settleRecheck(kb);
+	debouncePersist();
+	return changing || keysDown != 0 || comboPending() || tapholdPending();
+}
+
+/**
+ * @brief Samples every column of the row being driven
+ * @param kb Pointer to keyboard struct being scanned
+ * @retval Raw sample, bit per column, 1 is pressed
+ */
+static uint32_t keyboardReadRow(key_matrix_t *kb)
+{
+	uint32_t rowBits = 0;
+
+	for (int cc = 0; cc < kb->numCols; cc++)
+	{
+		rowBits |= (uint32_t)(HAL_GPIO_ReadPin(kb->colPins[cc]->port,
+				kb->colPins[cc]->pin) == GPIO_PIN_RESET) << cc;
+	}
+	return rowBits;
+}
+
+/**
+ * @brief Runs change detection, debounce and everything downstream for a row
+ * @param kb Pointer to keyboard struct being scanned
+ * @param rowNo Row that was sampled
+ * @param rowBits Raw sample of the row, bit per column, 1 is pressed
+ * @retval none
+ */
+static void keyboardProcessRow(key_matrix_t *kb, uint8_t rowNo, uint32_t rowBits)
+{
+	GPIO_PinState lastRead;
+	uint32_t ghost;
+	uint32_t edgeClock;
+
+	frame[rowNo] = rowBits;
+	ghost = keyboardGhostMask(rowNo);
+	blockedRows &= ~(1U << rowNo);
+	for (int cc = 0; cc < kb->numCols; cc++)
+	{
+		/**
+		 * This will report reverse of actual since the switches are
+		 * active low. It is the responsibility of the refresh function
+		 * to handle this, as the raw reading will be reported to that
+		 * function.
+		 */
+		lastRead = ((rowBits >> cc) & 1) ? GPIO_PIN_RESET : GPIO_PIN_SET;
+		keyboardRefresh(kb, rowNo, cc, lastRead, (ghost >> cc) & 1);
+	}
+	keyboardDispatchEdges();
+	keyboardUpdateRollOver();
+	/**
+	 * Edges carry the time they were first seen, which is up to a debounce
+	 * time behind the tick. The timers run on that same clock, so a combo
+	 * window or tapping term is not cut short by the debounce delay; no edge
+	 * still in debounce can be older than this.
+	 */
+	edgeClock = HAL_GetTick() - kb->debounce - 1;
+	if (waiting && (int32_t)(oldestWaiting - 1 - edgeClock) < 0)
+	{
+		/* An edge held back for order can be older than the debounce time */
+		edgeClock = oldestWaiting - 1;
+	}
+	if (comboPending())
+	{
+		comboTick(edgeClock);
+	}
+	if (tapholdPending())
+	{
+		tapholdTick(edgeClock);
 	}
 }
 
@@ -104,76 +270,279 @@ static void keyboardScanTask(void *pvParameters)
  * @param rowNo Index of kb->rowPins array being scanned
  * @param colNo Index of kb->colPins array being scanned
  * @param rowVal State of the pin in question as read by a scan
+ * @param ambiguous 1 if the key sits on a rectangle of pressed keys, so a
+ *        press may be a ghost and is held back until the rectangle breaks
  * @retval none
  */
 static void keyboardRefresh(key_matrix_t *kb, uint8_t rowNo, uint8_t colNo,
-		GPIO_PinState rowVal)
+		GPIO_PinState rowVal, _Bool ambiguous)
 {
 	static key_struct_t *thisKey;
 	static GPIO_PinState lastState;
 	static GPIO_PinState keyState;
+	uint16_t idx = GET_IDX(colNo, rowNo, kb->numCols);
+	uint32_t heldMs;
 
-	thisKey = kb->keys[GET_IDX(colNo, rowNo, kb->numCols)];
+	thisKey = &kb->keys[idx];
 	lastState = thisKey->currState;
 	keyState = 0x0001 & (rowVal ^ 1);
+	changing |= (keyState != lastState) || thisKey->stateChanged;
 	if (keyState != lastState && !(thisKey->stateChanged))
 	{
 		thisKey->stateChanged = 1;
 		thisKey->tempState = keyState;
 		thisKey->lastTrigger = HAL_GetTick();
+		thisKey->ghosted = 0;
 	}
-	if (HAL_GetTick() - thisKey->lastTrigger > kb->debounce)
+	if (thisKey->stateChanged && keyState && ambiguous)
 	{
-		if (thisKey->stateChanged)
+		/* If it goes away again it was a phantom, not the switch chattering */
+		thisKey->ghosted = 1;
+	}
+	if (HAL_GetTick() - thisKey->lastTrigger > debounceWindowMs(idx))
+	{
+		if (thisKey->stateChanged && keyState && ambiguous)
+		{
+			/* Still debounced, so it goes through as soon as it is clear */
+			blockedRows |= 1U << rowNo;
+		}
+		else if (thisKey->stateChanged && waiting
+				&& (int32_t)(thisKey->lastTrigger - oldestWaiting) > 0)
+		{
+			/* An earlier change on a slower key has to go first */
+			keyboardNoteWaiting(thisKey->lastTrigger);
+		}
+		else if (thisKey->stateChanged)
 		{
 			thisKey->stateChanged = 0;
 			if (keyState == thisKey->tempState)
 			{
 				thisKey->currState = keyState;
-				keyboardUpdateReport(kb, thisKey);
-				os_printf("Triggered: %s, State: %d\r\n",
-						thisKey->name, thisKey->currState);
+				lastEdge = HAL_GetTick();
+				keysDown += keyState ? 1 : -1;
+				traceKeyEdge(idx, keyState);
+				bootMark(bootMARK_FIRST_EDGE);
+				heldMs = healthEdge(idx, keyState, thisKey->lastTrigger);
+				if (!keyState)
+				{
+					debounceRelease(idx, heldMs);
+				}
+				rowEdges[rowEdgeCount++] = (key_edge_t) {
+					.key = idx,
+							.state = keyState,
+							.timeMs = thisKey->lastTrigger
+				};
+				os_printf("Triggered: r%dc%d, State: %d\r\n",
+						rowNo, colNo, thisKey->currState);
+			}
+			else if (!thisKey->ghosted)
+			{
+				/* Changed and changed back within the debounce time */
+				healthChatter(idx);
+				debounceChatter(idx);
 			}
 		}
 	}
+	else if (thisKey->stateChanged)
+	{
+		keyboardNoteWaiting(thisKey->lastTrigger);
+	}
+}
+
+/**
+ * @brief Counts a change still in debounce, or held back, towards the next
+ *        frame's oldest waiting change
+ * @param timeMs When the change was first seen
+ * @retval none
+ */
+static void keyboardNoteWaiting(uint32_t timeMs)
+{
+	if (!nextWaiting || (int32_t)(timeMs - nextOldest) < 0)
+	{
+		nextOldest = timeMs;
+		nextWaiting = 1;
+	}
+}
+
+/**
+ * @brief Waits for the matrix lines to settle
+ * @note Short waits spin on the cycle counter; anything of a tick or more
+ *       sleeps so the wait is not burnt.
+ * @param start Cycle count when the line changed
+ * @param us Time the line needs from then, in us
+ * @retval none
+ */
+static void keyboardSettleSince(uint32_t start, uint32_t us)
+{
+	uint32_t elapsed = (utilsCYCLES() - start) / (SystemCoreClock / 1000000U);
+
+	if (elapsed >= us)
+	{
+		return;
+	}
+	us -= elapsed;
+	if (us >= 1000U)
+	{
+		vTaskDelay(pdMS_TO_TICKS((us + 999U) / 1000U));
+	}
+	else
+	{
+		utilsDelayUs(us);
+	}
+}
+
+/**
+ * @brief Passes the row's debounced edges on in the order they happened
+ * @note Columns are read in a fixed order, but the edges were first seen on
+ *       earlier passes, so sorting by that time restores true edge order.
+ *       The edge times then drive the combo and tap-hold timing.
+ * @param none
+ * @retval none
+ */
+static void keyboardDispatchEdges(void)
+{
+	key_edge_t edge;
+	int jj;
+
+	for (int ii = 1; ii < rowEdgeCount; ii++)
+	{
+		edge = rowEdges[ii];
+		for (jj = ii; jj > 0 && (int32_t)(rowEdges[jj - 1].timeMs - edge.timeMs) > 0; jj--)
+		{
+			rowEdges[jj] = rowEdges[jj - 1];
+		}
+		rowEdges[jj] = edge;
+	}
+	for (int ii = 0; ii < rowEdgeCount; ii++)
+	{
+		comboEvent(rowEdges[ii].key, rowEdges[ii].state, rowEdges[ii].timeMs);
+	}
+	rowEdgeCount = 0;
+}
+
+/**
+ * @brief Finds the keys of a row that sit on a rectangle of pressed keys
+ * @note Seven AND and test pairs against the latest read of every other row.
+ *       Two rows sharing two or more columns is exactly the case where a
+ *       diode-less matrix cannot tell a real press from a phantom one.
+ * @param rowNo Row to check
+ * @retval Bit per column of the ambiguous keys in the row
+ */
+static uint32_t keyboardGhostMask(uint8_t rowNo)
+{
+	uint32_t ghost = 0;
+	uint32_t shared;
+
+	for (int rr = 0; rr < keyboardNUM_ROWS; rr++)
+	{
+		shared = frame[rowNo] & frame[rr];
+		if (rr != rowNo && (shared & (shared - 1)))
+		{
+			ghost |= shared;
+		}
+	}
+	return ghost;
+}
+
+/**
+ * @brief Reports ErrorRollOver while keys are lost to overflow or ghosting
+ * @param none
+ * @retval none
+ */
+static void keyboardUpdateRollOver(void)
+{
+	usbifSetRollOver(overflowKeys != 0 || blockedRows != 0);
+}
+
+/**
+ * @brief Receives key events from the combo matcher
+ * @note A combo's action is already resolved, so it skips the tap-hold stage.
+ * @param key Index of the key in the matrix
+ * @param pressed 1 on press, 0 on release
+ * @param override The combo's action, or keymapTRNS for an ordinary key
+ * @param timeMs Time of the original edge
+ * @retval none
+ */
+static void keyboardComboEmit(uint16_t key, _Bool pressed, uint16_t override,
+		uint32_t timeMs)
+{
+	if (override != keymapTRNS)
+	{
+		keyboardEmit(key, pressed, override);
+	}
+	else
+	{
+		tapholdEvent(key, pressed, timeMs);
+	}
+}
+
+/**
+ * @brief Receives resolved key events from the tap-hold resolver
+ * @param key Index of the key in the matrix
+ * @param pressed 1 on press, 0 on release
+ * @param override Action to press instead of the keymap's, or keymapTRNS
+ * @retval none
+ */
+static void keyboardEmit(uint16_t key, _Bool pressed, uint16_t override)
+{
+	keyboardUpdateReport(&keeb, &keeb.keys[key], pressed, override);
 }
 
 /**
  * @brief Updates the requesting key's status in the HID report structure
+ * @note The action is resolved through the keymap once, on the press, and
+ *       kept in the key so the release undoes exactly what the press did.
+ * @param kb Pointer to keyboard struct being scanned
  * @param key Pointer to key struct reporting its status
+ * @param keyState Resolved state of the key, which may lag currState while
+ *        the tap-hold resolver holds events back
+ * @param override Action to press instead of the keymap's, or keymapTRNS
  * @retval none
  */
-#define FNLAYER		(uint8_t)kb->isFnLayer
-static void keyboardUpdateReport(key_matrix_t *kb, key_struct_t *key)
+static void keyboardUpdateReport(key_matrix_t *kb, key_struct_t *key,
+		GPIO_PinState keyState, uint16_t override)
 {
 	key_struct_t *thisKey = key;
-	GPIO_PinState keyState = thisKey->currState;
 	uint16_t keyIndex = thisKey->reportIndex;
+	uint16_t action;
 	/**
 	 * On a rising edge if we haven't already reported our status
 	 */
 	if (keyState && !keyIndex)
 	{
-		if (thisKey->val[0] == 0xFF)
+		action = (override != keymapTRNS) ? keymapPressAction(override)
+				: keymapPress((uint16_t)(thisKey - kb->keys));
+		thisKey->action = action;
+		if (keymapKIND(action) == keymapKIND_MACRO)
 		{
-			kb->isFnLayer = 1;
+			usbifPlayMacro(keymapMACRO_NUM(action));
+			return;
 		}
-		else if (thisKey->isMod)
+		if (keymapKIND(action) != keymapKIND_KEY || action == keymapNO)
 		{
-			usbifUpdateMod(thisKey->val[FNLAYER]);
+			return;
+		}
+		if (action >= KEY_LEFTCTRL && action <= KEY_RIGHTMETA)
+		{
+			usbifUpdateMod(1U << (action - KEY_LEFTCTRL));
 		}
 		else
 		{
 			uint16_t k = usbifRequestKey();
 			/**
-			 * @c usbifUpdateKey returns 6 if there is no available index in the
-			 * HID report. This results in the current keypress being ignored.
-			 *
-			 * TODO: report rollover overflow
+			 * @c usbifRequestKey returns 6 if there is no available index in
+			 * the HID report. The key is then counted as overflow and the
+			 * report shows ErrorRollOver until it is released.
 			 */
 			if (k < 6)
 			{
-				thisKey->reportIndex = usbifUpdateKey(k, thisKey->val[FNLAYER]) + 1;
+				thisKey->reportIndex = usbifUpdateKey(k, (uint8_t)action) + 1;
+			}
+			else
+			{
+				thisKey->overflow = 1;
+				overflowKeys++;
+				keyboardUpdateRollOver();
 			}
 		}
 	}
@@ -182,21 +551,85 @@ static void keyboardUpdateReport(key_matrix_t *kb, key_struct_t *key)
 	 */
 	else if (!keyState)
 	{
-		if (thisKey->val[0] == 0xFF)
+		action = thisKey->action;
+		thisKey->action = keymapTRNS;
+		keymapRelease(action);
+		if (keymapKIND(action) != keymapKIND_KEY || action == keymapNO)
 		{
-			kb->isFnLayer = 0;
+			return;
 		}
-		else if (thisKey->isMod)
+		if (action >= KEY_LEFTCTRL && action <= KEY_RIGHTMETA)
 		{
-			usbifClearMod(thisKey->val[FNLAYER]);
+			usbifClearMod(1U << (action - KEY_LEFTCTRL));
 		}
-		else
+		else if (keyIndex)
 		{
 			thisKey->reportIndex = usbifClearKey(keyIndex - 1);
 		}
+		else if (thisKey->overflow)
+		{
+			thisKey->overflow = 0;
+			overflowKeys--;
+			keyboardUpdateRollOver();
+		}
 	}
 }
-#undef FNLAYER
+
+/**
+ * @brief Tells whether the matrix has been quiet for a while
+ * @note Used to hold off work that stalls the CPU, like flash erases, until
+ *       the user is not typing.
+ * @param ms Time without any debounced change, in ms
+ * @retval 1 if no key is down and none has changed for ms
+ */
+_Bool keyboardIsIdle(uint32_t ms)
+{
+	return keysDown == 0 && HAL_GetTick() - lastEdge >= ms;
+}
+
+#if benchENABLE
+/**
+ * @brief Readies the matrix for the benchmarks, as the scan task would
+ * @param none
+ * @retval none
+ */
+void keyboardBenchPrepare(void)
+{
+	settleCalibrate(&keeb);
+	releasedAt = utilsCYCLES();
+}
+
+/**
+ * @brief One row read, for the benchmarks
+ * @param none
+ * @retval Raw sample
+ */
+uint32_t keyboardBenchReadRow(void)
+{
+	return keyboardReadRow(&keeb);
+}
+
+/**
+ * @brief One full frame, settle waits included, for the benchmarks
+ * @param none
+ * @retval none
+ */
+void keyboardBenchFrame(void)
+{
+	keyboardScanFrame(&keeb);
+}
+
+/**
+ * @brief Debounce and everything downstream for one row, for the benchmarks
+ * @param rowNo Row the sample is from
+ * @param rowBits Raw sample, bit per column, 1 is pressed
+ * @retval none
+ */
+void keyboardBenchProcessRow(uint8_t rowNo, uint32_t rowBits)
+{
+	keyboardProcessRow(&keeb, rowNo, rowBits);
+}
+#endif
 
 /**
  * @brief Use this to construct keyboard initial conditions and key mapping
@@ -205,26 +638,25 @@ static void keyboardUpdateReport(key_matrix_t *kb, key_struct_t *key)
  */
 void keyboardInit()
 {
-	/* Initialize keys -------------------------------------------------------*/
-	/* Row 00 ----------------------------------------------------------------*/
-	static key_struct_t kr0c0 = {
-			.name = "Q",
-			.val = { KEY_Q, KEY_1 },
-			.isMod = 0,
-			.currState = 0,
-			.tempState = 0,
-			.stateChanged = 0,
-			.lastTrigger = 0,
-			.reportIndex = 0
-	};
-
-	/* TODO: make this const? */
-	static key_struct_t *theKeys[180] = {
-			&kr0c0, &kr0c1, &kr0c2, &kr0c3, &kr0c4, &kr0c5, &kr0c6, &kr0c7, &kr0c8, &kr0c9, &kr0c10,
-			&kr1c0, &kr1c1, &kr1c2, &kr1c3, &kr1c4, &kr1c5, &kr1c6, &kr1c7, &kr1c8, &kr1c9, &kr1c10,
-			&kr2c0, &kr2c1, &kr2c2, &kr2c3, &kr2c4, &kr2c5, &kr2c6, &kr2c7, &kr2c8, &kr2c9, &kr2c10,
-			&kr3c0, &kr3c1, &kr3c2, &kr3c3, &kr3c4, &kr3c5, &kr3c6, &kr3c7, &kr3c8, &kr3c9, &kr3c10,
+	static const taphold_config_t tapholdConfig = {
+		.tappingTermMs = tapholdTAPPING_TERM_MS,
+				.permissiveHold = 1,
+				.holdOnOtherKey = 0
+	};
+	static const taphold_ops_t tapholdOps = {
+		.lookup = keymapLookup,
+				.emit = keyboardEmit
 	};
+	static const combo_ops_t comboOps = {
+		.emit = keyboardComboEmit
+	};
+
+	/* Initialize keys -------------------------------------------------------*/
+	memset(keys, 0, sizeof(keys));
+	keymapInit();
+	healthInit();
+	tapholdInit(&tapholdConfig, &tapholdOps);
+	comboInit(&comboOps);
 
 	/* Initialize rows -------------------------------------------------------*/
 	static gpio_struct_t row0 = {
@@ -351,18 +783,45 @@ void keyboardInit()
 	};
 
 	/* Initialize keyboard ---------------------------------------------------*/
+	uint16_t length;
+	const uint16_t *debounce = settingsGet(settingsKEY_DEBOUNCE, &length);
+	/* A record of the wrong size is from some other firmware, ignore it */
+	if (debounce != NULL && length != sizeof(*debounce))
+	{
+		debounce = NULL;
+	}
+	const uint8_t *profile = settingsGet(settingsKEY_PROFILE, &length);
+	if (profile != NULL && length != sizeof(*profile))
+	{
+		profile = NULL;
+	}
+	const uint16_t *scanActive = settingsGet(settingsKEY_SCAN_ACTIVE, &length);
+	if (scanActive != NULL && length != sizeof(*scanActive))
+	{
+		scanActive = NULL;
+	}
+
 	keeb = (key_matrix_t) {
-		.numRows = 8,
-				.numCols = 20,
+		.numRows = keyboardNUM_ROWS,
+				.numCols = keyboardNUM_COLS,
 				.rowPins = gpioRows,
 				.colPins = gpioCols,
-				.keys = theKeys,
-				.isFnLayer = 0,
-				.debounce = 30
+				.keys = keys,
+				.debounce = debounce ? *debounce : DEFAULT_DEBOUNCE_MS
 	};
+	debounceInit(keeb.debounce);
+	governorInit(scanActive ? *scanActive : governorDEFAULT_ACTIVE_MS);
+	if (profile != NULL)
+	{
+		settingsSelectProfile(*profile);
+	}
 	/* FreeRTOS Stuff --------------------------------------------------------*/
-	xTaskCreate(keyboardScanTask, "kbscan", keyboardSCAN_STACK_SIZE,
-			(void *)&keeb, keyboardSCAN_PRIORITY, NULL);
+#if !benchENABLE
+	/* The benchmark build drives the matrix from Bench/bench.c instead */
+	xTaskCreateStatic(keyboardScanTask, "kbscan", keyboardSCAN_STACK_SIZE,
+			(void *)&keeb, keyboardSCAN_PRIORITY, keyboardScanStack,
+			&keyboardScanTcb);
+#endif
 
 	/* Misc. cleanup ---------------------------------------------------------*/
 }
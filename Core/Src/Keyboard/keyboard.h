@@ -22,18 +22,22 @@ extern "C" {
 /* Defines -------------------------------------------------------------------*/
 #define keyboardSCAN_STACK_SIZE		( 1024 )
 #define keyboardSCAN_PRIORITY		( tskIDLE_PRIORITY + 3 )
+#define keyboardFRAME_DELAY_MS		( 1 )	/* Sleep between scans at full rate */
+#define keyboardNUM_ROWS			( 8 )
+#define keyboardNUM_COLS			( 20 )
+#define keyboardNUM_KEYS			( keyboardNUM_ROWS * keyboardNUM_COLS )
 
 /* Structures ----------------------------------------------------------------*/
 typedef struct _KEYBOARD_KEY_S_
 {
-	uint8_t name[8];		/* Name up to 7 characters long (+ null term) */
-	uint8_t val[2];			/* HID keyboard scan values of this key */
-	_Bool isMod;			/* 0 is not modifier key, 1 is modifier key */
+	uint16_t action;		/* Keymap action the key was pressed with */
 	GPIO_PinState currState;/* 0 is not pressed, 1 is pressed */
 	GPIO_PinState tempState;/* 0 is not pressed, 1 is pressed (for debouncing*/
 	_Bool stateChanged;		/* 0 is no change since last update, 1 is has changed */
 	uint32_t lastTrigger;	/* Time stamp at which the key was last pressed */
 	uint16_t reportIndex;	/* Current index in HID report */
+	_Bool overflow;			/* Pressed while the report was full */
+	_Bool ghosted;			/* Pending press was read on a ghost rectangle */
 } key_struct_t;
 
 typedef struct _KEYBOARD_MATRIX_S_
@@ -42,15 +46,21 @@ typedef struct _KEYBOARD_MATRIX_S_
 	uint8_t numCols;		/* Number of columns to be scanned */
 	gpio_struct_t **rowPins;/* Pointer to array of row pins */
 	gpio_struct_t **colPins;/* Pointer to array of column pins */
-	key_struct_t **keys;	/* Pointer to base address of key array */
-	_Bool isFnLayer;		/* 0 for normal mode, 1 for alternate functions */
-	uint16_t debounce;		/* debounce time in ms */
+	key_struct_t *keys;		/* Base address of key array, row major */
+	uint16_t debounce;		/* Longest debounce time in ms, see debounce.c */
 } key_matrix_t;
 
 /* Prototypes ----------------------------------------------------------------*/
 void keyboardInit(void);
 void keyboardLoop(void);
 void keyboardUpdateKey(key_struct_t *self, uint8_t newVal);
+_Bool keyboardIsIdle(uint32_t ms);
+
+/* Benchmark build only, see Bench/bench.c */
+void keyboardBenchPrepare(void);
+uint32_t keyboardBenchReadRow(void);
+void keyboardBenchFrame(void);
+void keyboardBenchProcessRow(uint8_t rowNo, uint32_t rowBits);
 
 /* Exported variables --------------------------------------------------------*/
 
@@ -0,0 +1,311 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file keymap.c
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief Layer stack and flattened keymap lookup
+ ******************************************************************************/
+// @formatter:off
+
+/* Includes ------------------------------------------------------------------*/
+#include "keymap.h"
+
+#include "main.h"
+#include "FreeRTOS.h"
+#include "keyboard.h"
+#include "usb_hid_keys.h"
+
+#include <string.h>
+
+/* Defines -------------------------------------------------------------------*/
+#define POS(row, col)		GET_IDX(col, row, keyboardNUM_COLS)
+
+#define LAYER_BASE			( 0 )
+#define LAYER_FN			( 1 )
+
+/* Private variables ---------------------------------------------------------*/
+/**
+ * Unlisted positions are keymapTRNS and fall through to the layer below, so
+ * upper layers only need the keys they change. Layers are indexed from 0 at
+ * the bottom; higher active layers win.
+ */
+static const uint16_t keymapBuiltin[][keyboardNUM_KEYS] = {
+	[LAYER_BASE] = {
+			[POS(0, 0)] = KEY_Q,
+	},
+	[LAYER_FN] = {
+			[POS(0, 0)] = KEY_1,
+	},
+};
+#define BUILTIN_COUNT		( sizeof(keymapBuiltin) / sizeof(keymapBuiltin[0]) )
+#define LAYER_VALID			( (uint16_t)((1UL << layerCount) - 1) )
+
+_Static_assert(BUILTIN_COUNT <= keymapMAX_LAYERS, "Too many keymap layers");
+
+/* Tables in use, [layerCount][keyboardNUM_KEYS]. Either keymapBuiltin or a
+ * profile stored in the settings flash. */
+static const uint16_t *layers = &keymapBuiltin[0][0];
+static uint8_t layerCount = BUILTIN_COUNT;
+
+/* Swap requested by keymapUseLayers(), applied by the scan task */
+static const uint16_t *volatile nextLayers;
+static volatile uint8_t nextCount;
+static volatile _Bool swapPending;
+
+static keymap_state_t state;
+static uint16_t flat[keyboardNUM_KEYS];	/* Effective action of every key */
+
+/* Static prototypes ---------------------------------------------------------*/
+static void keymapRebuild(void);
+static void keymapApplySwap(void);
+
+/* Code ----------------------------------------------------------------------*/
+/**
+ * @brief Recomputes the effective action of every key for the layer stack
+ * @note Only runs when the layer state changes, so a key event is one load
+ *       from flat[] no matter how many layers are stacked.
+ * @param none
+ * @retval none
+ */
+static void keymapRebuild(void)
+{
+	uint8_t order[keymapMAX_LAYERS];
+	uint8_t depth = 0;
+	uint16_t stack = (state.active | state.oneShot | (1U << state.defaultLayer))
+			& LAYER_VALID;
+
+	for (int ll = layerCount - 1; ll >= 0; ll--)
+	{
+		if (stack & (1U << ll))
+		{
+			order[depth++] = (uint8_t)ll;
+		}
+	}
+	for (int kk = 0; kk < keyboardNUM_KEYS; kk++)
+	{
+		uint16_t action = keymapNO;
+
+		for (int dd = 0; dd < depth; dd++)
+		{
+			uint16_t candidate = layers[order[dd] * keyboardNUM_KEYS + kk];
+
+			if (candidate != keymapTRNS)
+			{
+				action = candidate;
+				break;
+			}
+		}
+		flat[kk] = action;
+	}
+}
+
+/**
+ * @brief Switches to the tables requested by keymapUseLayers(), if any
+ * @note Layers beyond the new table's count are dropped from the state.
+ * @param none
+ * @retval none
+ */
+static void keymapApplySwap(void)
+{
+	UBaseType_t mask;
+
+	if (!swapPending)
+	{
+		return;
+	}
+	mask = portSET_INTERRUPT_MASK_FROM_ISR();
+	layers = nextLayers;
+	layerCount = nextCount;
+	swapPending = 0;
+	portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+
+	state.active &= LAYER_VALID;
+	state.oneShot &= LAYER_VALID;
+	state.oneShotHeld &= LAYER_VALID;
+	if (state.defaultLayer >= layerCount)
+	{
+		state.defaultLayer = LAYER_BASE;
+	}
+	keymapRebuild();
+}
+
+/**
+ * @brief Looks up what a key would do if pressed now, without pressing it
+ * @param key Index of the key in the matrix
+ * @retval The key's action on the current layers
+ */
+uint16_t keymapLookup(uint16_t key)
+{
+	keymapApplySwap();
+	return flat[key];
+}
+
+/**
+ * @brief Resolves a key press against the current layers
+ * @note The caller must keep the returned action and hand that same action to
+ *       keymapRelease(), so a layer change while the key is held can never
+ *       release a different keycode than the one that was pressed.
+ * @param key Index of the key in the matrix
+ * @retval The action the key was pressed with
+ */
+uint16_t keymapPress(uint16_t key)
+{
+	return keymapPressAction(keymapLookup(key));
+}
+
+/**
+ * @brief Presses an action that did not come from the tables
+ * @note Used for the tap or hold half of a dual-role key. Release it with
+ *       keymapRelease() like any other action.
+ * @param action Action to apply
+ * @retval action
+ */
+uint16_t keymapPressAction(uint16_t action)
+{
+	uint16_t bit;
+	keymap_state_t before = state;
+
+	if (keymapKIND(action) == keymapKIND_LAYER)
+	{
+		bit = (uint16_t)(1U << keymapLAYER_NUM(action));
+		switch (keymapLAYER_OP(action))
+		{
+		case keymapOP_MO:
+			state.active |= bit;
+			break;
+		case keymapOP_TG:
+			state.active ^= bit;
+			break;
+		case keymapOP_OSL:
+			state.oneShot |= bit;
+			state.oneShotHeld |= bit;
+			state.oneShotUsed = 0;
+			break;
+		case keymapOP_DF:
+			if (bit & LAYER_VALID)
+			{
+				state.defaultLayer = keymapLAYER_NUM(action);
+			}
+			break;
+		default:
+			break;
+		}
+	}
+	else if (action != keymapNO)
+	{
+		/* This key consumes any one-shot layer that has been let go */
+		state.oneShot &= state.oneShotHeld;
+		state.oneShotUsed = (state.oneShotHeld != 0);
+	}
+
+	if (memcmp(&before, &state, sizeof(state)) != 0)
+	{
+		keymapRebuild();
+	}
+	return action;
+}
+
+/**
+ * @brief Undoes whatever keymapPress() did for an action
+ * @param action The action returned by keymapPress() for this key
+ * @retval none
+ */
+void keymapRelease(uint16_t action)
+{
+	uint16_t bit;
+	keymap_state_t before;
+
+	keymapApplySwap();
+	before = state;
+
+	if (keymapKIND(action) != keymapKIND_LAYER)
+	{
+		return;
+	}
+	bit = (uint16_t)(1U << keymapLAYER_NUM(action));
+	switch (keymapLAYER_OP(action))
+	{
+	case keymapOP_MO:
+		state.active &= ~bit;
+		break;
+	case keymapOP_OSL:
+		state.oneShotHeld &= ~bit;
+		if (state.oneShotUsed)
+		{
+			/* Another key went down while held, so it acted as momentary */
+			state.oneShot &= ~bit;
+		}
+		break;
+	default:
+		break;
+	}
+
+	if (memcmp(&before, &state, sizeof(state)) != 0)
+	{
+		keymapRebuild();
+	}
+}
+
+/**
+ * @brief Copies the layer state
+ * @note Call from the scan task, which owns the state.
+ * @param dst Destination for the state
+ * @retval none
+ */
+void keymapGetState(keymap_state_t *dst)
+{
+	*dst = state;
+}
+
+/**
+ * @brief Replaces the keymap tables
+ * @note O(1) and safe from any context. Nothing is copied: the tables must
+ *       stay valid until the next call. The scan task switches over on the
+ *       next key event, so a key that is down keeps the action it was pressed
+ *       with.
+ * @param actions [numLayers][keyboardNUM_KEYS] actions, or NULL for the
+ *        built-in keymap
+ * @param numLayers Number of layers in actions, 1 to keymapMAX_LAYERS
+ * @retval none
+ */
+void keymapUseLayers(const uint16_t *actions, uint8_t numLayers)
+{
+	UBaseType_t mask;
+
+	if (actions == NULL || numLayers == 0 || numLayers > keymapMAX_LAYERS)
+	{
+		actions = &keymapBuiltin[0][0];
+		numLayers = BUILTIN_COUNT;
+	}
+	mask = portSET_INTERRUPT_MASK_FROM_ISR();
+	nextLayers = actions;
+	nextCount = numLayers;
+	swapPending = 1;
+	portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+}
+
+/**
+ * @brief Reports whether keymapUseLayers() has a swap the scan task has not
+ *        picked up yet
+ * @note While it does, the tables the keymap reads may still be the old ones.
+ * @param none
+ * @retval 1 if a swap is pending
+ */
+_Bool keymapSwapPending(void)
+{
+	return swapPending;
+}
+
+/**
+ * @brief Starts on the base layer and builds the lookup table
+ * @param none
+ * @retval none
+ */
+void keymapInit(void)
+{
+	state = (keymap_state_t) {
+		.defaultLayer = LAYER_BASE
+	};
+	keymapRebuild();
+}
+/* EOF */
@@ -0,0 +1,89 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file keymap.h
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief Definitions and prototypes for the layered keymap
+ ******************************************************************************/
+// @formatter:off
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __KEYMAP_H
+#define __KEYMAP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Defines -------------------------------------------------------------------*/
+#define keymapMAX_LAYERS			( 16 )
+
+/**
+ * Keymap entries are 16 bit actions. The top nibble is the kind, the rest is
+ * kind specific. A plain HID usage is its own action, so ordinary keys in the
+ * tables are just KEY_x from usb_hid_keys.h.
+ */
+#define keymapKIND(act)				( (uint16_t)(act) >> 12 )
+#define keymapKIND_KEY				( 0x0 )	/* HID keyboard usage, mods included */
+#define keymapKIND_MODTAP			( 0x2 )	/* Tap for a usage, hold for a modifier */
+#define keymapKIND_LAYERTAP			( 0x3 )	/* Tap for a usage, hold for a layer */
+#define keymapKIND_LAYER			( 0x5 )	/* Layer operation, see below */
+#define keymapKIND_MACRO			( 0x6 )	/* Macro number, see macro.c */
+
+#define keymapTRNS					( 0x0000 )	/* Falls through to a lower layer */
+#define keymapNO					( 0x0001 )	/* Does nothing, blocks lower layers */
+
+/* Layer actions: 0x5 | op | layer */
+#define keymapLAYER_OP(act)			( ((uint16_t)(act) >> 8) & 0xF )
+#define keymapLAYER_NUM(act)		( (uint16_t)(act) & 0xF )
+#define keymapOP_MO					( 0x1 )	/* Momentary, active while held */
+#define keymapOP_TG					( 0x2 )	/* Toggle on press */
+#define keymapOP_OSL				( 0x3 )	/* One-shot, active for the next key */
+#define keymapOP_DF					( 0x4 )	/* Set the default layer */
+#define keymapLAYER_ACT(op, l)		( (uint16_t)((keymapKIND_LAYER << 12) | ((op) << 8) | ((l) & 0xF)) )
+#define MO(l)						keymapLAYER_ACT(keymapOP_MO, l)
+#define TG(l)						keymapLAYER_ACT(keymapOP_TG, l)
+#define OSL(l)						keymapLAYER_ACT(keymapOP_OSL, l)
+#define DF(l)						keymapLAYER_ACT(keymapOP_DF, l)
+
+/* Dual-role actions, resolved by taphold.c: kind | modifier or layer | usage */
+#define MT(mod, k)					( (uint16_t)((keymapKIND_MODTAP << 12) \
+									| ((((mod) - KEY_LEFTCTRL) & 0x7) << 8) | ((k) & 0xFF)) )
+#define LT(l, k)					( (uint16_t)((keymapKIND_LAYERTAP << 12) \
+									| (((l) & 0xF) << 8) | ((k) & 0xFF)) )
+
+/* Macro actions: 0x6 | macro number */
+#define keymapMACRO_NUM(act)		( (uint16_t)(act) & 0x0FFF )
+#define MACRO(n)					( (uint16_t)((keymapKIND_MACRO << 12) | ((n) & 0x0FFF)) )
+
+/* Structures ----------------------------------------------------------------*/
+typedef struct _KEYMAP_STATE_S_
+{
+	uint16_t active;		/* Momentary and toggled layers, bit per layer */
+	uint16_t oneShot;		/* One-shot layers waiting for their key */
+	uint16_t oneShotHeld;	/* One-shot keys currently held down */
+	uint8_t defaultLayer;	/* Always-on bottom of the stack */
+	_Bool oneShotUsed;		/* A key was pressed while a one-shot was held */
+} keymap_state_t;
+
+/* Prototypes ----------------------------------------------------------------*/
+void keymapInit(void);
+uint16_t keymapLookup(uint16_t key);
+uint16_t keymapPress(uint16_t key);
+uint16_t keymapPressAction(uint16_t action);
+void keymapRelease(uint16_t action);
+void keymapGetState(keymap_state_t *state);
+void keymapUseLayers(const uint16_t *actions, uint8_t numLayers);
+_Bool keymapSwapPending(void);
+
+/* Exported variables --------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __KEYMAP_H */
+/* EOF */
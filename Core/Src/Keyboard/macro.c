@@ -0,0 +1,285 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file macro.c
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief Macro byte code player, one step per HID report
+ ******************************************************************************/
+// @formatter:off
+
+/* Includes ------------------------------------------------------------------*/
+#include "macro.h"
+
+#include "usb_hid_keys.h"
+
+#include <string.h>
+
+/* Defines -------------------------------------------------------------------*/
+#define QUEUE_MASK			( macroQUEUE_LEN - 1 )
+
+_Static_assert((macroQUEUE_LEN & QUEUE_MASK) == 0, "Queue length must be a power of 2");
+
+/* Private variables ---------------------------------------------------------*/
+static const uint8_t macroCopy[] = {
+		macroDOWN(KEY_LEFTCTRL), macroTAP(KEY_C), macroUP(KEY_LEFTCTRL), macroEND
+};
+static const uint8_t macroPaste[] = {
+		macroDOWN(KEY_LEFTCTRL), macroTAP(KEY_V), macroUP(KEY_LEFTCTRL), macroEND
+};
+static const uint8_t macroModelM[] = {
+		macroDOWN(KEY_LEFTSHIFT), macroTAP(KEY_M), macroUP(KEY_LEFTSHIFT),
+		macroTAP(KEY_O), macroTAP(KEY_D), macroTAP(KEY_E), macroTAP(KEY_L),
+		macroTAP(KEY_SPACE), macroWAIT(50),
+		macroDOWN(KEY_LEFTSHIFT), macroTAP(KEY_M), macroUP(KEY_LEFTSHIFT),
+		macroEND
+};
+
+/* Indexed by the number in a keymap MACRO(n) action */
+static const uint8_t *const macroTable[] = {
+		macroCopy, macroPaste, macroModelM
+};
+#define MACRO_COUNT			( sizeof(macroTable) / sizeof(macroTable[0]) )
+
+/* Filled by the scan task, drained by the report task */
+static uint16_t queue[macroQUEUE_LEN];
+static volatile uint8_t queueHead;
+static volatile uint8_t queueTail;
+
+/* Player state, owned by the report task */
+static const uint8_t *pc;		/* Next op of the playing macro, NULL if none */
+static _Bool tapDown;			/* First half of a TAP has been emitted */
+static _Bool waiting;
+static uint32_t resumeAt;
+static macro_overlay_t overlay;
+
+/* Static prototypes ---------------------------------------------------------*/
+static void macroPress(uint8_t usage);
+static void macroRelease(uint8_t usage);
+
+/* Code ----------------------------------------------------------------------*/
+/**
+ * @brief Adds a key to the overlay
+ * @param usage HID usage, modifiers included
+ * @retval none
+ */
+static void macroPress(uint8_t usage)
+{
+	if (usage >= KEY_LEFTCTRL && usage <= KEY_RIGHTMETA)
+	{
+		overlay.modifiers |= 1U << (usage - KEY_LEFTCTRL);
+		return;
+	}
+	for (int ii = 0; ii < 6; ii++)
+	{
+		if (overlay.keys[ii] == usage)
+		{
+			return;
+		}
+	}
+	for (int ii = 0; ii < 6; ii++)
+	{
+		if (overlay.keys[ii] == 0)
+		{
+			overlay.keys[ii] = usage;
+			return;
+		}
+	}
+}
+
+/**
+ * @brief Removes a key from the overlay
+ * @param usage HID usage, modifiers included
+ * @retval none
+ */
+static void macroRelease(uint8_t usage)
+{
+	if (usage >= KEY_LEFTCTRL && usage <= KEY_RIGHTMETA)
+	{
+		overlay.modifiers &= ~(1U << (usage - KEY_LEFTCTRL));
+		return;
+	}
+	for (int ii = 0; ii < 6; ii++)
+	{
+		if (overlay.keys[ii] == usage)
+		{
+			overlay.keys[ii] = 0;
+		}
+	}
+}
+
+/**
+ * @brief Queues a macro for playback
+ * @note Call from the scan task only. Returns at once; the report task plays
+ *       the macro in between live reports.
+ * @param macro Macro number, as in the keymap MACRO(n) action
+ * @retval 1 if queued, 0 if unknown or the queue is full
+ */
+_Bool macroQueue(uint16_t macro)
+{
+	uint8_t head = queueHead;
+
+	if (macro >= MACRO_COUNT || (uint8_t)(head - queueTail) >= macroQUEUE_LEN)
+	{
+		return 0;
+	}
+	queue[head & QUEUE_MASK] = macro;
+	queueHead = head + 1;
+	return 1;
+}
+
+/**
+ * @brief Plays at most one step of the current macro
+ * @note Call from the report task each time the IN endpoint is free, so every
+ *       press and release goes out in its own report. Waits are skipped over
+ *       without consuming a report.
+ * @param nowMs Current time in ms
+ * @param waitMs Set to the time until the next step is due: 0 for the next
+ *        report, macroNO_WAIT if there is nothing left to play
+ * @retval 1 if the overlay changed and a report should be sent
+ */
+_Bool macroStep(uint32_t nowMs, uint32_t *waitMs)
+{
+	for (;;)
+	{
+		if (pc == NULL)
+		{
+			if (queueHead == queueTail)
+			{
+				*waitMs = macroNO_WAIT;
+				return 0;
+			}
+			pc = macroTable[queue[queueTail & QUEUE_MASK]];
+			queueTail = queueTail + 1;
+			tapDown = 0;
+			waiting = 0;
+		}
+		if (waiting)
+		{
+			if ((int32_t)(nowMs - resumeAt) < 0)
+			{
+				*waitMs = resumeAt - nowMs;
+				return 0;
+			}
+			waiting = 0;
+		}
+
+		switch (pc[0])
+		{
+		case macroOP_DOWN:
+			macroPress(pc[1]);
+			pc += 2;
+			break;
+		case macroOP_UP:
+			macroRelease(pc[1]);
+			pc += 2;
+			break;
+		case macroOP_TAP:
+			if (!tapDown)
+			{
+				macroPress(pc[1]);
+				tapDown = 1;
+			}
+			else
+			{
+				macroRelease(pc[1]);
+				tapDown = 0;
+				pc += 2;
+			}
+			break;
+		case macroOP_WAIT:
+			resumeAt = nowMs + pc[1];
+			waiting = 1;
+			pc += 2;
+			continue;
+		case macroOP_END:
+		default:
+		{
+			static const uint8_t noKeys[6];
+
+			/**
+			 * Never leave a key stuck down behind a badly formed macro. Keys
+			 * come up first and modifiers in the next report, as the live
+			 * queue does it, so the host never sees both change at once.
+			 */
+			if (memcmp(overlay.keys, noKeys, sizeof(noKeys)) != 0)
+			{
+				memset(overlay.keys, 0, sizeof(overlay.keys));
+				break;
+			}
+			if (overlay.modifiers)
+			{
+				overlay.modifiers = 0;
+				break;
+			}
+			pc = NULL;
+			continue;
+		}
+		}
+		*waitMs = (pc != NULL || queueHead != queueTail) ? 0 : macroNO_WAIT;
+		return 1;
+	}
+}
+
+/**
+ * @brief Reports whether a macro is playing or queued
+ * @param none
+ * @retval 1 if busy
+ */
+_Bool macroBusy(void)
+{
+	return pc != NULL || queueHead != queueTail;
+}
+
+/**
+ * @brief Adds the keys held by the playing macro to a report
+ * @note Keys already in the report are not repeated; if the report is full
+ *       the macro's keys are dropped.
+ * @param modifiers Report modifier byte
+ * @param keys Report key array
+ * @retval none
+ */
+void macroMerge(uint8_t *modifiers, uint8_t keys[6])
+{
+	*modifiers |= overlay.modifiers;
+	for (int ii = 0; ii < 6; ii++)
+	{
+		uint8_t usage = overlay.keys[ii];
+		int free = -1;
+
+		if (usage == 0)
+		{
+			continue;
+		}
+		for (int jj = 5; jj >= 0; jj--)
+		{
+			if (keys[jj] == usage)
+			{
+				free = -2;
+				break;
+			}
+			if (keys[jj] == 0)
+			{
+				free = jj;
+			}
+		}
+		if (free >= 0)
+		{
+			keys[free] = usage;
+		}
+	}
+}
+
+/**
+ * @brief Stops playback and empties the queue
+ * @param none
+ * @retval none
+ */
+void macroInit(void)
+{
+	pc = NULL;
+	tapDown = 0;
+	waiting = 0;
+	queueTail = queueHead;
+	memset(&overlay, 0, sizeof(overlay));
+}
+/* EOF */
@@ -0,0 +1,65 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file macro.h
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief Definitions and prototypes for macro playback
+ ******************************************************************************/
+// @formatter:off
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __MACRO_H
+#define __MACRO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Defines -------------------------------------------------------------------*/
+#define macroQUEUE_LEN				( 4 )	/* Macros waiting to play, power of 2 */
+#define macroNO_WAIT				( UINT32_MAX )
+
+/**
+ * Macros are byte code kept in flash. Every press or release is one step, and
+ * the player emits one step per report the host has picked up, so the host
+ * sees every intermediate state. Waits cost nothing; delays between steps
+ * shorter than the host poll interval are rounded up to it.
+ */
+#define macroOP_END					( 0x00 )
+#define macroOP_DOWN				( 0x01 )	/* Followed by a HID usage */
+#define macroOP_UP					( 0x02 )	/* Followed by a HID usage */
+#define macroOP_TAP					( 0x03 )	/* Down, then up on the next step */
+#define macroOP_WAIT				( 0x04 )	/* Followed by 1 to 255 ms */
+
+#define macroDOWN(k)				macroOP_DOWN, (k)
+#define macroUP(k)					macroOP_UP, (k)
+#define macroTAP(k)					macroOP_TAP, (k)
+#define macroWAIT(ms)				macroOP_WAIT, (ms)
+#define macroEND					macroOP_END
+
+/* Structures ----------------------------------------------------------------*/
+/* The keys a macro is holding down, merged into the live report */
+typedef struct _MACRO_OVERLAY_S_
+{
+	uint8_t modifiers;
+	uint8_t keys[6];
+} macro_overlay_t;
+
+/* Prototypes ----------------------------------------------------------------*/
+_Bool macroQueue(uint16_t macro);
+_Bool macroStep(uint32_t nowMs, uint32_t *waitMs);
+_Bool macroBusy(void);
+void macroMerge(uint8_t *modifiers, uint8_t keys[6]);
+void macroInit(void);
+
+/* Exported variables --------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MACRO_H */
+/* EOF */
@@ -0,0 +1,249 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file settle.c
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief Measures how long the matrix lines take to settle, per row
+ ******************************************************************************/
+// @formatter:off
+
+/* Includes ------------------------------------------------------------------*/
+#include "settle.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "main.h"
+#include "../Utilities/utils.h"
+
+/**
+ * The scanner used to sleep a hand-picked 5 ms after every row. Two things
+ * actually have to settle:
+ *  - the row line itself after it is driven or released, which the pin's
+ *    input register shows directly even though it is an output, and
+ *  - a column line coming back up through its pull-up after a key on the
+ *    released row let go of it.
+ * The second one cannot be seen with no keys down, so each column is pulled
+ * down with its own (weak, harmless) pull-down and then timed back up through
+ * the pull-up. Nothing is ever driven against anything else.
+ */
+
+/* Defines -------------------------------------------------------------------*/
+#define PUPDR_SHIFT(pin)	( 2U * (uint32_t)__builtin_ctz(pin) )
+#define PUPDR_UP			( 1UL )
+#define PUPDR_DOWN			( 2UL )
+#define PROBE_US			( 50 )	/* Generous wait for the idle check */
+#define FAILED				( UINT32_MAX )
+
+/* Private variables ---------------------------------------------------------*/
+static uint32_t driveUs[keyboardNUM_ROWS];
+static uint32_t releaseUs[keyboardNUM_ROWS];
+static _Bool calibrated;
+static uint32_t lastCheckMs;
+
+/* Static prototypes ---------------------------------------------------------*/
+static uint32_t settleWait(const gpio_struct_t *line, _Bool high);
+static void settlePull(const gpio_struct_t *line, uint32_t pull);
+static _Bool settleKeysUp(const key_matrix_t *kb);
+static uint32_t settleToUs(uint32_t cycles);
+
+/* Code ----------------------------------------------------------------------*/
+/**
+ * @brief Times how long a line takes to read a level
+ * @param line Pin to watch
+ * @param high 1 to wait for high, 0 for low
+ * @retval Cycles taken, or FAILED after settleTIMEOUT_US
+ */
+static uint32_t settleWait(const gpio_struct_t *line, _Bool high)
+{
+	uint32_t limit = settleTIMEOUT_US * (SystemCoreClock / 1000000U);
+	uint32_t start = utilsCYCLES();
+
+	while (((line->port->IDR & line->pin) != 0) != high)
+	{
+		if (utilsCYCLES() - start > limit)
+		{
+			return FAILED;
+		}
+	}
+	return utilsCYCLES() - start;
+}
+
+/**
+ * @brief Switches a column's internal pull resistor
+ * @param line Column pin
+ * @param pull PUPDR_UP or PUPDR_DOWN
+ * @retval none
+ */
+static void settlePull(const gpio_struct_t *line, uint32_t pull)
+{
+	uint32_t shift = PUPDR_SHIFT(line->pin);
+
+	line->port->PUPDR = (line->port->PUPDR & ~(3UL << shift)) | (pull << shift);
+}
+
+/**
+ * @brief Checks that no key is down, raw, without any debouncing
+ * @param kb Keyboard being calibrated
+ * @retval 1 if every column reads high with every row driven in turn
+ */
+static _Bool settleKeysUp(const key_matrix_t *kb)
+{
+	_Bool idle = 1;
+
+	for (int rr = 0; rr < kb->numRows && idle; rr++)
+	{
+		kb->rowPins[rr]->port->BSRR = (uint32_t)kb->rowPins[rr]->pin << 16;
+		utilsDelayUs(PROBE_US);
+		for (int cc = 0; cc < kb->numCols; cc++)
+		{
+			if (!(kb->colPins[cc]->port->IDR & kb->colPins[cc]->pin))
+			{
+				idle = 0;
+			}
+		}
+		kb->rowPins[rr]->port->BSRR = kb->rowPins[rr]->pin;
+		utilsDelayUs(PROBE_US);
+	}
+	return idle;
+}
+
+/**
+ * @brief Converts core cycles to whole microseconds, rounding up
+ * @param cycles Cycle count
+ * @retval Microseconds
+ */
+static uint32_t settleToUs(uint32_t cycles)
+{
+	uint32_t perUs = SystemCoreClock / 1000000U;
+
+	return (cycles + perUs - 1) / perUs;
+}
+
+/**
+ * @brief Measures the matrix and programs per-row waits into the scanner
+ * @note Call from the scan task between frames, with the rows released. Each
+ *       sample runs in a critical section of at most settleTIMEOUT_US so an
+ *       interrupt cannot stretch it. Nothing changes unless every line
+ *       settles and no key is down.
+ * @param kb Keyboard to calibrate
+ * @retval 1 if the new waits were applied
+ */
+_Bool settleCalibrate(const key_matrix_t *kb)
+{
+	uint32_t fall[keyboardNUM_ROWS] = { 0 };
+	uint32_t rise[keyboardNUM_ROWS] = { 0 };
+	uint32_t column = 0;
+	uint32_t sample;
+	_Bool ok = 1;
+	_Bool changed = 0;
+
+	utilsCycleCounterInit();
+	if (!settleKeysUp(kb))
+	{
+		return 0;
+	}
+
+	for (int cc = 0; cc < kb->numCols && ok; cc++)
+	{
+		for (int ss = 0; ss < settleSAMPLES && ok; ss++)
+		{
+			taskENTER_CRITICAL();
+			settlePull(kb->colPins[cc], PUPDR_DOWN);
+			ok = (settleWait(kb->colPins[cc], 0) != FAILED);
+			settlePull(kb->colPins[cc], PUPDR_UP);
+			sample = ok ? settleWait(kb->colPins[cc], 1) : FAILED;
+			taskEXIT_CRITICAL();
+			ok = ok && (sample != FAILED);
+			if (ok && sample > column)
+			{
+				column = sample;
+			}
+		}
+	}
+
+	for (int rr = 0; rr < kb->numRows && ok; rr++)
+	{
+		const gpio_struct_t *row = kb->rowPins[rr];
+
+		for (int ss = 0; ss < settleSAMPLES && ok; ss++)
+		{
+			taskENTER_CRITICAL();
+			row->port->BSRR = (uint32_t)row->pin << 16;
+			sample = settleWait(row, 0);
+			if (sample != FAILED && sample > fall[rr])
+			{
+				fall[rr] = sample;
+			}
+			ok = (sample != FAILED);
+			row->port->BSRR = row->pin;
+			sample = settleWait(row, 1);
+			taskEXIT_CRITICAL();
+			ok = ok && (sample != FAILED);
+			if (ok && sample > rise[rr])
+			{
+				rise[rr] = sample;
+			}
+		}
+	}
+	if (!ok)
+	{
+		return 0;
+	}
+
+	for (int rr = 0; rr < kb->numRows; rr++)
+	{
+		uint32_t drive = settleMARGIN(settleToUs(fall[rr]));
+		uint32_t release = settleMARGIN(settleToUs(rise[rr] + column));
+
+		changed = changed || drive != driveUs[rr] || release != releaseUs[rr];
+		driveUs[rr] = drive;
+		releaseUs[rr] = release;
+	}
+	/* Rechecks run every settleRECHECK_MS, only say so when a wait moved */
+	if (changed || !calibrated)
+	{
+		os_printf("Settle: column %luus, row 0 drive %luus release %luus\r\n",
+				settleToUs(column), driveUs[0], releaseUs[0]);
+	}
+	calibrated = 1;
+	return 1;
+}
+
+/**
+ * @brief Re-runs the calibration now and then while the keyboard is idle
+ * @note Cheap when there is nothing to do, call it once per frame.
+ * @param kb Keyboard to calibrate
+ * @retval none
+ */
+void settleRecheck(const key_matrix_t *kb)
+{
+	uint32_t now = HAL_GetTick();
+
+	if (now - lastCheckMs < settleRECHECK_MS || !keyboardIsIdle(settleIDLE_MS))
+	{
+		return;
+	}
+	lastCheckMs = now;
+	settleCalibrate(kb);
+}
+
+/**
+ * @brief Wait between driving a row and reading the columns
+ * @param row Row index
+ * @retval Microseconds
+ */
+uint32_t settleDriveUs(uint8_t row)
+{
+	return calibrated ? driveUs[row] : settleDEFAULT_DRIVE_US;
+}
+
+/**
+ * @brief Wait between releasing a row and driving the next one
+ * @param row Row index
+ * @retval Microseconds
+ */
+uint32_t settleReleaseUs(uint8_t row)
+{
+	return calibrated ? releaseUs[row] : settleDEFAULT_RELEASE_US;
+}
+/* EOF */
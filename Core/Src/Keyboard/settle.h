@@ -0,0 +1,47 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file settle.h
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief Definitions and prototypes for matrix settle time calibration
+ ******************************************************************************/
+// @formatter:off
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __SETTLE_H
+#define __SETTLE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "keyboard.h"
+
+/* Defines -------------------------------------------------------------------*/
+#define settleSAMPLES				( 8 )	/* Worst of this many per line */
+#define settleTIMEOUT_US			( 1000 )	/* A line slower than this fails */
+#define settleMARGIN(us)			( (us) * 2 + 2 )	/* Measured to programmed, us */
+
+/* Until calibration succeeds, the hand-tuned wait the scanner always had */
+#define settleDEFAULT_DRIVE_US		( 0 )
+#define settleDEFAULT_RELEASE_US	( 5000 )
+
+/* Runtime re-check, only while nobody is typing */
+#define settleRECHECK_MS			( 60000 )
+#define settleIDLE_MS				( 1000 )
+
+/* Prototypes ----------------------------------------------------------------*/
+_Bool settleCalibrate(const key_matrix_t *kb);
+void settleRecheck(const key_matrix_t *kb);
+uint32_t settleDriveUs(uint8_t row);
+uint32_t settleReleaseUs(uint8_t row);
+
+/* Exported variables --------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SETTLE_H */
+/* EOF */
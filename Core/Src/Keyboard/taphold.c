@@ -0,0 +1,256 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file taphold.c
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief Tap-hold state machine on the debounced key event stream
+ ******************************************************************************/
+// @formatter:off
+
+/* Includes ------------------------------------------------------------------*/
+#include "taphold.h"
+
+#include "keymap.h"
+#include "usb_hid_keys.h"
+
+#include <string.h>
+
+/**
+ * Nothing in here touches hardware, the RTOS or the keymap tables directly:
+ * time comes in as arguments and keys go through taphold_ops_t. The same file
+ * can therefore be built on a host and fed recorded event traces.
+ */
+
+/* Defines -------------------------------------------------------------------*/
+#define IS_DUAL_ROLE(act)	( keymapKIND(act) == keymapKIND_MODTAP \
+							|| keymapKIND(act) == keymapKIND_LAYERTAP )
+
+/* Private types -------------------------------------------------------------*/
+typedef struct _TAPHOLD_EVENT_S_
+{
+	uint16_t key;
+	_Bool pressed;
+	uint32_t timeMs;
+} taphold_event_t;
+
+/* Private variables ---------------------------------------------------------*/
+static taphold_config_t cfg;
+static taphold_ops_t ops;
+
+/* The dual-role key waiting for a decision, if any */
+static _Bool undecided;
+static uint16_t pendKey;
+static uint16_t pendAction;
+static uint32_t pendSince;
+
+/* Events that arrived after it, in order */
+static taphold_event_t buffer[tapholdBUFFER_LEN];
+static uint8_t buffered;
+
+/* A tap's release, held back so the host sees the press first */
+static _Bool tapUp;
+static uint16_t tapKey;
+static uint32_t tapAt;
+
+/* Static prototypes ---------------------------------------------------------*/
+static void tapholdHandle(uint16_t key, _Bool pressed, uint32_t nowMs);
+static void tapholdResolve(_Bool hold, uint32_t nowMs);
+static void tapholdFlushTap(void);
+static _Bool tapholdBuffered(uint16_t key);
+
+/* Code ----------------------------------------------------------------------*/
+/**
+ * @brief Runs one event through the state machine
+ * @param key Index of the key in the matrix
+ * @param pressed 1 on press, 0 on release
+ * @param nowMs Time of the event
+ * @retval none
+ */
+static void tapholdHandle(uint16_t key, _Bool pressed, uint32_t nowMs)
+{
+	uint16_t action;
+
+	if (!undecided)
+	{
+		if (pressed)
+		{
+			action = ops.lookup(key);
+			if (IS_DUAL_ROLE(action))
+			{
+				undecided = 1;
+				pendKey = key;
+				pendAction = action;
+				pendSince = nowMs;
+				return;
+			}
+		}
+		/* Everything else goes straight through */
+		ops.emit(key, pressed, keymapTRNS);
+		return;
+	}
+
+	if (key == pendKey && !pressed)
+	{
+		/* Let go inside the tapping term */
+		tapholdResolve(0, nowMs);
+		return;
+	}
+	if (buffered == tapholdBUFFER_LEN || (pressed && cfg.holdOnOtherKey))
+	{
+		tapholdResolve(1, nowMs);
+		tapholdHandle(key, pressed, nowMs);
+		return;
+	}
+	if (!pressed && !tapholdBuffered(key))
+	{
+		/* Went down before the dual-role key, order is not at stake */
+		ops.emit(key, pressed, keymapTRNS);
+		return;
+	}
+	buffer[buffered++] = (taphold_event_t) {
+		.key = key,
+				.pressed = pressed,
+				.timeMs = nowMs
+	};
+	if (!pressed && cfg.permissiveHold)
+	{
+		/* A whole tap of another key nested inside it */
+		tapholdResolve(1, nowMs);
+	}
+}
+
+/**
+ * @brief Decides the pending key and replays what was held back behind it
+ * @param hold 1 to resolve as a hold, 0 as a tap
+ * @param nowMs Time of the decision
+ * @retval none
+ */
+static void tapholdResolve(_Bool hold, uint32_t nowMs)
+{
+	taphold_event_t replay[tapholdBUFFER_LEN];
+	uint8_t count = buffered;
+	uint16_t arg = (pendAction >> 8) & 0xF;
+	uint16_t action;
+
+	if (hold)
+	{
+		action = (keymapKIND(pendAction) == keymapKIND_MODTAP)
+				? (uint16_t)(KEY_LEFTCTRL + (arg & 0x7)) : MO(arg);
+	}
+	else
+	{
+		action = pendAction & 0xFF;
+		tapholdFlushTap();
+	}
+	undecided = 0;
+	memcpy(replay, buffer, count * sizeof(taphold_event_t));
+	buffered = 0;
+
+	ops.emit(pendKey, 1, action);
+	if (!hold)
+	{
+		tapUp = 1;
+		tapKey = pendKey;
+		tapAt = nowMs + tapholdTAP_RELEASE_MS;
+	}
+	/* May leave another dual-role key pending; it re-buffers the rest */
+	for (int ii = 0; ii < count; ii++)
+	{
+		tapholdHandle(replay[ii].key, replay[ii].pressed, replay[ii].timeMs);
+	}
+}
+
+/**
+ * @brief Emits a held back tap release now
+ * @param none
+ * @retval none
+ */
+static void tapholdFlushTap(void)
+{
+	if (tapUp)
+	{
+		tapUp = 0;
+		ops.emit(tapKey, 0, keymapTRNS);
+	}
+}
+
+/**
+ * @brief Tells whether a key's press is among the held back events
+ * @param key Index of the key in the matrix
+ * @retval 1 if it is
+ */
+static _Bool tapholdBuffered(uint16_t key)
+{
+	for (int ii = 0; ii < buffered; ii++)
+	{
+		if (buffer[ii].key == key && buffer[ii].pressed)
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/**
+ * @brief Feeds a debounced key edge into the resolver
+ * @note Keys that are not dual-role are emitted before this returns, unless a
+ *       dual-role key is still undecided. Then they wait for its decision,
+ *       which comes within one tapping term.
+ * @param key Index of the key in the matrix
+ * @param pressed 1 on press, 0 on release
+ * @param nowMs Time of the edge
+ * @retval none
+ */
+void tapholdEvent(uint16_t key, _Bool pressed, uint32_t nowMs)
+{
+	tapholdTick(nowMs);
+	if (tapUp && key == tapKey)
+	{
+		tapholdFlushTap();
+	}
+	tapholdHandle(key, pressed, nowMs);
+}
+
+/**
+ * @brief Applies the tapping term and releases finished taps
+ * @note Call regularly from the scan task while tapholdPending() is true.
+ * @param nowMs Current time
+ * @retval none
+ */
+void tapholdTick(uint32_t nowMs)
+{
+	if (tapUp && (int32_t)(nowMs - tapAt) >= 0)
+	{
+		tapholdFlushTap();
+	}
+	if (undecided && (int32_t)(nowMs - pendSince) >= (int32_t)cfg.tappingTermMs)
+	{
+		tapholdResolve(1, nowMs);
+	}
+}
+
+/**
+ * @brief Tells whether the resolver is waiting on time
+ * @param none
+ * @retval 1 if tapholdTick() has work to do
+ */
+_Bool tapholdPending(void)
+{
+	return undecided || tapUp;
+}
+
+/**
+ * @brief Sets the policies and callbacks and forgets any pending state
+ * @param config Tapping term and policies, copied
+ * @param callbacks Keymap lookup and event output, copied
+ * @retval none
+ */
+void tapholdInit(const taphold_config_t *config, const taphold_ops_t *callbacks)
+{
+	cfg = *config;
+	ops = *callbacks;
+	undecided = 0;
+	buffered = 0;
+	tapUp = 0;
+}
+/* EOF */
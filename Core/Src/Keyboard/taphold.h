@@ -0,0 +1,62 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file taphold.h
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief Definitions and prototypes for dual-role (tap-hold) key resolution
+ ******************************************************************************/
+// @formatter:off
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __TAPHOLD_H
+#define __TAPHOLD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Defines -------------------------------------------------------------------*/
+#define tapholdTAPPING_TERM_MS		( 200 )	/* Held this long, it is a hold */
+#define tapholdTAP_RELEASE_MS		( 10 )	/* Gap between a tap's press and release */
+#define tapholdBUFFER_LEN			( 8 )	/* Events held back while undecided */
+
+/* Structures ----------------------------------------------------------------*/
+/**
+ * Policies for a dual-role key that is still down when another key is used.
+ * With neither set, only the tapping term decides.
+ */
+typedef struct _TAPHOLD_CONFIG_S_
+{
+	uint16_t tappingTermMs;
+	_Bool permissiveHold;	/* Another key tapped inside it makes it a hold */
+	_Bool holdOnOtherKey;	/* Another key pressed makes it a hold at once */
+} taphold_config_t;
+
+/**
+ * Resolved events go out through emit(). override is keymapTRNS for a key the
+ * keymap should resolve itself, or the action a dual-role key resolved to.
+ * lookup() must not change keymap state.
+ */
+typedef struct _TAPHOLD_OPS_S_
+{
+	uint16_t (*lookup)(uint16_t key);
+	void (*emit)(uint16_t key, _Bool pressed, uint16_t override);
+} taphold_ops_t;
+
+/* Prototypes ----------------------------------------------------------------*/
+void tapholdInit(const taphold_config_t *config, const taphold_ops_t *callbacks);
+void tapholdEvent(uint16_t key, _Bool pressed, uint32_t nowMs);
+void tapholdTick(uint32_t nowMs);
+_Bool tapholdPending(void);
+
+/* Exported variables --------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TAPHOLD_H */
+/* EOF */
@@ -0,0 +1,172 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file power.c
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief Tickless idle built on the TIM5 time base
+ ******************************************************************************/
+// @formatter:off
+
+/* Includes ------------------------------------------------------------------*/
+#include "power.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "main.h"
+#include "../Utilities/utils.h"
+
+/* Defines -------------------------------------------------------------------*/
+
+/* Global variables ---------------------------------------------------------*/
+extern TIM_HandleTypeDef htim5;
+
+/* Private variables ---------------------------------------------------------*/
+static power_stats_t powerStats;
+
+/* Static prototypes ---------------------------------------------------------*/
+
+/* Code ----------------------------------------------------------------------*/
+/**
+ * @brief Replaces the port's SysTick based portSUPPRESS_TICKS_AND_SLEEP()
+ * @note The wake-up timer is channel 1 of the free-running 1 kHz TIM5 counter
+ *       that also serves HAL_GetTick(), so no second timer is needed and the
+ *       HAL time base never stops. The kernel's expected idle time already
+ *       accounts for the scan task's next wake and any reporter timeout; USB
+ *       traffic ends the sleep early through its own interrupt.
+ * @note STOP mode is not used: it halts both TIM5 and the 48 MHz USB clock,
+ *       so it is only safe while the bus is suspended, which the PCD suspend
+ *       callback already handles.
+ * @param xExpectedIdleTime Number of ticks until the next task must run
+ * @retval none
+ */
+void powerSuppressTicksAndSleep(uint32_t xExpectedIdleTime)
+{
+	uint32_t start;
+	uint32_t slept;
+	uint32_t cycles;
+	uint32_t cyclesPerTick = SystemCoreClock / configTICK_RATE_HZ;
+	TickType_t xModifiableIdleTime;
+
+	if (xExpectedIdleTime > powerMAX_SUPPRESSED_TICKS)
+	{
+		xExpectedIdleTime = powerMAX_SUPPRESSED_TICKS;
+	}
+
+	/**
+	 * Stop the tick and mask interrupts with PRIMASK rather than BASEPRI so a
+	 * pending interrupt still ends WFI.
+	 */
+	SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+	__disable_irq();
+	__DSB();
+	__ISB();
+
+	if (eTaskConfirmSleepModeStatus() == eAbortSleep)
+	{
+		SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+		powerStats.aborts++;
+		__enable_irq();
+		return;
+	}
+
+	/**
+	 * Wake one tick early: the restarted SysTick delivers the final tick, which
+	 * keeps vTaskStepTick() from stepping past the next unblock time.
+	 */
+	start = __HAL_TIM_GET_COUNTER(&htim5);
+	__HAL_TIM_SET_COMPARE(&htim5, TIM_CHANNEL_1, start + xExpectedIdleTime - 1);
+	__HAL_TIM_CLEAR_FLAG(&htim5, TIM_FLAG_CC1);
+	__HAL_TIM_ENABLE_IT(&htim5, TIM_IT_CC1);
+
+	cycles = utilsCYCLES();
+	xModifiableIdleTime = xExpectedIdleTime;
+	configPRE_SLEEP_PROCESSING(&xModifiableIdleTime);
+	if (xModifiableIdleTime > 0)
+	{
+		__DSB();
+		__WFI();
+		__ISB();
+	}
+	configPOST_SLEEP_PROCESSING(&xExpectedIdleTime);
+
+	if (!__HAL_TIM_GET_FLAG(&htim5, TIM_FLAG_CC1))
+	{
+		powerStats.earlyWakes++;
+	}
+	__HAL_TIM_DISABLE_IT(&htim5, TIM_IT_CC1);
+	__HAL_TIM_CLEAR_FLAG(&htim5, TIM_FLAG_CC1);
+	HAL_NVIC_ClearPendingIRQ(TIM5_IRQn);
+
+	slept = __HAL_TIM_GET_COUNTER(&htim5) - start;
+	if (slept > xExpectedIdleTime - 1)
+	{
+		slept = xExpectedIdleTime - 1;
+	}
+
+	/**
+	 * The DWT cycle counter that times run time stats stops with the core clock
+	 * in WFI unless a debugger holds it on. Credit the sleep back from TIM5 so
+	 * the idle task's CPU share stays honest, to within a tick per sleep.
+	 */
+	cycles = utilsCYCLES() - cycles;
+	if (cycles + cyclesPerTick < slept * cyclesPerTick)
+	{
+		DWT->CYCCNT += slept * cyclesPerTick - cycles;
+	}
+
+	/**
+	 * Restart the tick on a full period. The fraction of the tick that was
+	 * running when we stopped is lost, so the kernel tick drifts slightly
+	 * against TIM5; HAL time is unaffected because it reads TIM5 directly.
+	 */
+	SysTick->VAL = 0;
+	SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+	vTaskStepTick(slept);
+
+	powerStats.sleeps++;
+	powerStats.ticksRequested += xExpectedIdleTime;
+	powerStats.ticksSlept += slept;
+
+	__enable_irq();
+}
+
+/**
+ * @brief Copies the sleep residency counters
+ * @param stats Destination for the counters
+ * @retval none
+ */
+void powerGetStats(power_stats_t *stats)
+{
+	taskENTER_CRITICAL();
+	*stats = powerStats;
+	taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief Clears the sleep residency counters and restarts the window
+ * @param none
+ * @retval none
+ */
+void powerClearStats(void)
+{
+	taskENTER_CRITICAL();
+	powerStats = (power_stats_t) {
+		.since = HAL_GetTick()
+	};
+	taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief Enables the TIM5 wake-up interrupt used by tickless idle
+ * @param none
+ * @retval none
+ */
+void powerInit(void)
+{
+	powerStats = (power_stats_t) {
+		.since = HAL_GetTick()
+	};
+	HAL_NVIC_SetPriority(TIM5_IRQn, powerWAKE_IRQ_PRIORITY, 0);
+	HAL_NVIC_EnableIRQ(TIM5_IRQn);
+}
+/* EOF */
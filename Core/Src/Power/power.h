@@ -0,0 +1,51 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file power.h
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief Definitions and prototypes for tickless idle and sleep accounting
+ ******************************************************************************/
+// @formatter:off
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __POWER_H
+#define __POWER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx_hal.h"
+#include "main.h"
+
+/* Defines -------------------------------------------------------------------*/
+/* Longest stretch the tick may be suppressed for, in ticks */
+#define powerMAX_SUPPRESSED_TICKS	( 1000 )
+#define powerWAKE_IRQ_PRIORITY		( 15 )
+
+/* Structures ----------------------------------------------------------------*/
+typedef struct _POWER_STATS_S_
+{
+	uint32_t sleeps;		/* Number of times the core entered WFI */
+	uint32_t aborts;		/* Sleeps abandoned because a task became ready */
+	uint32_t ticksRequested;/* Sum of the idle times the kernel offered */
+	uint32_t ticksSlept;	/* Sum of the ticks actually spent asleep */
+	uint32_t earlyWakes;	/* Sleeps ended by an interrupt other than TIM5 */
+	uint32_t since;			/* HAL tick at which the counters were cleared */
+} power_stats_t;
+
+/* Prototypes ----------------------------------------------------------------*/
+void powerInit(void);
+void powerSuppressTicksAndSleep(uint32_t xExpectedIdleTime);
+void powerGetStats(power_stats_t *stats);
+void powerClearStats(void);
+
+/* Exported variables --------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __POWER_H */
+/* EOF */
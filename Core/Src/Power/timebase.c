@@ -0,0 +1,120 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file timebase.c
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief HAL time base on a free-running TIM5 counter
+ ******************************************************************************/
+// @formatter:off
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx_hal.h"
+#include "stm32f4xx_hal_tim.h"
+
+/**
+ * These override the HAL's weak SysTick time base. The CubeMX project keeps
+ * SysTick as its time base so that regenerating the code leaves this file,
+ * the TIM5 interrupt handler and main.c alone; CubeMX would otherwise write
+ * its stock 1 kHz update-interrupt version of all three over them.
+ *
+ * TIM5 is a 32-bit timer, so with a 1 kHz counter clock its CNT register
+ * wraps at exactly the same point as the 32-bit uwTick it replaces. No
+ * update interrupt is enabled; the only periodic interrupt left in the
+ * system is the FreeRTOS SysTick, and power.c uses channel 1 to wake from
+ * tickless idle.
+ */
+
+/* Defines -------------------------------------------------------------------*/
+#define TIMEBASE_CLOCK_HZ	( 1000U )	/* One count per HAL tick */
+
+/* Global variables ---------------------------------------------------------*/
+TIM_HandleTypeDef htim5;
+
+/* Code ----------------------------------------------------------------------*/
+/**
+ * @brief Configures TIM5 as a free-running time base
+ * @note Called by HAL_Init() after reset and by HAL_RCC_ClockConfig() whenever
+ *       the clocks change. The count is kept across re-configuration so time
+ *       does not jump backwards when the system clock is switched. The 16-bit
+ *       prescaler limits the TIM5 kernel clock to 65.536 MHz.
+ * @param TickPriority Unused, the time base does not interrupt
+ * @retval HAL status
+ */
+HAL_StatusTypeDef HAL_InitTick(uint32_t TickPriority)
+{
+	RCC_ClkInitTypeDef clkconfig;
+	uint32_t timClock;
+	uint32_t prescaler;
+	uint32_t counter = 0;
+	uint32_t flashLatency;
+
+	UNUSED(TickPriority);
+	__HAL_RCC_TIM5_CLK_ENABLE();
+	/* Freeze TIM5 while the core is halted so HAL timeouts survive debugging */
+	__HAL_DBGMCU_FREEZE_TIM5();
+
+	/* APB1 timers run at twice PCLK1 unless APB1 is undivided */
+	HAL_RCC_GetClockConfig(&clkconfig, &flashLatency);
+	timClock = HAL_RCC_GetPCLK1Freq();
+	if (clkconfig.APB1CLKDivider != RCC_HCLK_DIV1)
+	{
+		timClock *= 2U;
+	}
+	prescaler = timClock / TIMEBASE_CLOCK_HZ - 1U;
+	if (prescaler > 0xFFFFU)
+	{
+		return HAL_ERROR;
+	}
+
+	if (htim5.Instance == TIM5)
+	{
+		counter = __HAL_TIM_GET_COUNTER(&htim5);
+	}
+	htim5.Instance = TIM5;
+	htim5.Init.Period = 0xFFFFFFFFU;
+	htim5.Init.Prescaler = prescaler;
+	htim5.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+	htim5.Init.CounterMode = TIM_COUNTERMODE_UP;
+	htim5.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+	if (HAL_TIM_Base_Init(&htim5) != HAL_OK)
+	{
+		return HAL_ERROR;
+	}
+	/* HAL_TIM_Base_Init() forces an update event, which clears the counter */
+	__HAL_TIM_SET_COUNTER(&htim5, counter);
+	return HAL_TIM_Base_Start(&htim5);
+}
+
+/**
+ * @brief Provides the tick in ms
+ * @note Reads the TIM5 counter, so it is valid before the scheduler starts,
+ *       inside critical sections and while the RTOS tick is suppressed.
+ * @param none
+ * @retval Tick
+ */
+uint32_t HAL_GetTick(void)
+{
+	return TIM5->CNT;
+}
+
+/**
+ * @brief Suspends the tick
+ * @note Nothing to do: the time base has no interrupt, and the counter keeps
+ *       running through WFI so HAL timeouts stay right.
+ * @param none
+ * @retval none
+ */
+void HAL_SuspendTick(void)
+{
+}
+
+/**
+ * @brief Resumes the tick
+ * @note See HAL_SuspendTick().
+ * @param none
+ * @retval none
+ */
+void HAL_ResumeTick(void)
+{
+}
+/* EOF */
@@ -0,0 +1,619 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file settings.c
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief Log-structured settings store in two internal flash sectors
+ ******************************************************************************/
+// @formatter:off
+
+/* Includes ------------------------------------------------------------------*/
+#include "settings.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "main.h"
+#include "../Keyboard/keyboard.h"
+#include "../Keyboard/keymap.h"
+
+#include <string.h>
+
+/* Defines -------------------------------------------------------------------*/
+#define ALIGN4(x)			( ((x) + 3U) & ~3U )
+#define ERASED_WORD			( 0xFFFFFFFFUL )
+#define NO_PROFILE			( 0xFF )
+
+/* Private types -------------------------------------------------------------*/
+typedef struct _SETTINGS_PENDING_S_
+{
+	uint16_t key;
+	uint16_t length;
+	uint16_t offset;		/* Payload position in staging[] */
+	uint16_t filled;		/* Payload bytes received so far */
+	_Bool ready;			/* Payload complete, may be programmed */
+} settings_pending_t;
+
+/* Global variables ---------------------------------------------------------*/
+extern const uint8_t _settings_start[];	/* From the linker script */
+
+/* Private variables ---------------------------------------------------------*/
+static StackType_t settingsStack[settingsSTACK_SIZE];
+static StaticTask_t settingsTcb;
+static TaskHandle_t settingsTask;
+
+/* Latest valid record for each key, pointing into the active page */
+static const settings_record_t *recordIndex[settingsMAX_KEYS];
+static const uint8_t *activePage;		/* NULL until a page has been formatted */
+static const uint8_t *appendAt;		/* First free byte of the active page */
+static _Bool spareDirty;				/* Spare page needs erasing before use */
+static uint8_t activeProfile = NO_PROFILE;
+
+static uint8_t staging[settingsSTAGING_SIZE] __attribute__((aligned(4)));
+static uint16_t stagingUsed;
+static settings_pending_t pending[settingsMAX_PENDING];
+static uint8_t pendingCount;
+
+/* Static prototypes ---------------------------------------------------------*/
+static void settingsTaskLoop(void *pvParameters);
+static void settingsMount(void);
+static void settingsFlush(void);
+static _Bool settingsCompact(uint32_t need);
+static void settingsEraseSpare(void);
+static const settings_record_t *settingsProgram(const uint8_t *at,
+		uint16_t key, const void *data, uint16_t length);
+static uint32_t settingsCrc(uint16_t key, uint16_t length, const void *data);
+static _Bool settingsRecordValid(const settings_record_t *rec);
+static void settingsApplyProfile(void);
+static void settingsNotify(void);
+
+/* Code ----------------------------------------------------------------------*/
+/**
+ * @brief Programs staged records and erases the spare page when it is safe
+ * @note Runs at the lowest application priority, so the scan task preempts it
+ *       between any two flash words. The only long stall, the sector erase,
+ *       waits for the matrix to go quiet.
+ * @param pvParameters UNUSED, for FreeRTOS consistency only
+ * @retval none
+ */
+static void settingsTaskLoop(void *pvParameters)
+{
+	UNUSED(pvParameters);
+	for (;;)
+	{
+		xTaskNotifyWait(0, UINT32_MAX, NULL, spareDirty ?
+				pdMS_TO_TICKS(settingsERASE_POLL_MS) : portMAX_DELAY);
+		if (spareDirty && keyboardIsIdle(settingsERASE_IDLE_MS)
+				&& !keymapSwapPending())
+		{
+			settingsEraseSpare();
+		}
+		settingsFlush();
+	}
+}
+
+/**
+ * @brief Finds the newest complete page and indexes its records
+ * @note A record whose header is torn ends the walk; the page is then treated
+ *       as full so the next write compacts into the spare page.
+ * @param none
+ * @retval none
+ */
+static void settingsMount(void)
+{
+	const settings_page_t *page;
+	const uint8_t *end;
+	const uint8_t *at;
+	uint32_t bestSeq = 0;
+
+	activePage = NULL;
+	for (int pp = 0; pp < 2; pp++)
+	{
+		page = (const settings_page_t *)(_settings_start + pp * settingsPAGE_SIZE);
+		if (page->magic == settingsPAGE_MAGIC && page->sequence != ERASED_WORD
+				&& (activePage == NULL || page->sequence > bestSeq))
+		{
+			activePage = (const uint8_t *)page;
+			bestSeq = page->sequence;
+		}
+	}
+	memset(recordIndex, 0, sizeof(recordIndex));
+	if (activePage == NULL)
+	{
+		spareDirty = 1;
+		return;
+	}
+
+	end = activePage + settingsPAGE_SIZE;
+	at = activePage + sizeof(settings_page_t);
+	while (at + sizeof(settings_record_t) <= end)
+	{
+		const settings_record_t *rec = (const settings_record_t *)at;
+
+		if (rec->key == 0xFFFF && rec->length == 0xFFFF)
+		{
+			break;
+		}
+		if (at + sizeof(settings_record_t) + ALIGN4(rec->length) > end)
+		{
+			at = end;
+			break;
+		}
+		if (rec->key < settingsMAX_KEYS && settingsRecordValid(rec))
+		{
+			recordIndex[rec->key] = rec;
+		}
+		at += sizeof(settings_record_t) + ALIGN4(rec->length);
+	}
+	appendAt = at;
+
+	/* Whatever the other sector holds is stale until proven erased */
+	spareDirty = 0;
+	at = _settings_start + ((activePage == _settings_start) ? settingsPAGE_SIZE : 0);
+	for (uint32_t ii = 0; ii < settingsPAGE_SIZE; ii += 4)
+	{
+		if (*(const uint32_t *)(at + ii) != ERASED_WORD)
+		{
+			spareDirty = 1;
+			break;
+		}
+	}
+}
+
+/**
+ * @brief Programs every staged record that is ready, oldest first
+ * @param none
+ * @retval none
+ */
+static void settingsFlush(void)
+{
+	settings_pending_t next;
+	const settings_record_t *rec;
+	uint32_t need;
+	UBaseType_t mask;
+
+	while (pendingCount && pending[0].ready)
+	{
+		next = pending[0];
+		need = sizeof(settings_record_t) + ALIGN4(next.length);
+		if (activePage == NULL || appendAt + need > activePage + settingsPAGE_SIZE)
+		{
+			if (spareDirty)
+			{
+				return;		/* Retried once the spare page has been erased */
+			}
+			if (!settingsCompact(need))
+			{
+				/* Can never fit, drop it rather than wedge the queue */
+				next.key = 0xFFFF;
+			}
+		}
+		if (next.key != 0xFFFF)
+		{
+			rec = settingsProgram(appendAt, next.key, &staging[next.offset],
+					next.length);
+			mask = portSET_INTERRUPT_MASK_FROM_ISR();
+			if (rec != NULL)
+			{
+				recordIndex[next.key] = rec;
+				appendAt += need;
+			}
+			else
+			{
+				/**
+				 * The record is abandoned, and so is the rest of the page: its
+				 * header may be torn, so nothing after it can be trusted. The
+				 * next write compacts into the spare page.
+				 */
+				appendAt = activePage + settingsPAGE_SIZE;
+			}
+			portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+			if (rec != NULL && next.key >= settingsKEY_KEYMAP(0)
+					&& next.key == settingsKEY_KEYMAP(activeProfile))
+			{
+				settingsApplyProfile();
+			}
+		}
+
+		mask = portSET_INTERRUPT_MASK_FROM_ISR();
+		memmove(&pending[0], &pending[1], --pendingCount * sizeof(settings_pending_t));
+		if (pendingCount == 0)
+		{
+			stagingUsed = 0;
+		}
+		portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+	}
+}
+
+/**
+ * @brief Copies the live records into the erased spare page and switches to it
+ * @note The new page header is programmed last, so a reset mid-compaction
+ *       leaves the old page in charge. Users of in-place data are re-pointed
+ *       before the old page is marked for erasing. Every record is checked
+ *       against the end of the spare page before it is programmed, and the
+ *       compaction gives up as soon as one would not fit.
+ * @param need Bytes the caller is about to append
+ * @retval 1 if there is now room for need bytes, otherwise 0
+ */
+static _Bool settingsCompact(uint32_t need)
+{
+	const uint8_t *spare;
+	const uint8_t *at;
+	const settings_record_t *moved[settingsMAX_KEYS] = { 0 };
+	uint32_t size;
+	uint32_t sequence;
+	UBaseType_t mask;
+	_Bool ok;
+
+	spare = (activePage == _settings_start) ? _settings_start + settingsPAGE_SIZE
+			: _settings_start;
+	at = spare + sizeof(settings_page_t);
+	for (int kk = 0; kk < settingsMAX_KEYS; kk++)
+	{
+		const settings_record_t *rec = recordIndex[kk];
+
+		if (rec == NULL)
+		{
+			continue;
+		}
+		size = sizeof(settings_record_t) + ALIGN4(rec->length);
+		if (at + size + need > spare + settingsPAGE_SIZE)
+		{
+			/**
+			 * Stop before programming past the sector: the next one is code.
+			 * Nothing was switched over, the partly written spare is just dirty.
+			 */
+			spareDirty = 1;
+			return 0;
+		}
+		moved[kk] = settingsProgram(at, rec->key, rec + 1, rec->length);
+		if (moved[kk] == NULL)
+		{
+			spareDirty = 1;
+			return 0;
+		}
+		at += size;
+	}
+	if (at + need > spare + settingsPAGE_SIZE)
+	{
+		spareDirty = 1;
+		return 0;
+	}
+
+	sequence = activePage ? ((const settings_page_t *)activePage)->sequence + 1 : 1;
+	HAL_FLASH_Unlock();
+	ok = HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, (uint32_t)(uintptr_t)spare + 4,
+			sequence) == HAL_OK
+			&& HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, (uint32_t)(uintptr_t)spare,
+					settingsPAGE_MAGIC) == HAL_OK;
+	HAL_FLASH_Lock();
+	if (!ok)
+	{
+		/* Without its magic the page never mounts, the old one stays active */
+		spareDirty = 1;
+		return 0;
+	}
+
+	mask = portSET_INTERRUPT_MASK_FROM_ISR();
+	memcpy(recordIndex, moved, sizeof(recordIndex));
+	activePage = spare;
+	appendAt = at;
+	portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+
+	settingsApplyProfile();
+	spareDirty = 1;
+	return 1;
+}
+
+/**
+ * @brief Erases whichever sector is not the active page
+ * @param none
+ * @retval none
+ */
+static void settingsEraseSpare(void)
+{
+	FLASH_EraseInitTypeDef erase;
+	uint32_t error;
+
+	erase = (FLASH_EraseInitTypeDef) {
+		.TypeErase = FLASH_TYPEERASE_SECTORS,
+				.Sector = (activePage == _settings_start) ? settingsPAGE_SECTOR_B
+						: settingsPAGE_SECTOR_A,
+				.NbSectors = 1,
+				.VoltageRange = FLASH_VOLTAGE_RANGE_3
+	};
+	HAL_FLASH_Unlock();
+	if (HAL_FLASHEx_Erase(&erase, &error) == HAL_OK)
+	{
+		spareDirty = 0;
+	}
+	HAL_FLASH_Lock();
+}
+
+/**
+ * @brief Programs one record at the given address
+ * @note Key and length go first and the CRC last, so a record torn by a
+ *       reset can still be stepped over but never validates.
+ * @param at Word aligned, erased destination
+ * @param key Record key
+ * @param data Payload
+ * @param length Payload bytes
+ * @retval The record as it now sits in flash, NULL if a word failed to
+ *         program; whatever was written of it is then torn
+ */
+static const settings_record_t *settingsProgram(const uint8_t *at,
+		uint16_t key, const void *data, uint16_t length)
+{
+	const uint8_t *src = data;
+	uint32_t addr = (uint32_t)(uintptr_t)at;
+	uint32_t word;
+	_Bool ok;
+
+	HAL_FLASH_Unlock();
+	ok = HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, addr,
+			((uint32_t)length << 16) | key) == HAL_OK;
+	for (uint32_t ii = 0; ok && ii < length; ii += 4)
+	{
+		word = ERASED_WORD;
+		memcpy(&word, src + ii, (length - ii < 4U) ? length - ii : 4U);
+		ok = HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD,
+				addr + sizeof(settings_record_t) + ii, word) == HAL_OK;
+	}
+	ok = ok && HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, addr + 4,
+			settingsCrc(key, length, data)) == HAL_OK;
+	HAL_FLASH_Lock();
+	return ok ? (const settings_record_t *)at : NULL;
+}
+
+/**
+ * @brief CRC-32 (IEEE) over a record's key, length and payload
+ * @param key Record key
+ * @param length Payload bytes
+ * @param data Payload
+ * @retval CRC
+ */
+static uint32_t settingsCrc(uint16_t key, uint16_t length, const void *data)
+{
+	const uint8_t head[4] = { key, key >> 8, length, length >> 8 };
+	const uint8_t *src = data;
+	uint32_t crc = ERASED_WORD;
+
+	for (uint32_t ii = 0; ii < 4U + length; ii++)
+	{
+		crc ^= (ii < 4) ? head[ii] : src[ii - 4];
+		for (int bb = 0; bb < 8; bb++)
+		{
+			crc = (crc >> 1) ^ (0xEDB88320UL & -(crc & 1));
+		}
+	}
+	return ~crc;
+}
+
+/**
+ * @brief Checks a record's CRC
+ * @param rec Record in flash
+ * @retval 1 if intact
+ */
+static _Bool settingsRecordValid(const settings_record_t *rec)
+{
+	return rec->crc == settingsCrc(rec->key, rec->length, rec + 1);
+}
+
+/**
+ * @brief Points the keymap at the active profile's record, wherever it is now
+ * @param none
+ * @retval none
+ */
+static void settingsApplyProfile(void)
+{
+	const settings_keymap_t *map;
+	uint16_t length;
+
+	if (activeProfile == NO_PROFILE)
+	{
+		return;
+	}
+	map = settingsGet(settingsKEY_KEYMAP(activeProfile), &length);
+	if (map != NULL && length >= sizeof(settings_keymap_t)
+			&& map->numKeys == keyboardNUM_KEYS
+			&& map->numLayers >= 1 && map->numLayers <= keymapMAX_LAYERS
+			&& length >= sizeof(settings_keymap_t)
+					+ map->numLayers * keyboardNUM_KEYS * sizeof(uint16_t))
+	{
+		keymapUseLayers(map->actions, (uint8_t)map->numLayers);
+	}
+	else
+	{
+		keymapUseLayers(NULL, 0);
+	}
+}
+
+/**
+ * @brief Wakes the settings task from a task or an interrupt
+ * @param none
+ * @retval none
+ */
+static void settingsNotify(void)
+{
+	BaseType_t woken = pdFALSE;
+
+	if (settingsTask == NULL)
+	{
+		return;
+	}
+	if (xPortIsInsideInterrupt())
+	{
+		vTaskNotifyGiveFromISR(settingsTask, &woken);
+		portYIELD_FROM_ISR(woken);
+	}
+	else
+	{
+		xTaskNotifyGive(settingsTask);
+	}
+}
+
+/**
+ * @brief Looks up the latest value of a setting
+ * @note Zero-copy: the pointer is into memory-mapped flash. It stays valid
+ *       until the next compaction, so copy small values and let the keymap
+ *       be re-pointed by settingsSelectProfile() for large ones.
+ * @param key Record key
+ * @param length Set to the payload length, may be NULL
+ * @retval Payload, or NULL if the setting has never been written
+ */
+const void *settingsGet(uint16_t key, uint16_t *length)
+{
+	const settings_record_t *rec;
+
+	if (key >= settingsMAX_KEYS)
+	{
+		return NULL;
+	}
+	rec = recordIndex[key];
+	if (rec == NULL)
+	{
+		return NULL;
+	}
+	if (length != NULL)
+	{
+		*length = rec->length;
+	}
+	return rec + 1;
+}
+
+/**
+ * @brief Stages a setting to be written in the background
+ * @note Returns immediately; the settings task programs the record later.
+ *       Safe from tasks and from the USB interrupt.
+ * @param key Record key
+ * @param data Payload, copied before returning
+ * @param length Payload bytes
+ * @retval pdPASS if staged, pdFAIL if the staging area is full
+ */
+BaseType_t settingsWrite(uint16_t key, const void *data, uint16_t length)
+{
+	return settingsWritePart(key, 0, length, data, length);
+}
+
+/**
+ * @brief Stages one piece of a setting that arrives in pieces
+ * @note For records bigger than a control transfer, such as a keymap sent
+ *       from the host. Pieces must come in order; the record is only
+ *       programmed once the last one is in. A new piece at offset 0 drops an
+ *       unfinished record. Safe from tasks and from the USB interrupt.
+ * @param key Record key
+ * @param offset Position of data within the payload
+ * @param total Payload bytes of the whole record
+ * @param data Piece of the payload, copied before returning
+ * @param length Bytes in this piece
+ * @retval pdPASS if staged, pdFAIL if out of order or the staging area is full
+ */
+BaseType_t settingsWritePart(uint16_t key, uint16_t offset, uint16_t total,
+		const void *data, uint16_t length)
+{
+	settings_pending_t *part;
+	UBaseType_t mask;
+	BaseType_t result = pdFAIL;
+
+	if (key >= settingsMAX_KEYS || (uint32_t)offset + length > total)
+	{
+		return pdFAIL;
+	}
+	mask = portSET_INTERRUPT_MASK_FROM_ISR();
+	/* Only the newest record can be unfinished */
+	part = pendingCount ? &pending[pendingCount - 1] : NULL;
+	if (part != NULL && !part->ready && offset == 0)
+	{
+		stagingUsed = part->offset;
+		pendingCount--;
+		part = NULL;
+	}
+	if (offset == 0 && pendingCount < settingsMAX_PENDING
+			&& stagingUsed + ALIGN4(total) <= settingsSTAGING_SIZE)
+	{
+		part = &pending[pendingCount++];
+		*part = (settings_pending_t) {
+			.key = key,
+					.length = total,
+					.offset = stagingUsed
+		};
+		stagingUsed += ALIGN4(total);
+	}
+	else if (offset == 0 || part == NULL || part->ready || part->key != key
+			|| part->length != total || part->filled != offset)
+	{
+		part = NULL;
+	}
+	if (part != NULL)
+	{
+		memcpy(&staging[part->offset + offset], data, length);
+		part->filled = offset + length;
+		part->ready = (part->filled == part->length);
+		result = pdPASS;
+	}
+	portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+	if (result == pdPASS && part->ready)
+	{
+		settingsNotify();
+	}
+	return result;
+}
+
+/**
+ * @brief Switches the keymap to a stored profile
+ * @note O(1): the keymap is re-pointed at the profile's record in flash and
+ *       picks it up on the next key event. The choice is persisted in the
+ *       background. Safe from tasks and from the USB interrupt.
+ * @param profile Profile number, 0 to settingsMAX_PROFILES - 1
+ * @retval pdPASS if the profile exists, otherwise pdFAIL
+ */
+BaseType_t settingsSelectProfile(uint8_t profile)
+{
+	const uint8_t *stored;
+
+	if (profile >= settingsMAX_PROFILES
+			|| settingsGet(settingsKEY_KEYMAP(profile), NULL) == NULL)
+	{
+		return pdFAIL;
+	}
+	activeProfile = profile;
+	settingsApplyProfile();
+	stored = settingsGet(settingsKEY_PROFILE, NULL);
+	if (stored == NULL || *stored != profile)
+	{
+		settingsWrite(settingsKEY_PROFILE, &profile, sizeof(profile));
+	}
+	return pdPASS;
+}
+
+/**
+ * @brief Reports the active profile and how full the log is
+ * @param stats Destination for the counters
+ * @retval none
+ */
+void settingsGetStats(settings_stats_t *stats)
+{
+	UBaseType_t mask;
+
+	mask = portSET_INTERRUPT_MASK_FROM_ISR();
+	*stats = (settings_stats_t) {
+		.profile = activeProfile,
+				.pending = pendingCount,
+				.used = activePage ? (uint16_t)(appendAt - activePage) : 0
+	};
+	portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+}
+
+/**
+ * @brief Mounts the settings log and creates the background writer
+ * @note Must run before keyboardInit(), which reads its settings from here.
+ * @param none
+ * @retval none
+ */
+void settingsInit(void)
+{
+	settingsMount();
+	settingsTask = xTaskCreateStatic(settingsTaskLoop, "settings",
+			settingsSTACK_SIZE, NULL, settingsPRIORITY, settingsStack,
+			&settingsTcb);
+}
+/* EOF */
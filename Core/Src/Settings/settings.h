@@ -0,0 +1,108 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file settings.h
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief Definitions and prototypes for the flash settings log
+ ******************************************************************************/
+// @formatter:off
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __SETTINGS_H
+#define __SETTINGS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx_hal.h"
+#include "main.h"
+#include "FreeRTOS.h"
+
+/* Defines -------------------------------------------------------------------*/
+#define settingsSTACK_SIZE			( 256 )
+#define settingsPRIORITY			( tskIDLE_PRIORITY + 1 )
+
+/* Flash layout, must match the SETTINGS region in STM32F401RETX_FLASH.ld */
+#define settingsPAGE_SIZE			( 16 * 1024 )
+#define settingsPAGE_SECTOR_A		FLASH_SECTOR_1
+#define settingsPAGE_SECTOR_B		FLASH_SECTOR_2
+#define settingsPAGE_MAGIC			( 0x54544553UL )	/* "SETT" */
+
+/* Pending writes are staged in RAM until the settings task programs them */
+#define settingsMAX_PENDING			( 4 )
+#define settingsSTAGING_SIZE		( 2048 )
+
+/**
+ * Erasing a sector stalls every flash access, code fetches included, for a
+ * few hundred ms. Erases only happen once the matrix has been quiet this long.
+ */
+#define settingsERASE_IDLE_MS		( 2000 )
+#define settingsERASE_POLL_MS		( 500 )
+
+/* Record keys */
+#define settingsMAX_KEYS			( 32 )
+#define settingsKEY_DEBOUNCE		( 1 )	/* uint16_t, ms */
+#define settingsKEY_PROFILE			( 2 )	/* uint8_t, active keymap profile */
+#define settingsKEY_DEBOUNCE_MAP	( 3 )	/* uint8_t[], 4 bit level per key */
+#define settingsKEY_SCAN_ACTIVE		( 4 )	/* uint16_t, ms at full scan rate */
+#define settingsKEY_COMBOS			( 5 )	/* combo_def_t[], read at boot */
+#define settingsKEY_KEYMAP(n)		( 16 + (n) )	/* settings_keymap_t */
+#define settingsMAX_PROFILES		( 8 )
+
+/* Commands of HID feature report 7, see usb_hid_settings_cmd_t */
+#define settingsCMD_WRITE			( 0 )	/* Stage a piece of a record */
+#define settingsCMD_SELECT			( 1 )	/* Switch to the profile in key */
+
+/* Structures ----------------------------------------------------------------*/
+typedef struct _SETTINGS_PAGE_S_
+{
+	uint32_t magic;			/* settingsPAGE_MAGIC once the page is complete */
+	uint32_t sequence;		/* Higher is newer, bumped at every compaction */
+} settings_page_t;
+
+/**
+ * Records are appended after the page header and padded to a word. The CRC
+ * covers key, length and payload, so a record torn by a reset is skipped.
+ * An erased key (0xFFFF) marks the end of the log.
+ */
+typedef struct _SETTINGS_RECORD_S_
+{
+	uint16_t key;
+	uint16_t length;		/* Payload bytes, excluding this header */
+	uint32_t crc;
+} settings_record_t;
+
+/* Payload of a settingsKEY_KEYMAP(n) record, used in place from flash */
+typedef struct _SETTINGS_KEYMAP_S_
+{
+	uint16_t numLayers;
+	uint16_t numKeys;		/* Must equal keyboardNUM_KEYS */
+	uint16_t actions[];		/* [numLayers][numKeys] */
+} settings_keymap_t;
+
+typedef struct _SETTINGS_STATS_S_
+{
+	uint8_t profile;		/* Active profile, 0xFF while on the built-in keymap */
+	uint8_t pending;		/* Records staged, not yet programmed */
+	uint16_t used;			/* Bytes of the active page in use, header included */
+} settings_stats_t;
+
+/* Prototypes ----------------------------------------------------------------*/
+void settingsInit(void);
+const void *settingsGet(uint16_t key, uint16_t *length);
+BaseType_t settingsWrite(uint16_t key, const void *data, uint16_t length);
+BaseType_t settingsWritePart(uint16_t key, uint16_t offset, uint16_t total,
+		const void *data, uint16_t length);
+BaseType_t settingsSelectProfile(uint8_t profile);
+void settingsGetStats(settings_stats_t *stats);
+
+/* Exported variables --------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SETTINGS_H */
+/* EOF */
@@ -0,0 +1,214 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file telemetry.c
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief Per-task CPU share, stack high-water and activation length telemetry
+ ******************************************************************************/
+// @formatter:off
+
+/* Includes ------------------------------------------------------------------*/
+#include "telemetry.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "main.h"
+#include "usbd_hid.h"
+#include "../Utilities/utils.h"
+#include "../UsbInterface/usb_if.h"
+
+#include <string.h>
+
+/* Defines -------------------------------------------------------------------*/
+/* Longest window whose cycle counts cannot have wrapped at 64 MHz */
+#define telemetryMAX_WINDOW_MS		( 60000 )
+
+_Static_assert(sizeof(telemetry_snapshot_t) == HID_TELEMETRY_REPORT_SIZE,
+		"Telemetry snapshot no longer matches the HID feature report");
+
+/* Private variables ---------------------------------------------------------*/
+static StackType_t telemetryStack[telemetrySTACK_SIZE];
+static StaticTask_t telemetryTcb;
+static TaskStatus_t taskStatus[telemetryMAX_TASKS];
+static telemetry_snapshot_t working;
+static telemetry_snapshot_t published;
+
+/* Indexed by TCB number, written from the context switch */
+static uint32_t switchedInAt[telemetryMAX_TASKS];
+static uint32_t peakCycles[telemetryMAX_TASKS];
+
+/* Counters at the previous sample, indexed by TCB number */
+static uint32_t lastRunTime[telemetryMAX_TASKS];
+static uint32_t lastTotalTime;
+static uint32_t lastSampleMs;
+static uint32_t lastReportsSent;
+
+/* Static prototypes ---------------------------------------------------------*/
+static void telemetryTask(void *pvParameters);
+static void telemetrySample(void);
+
+/* Code ----------------------------------------------------------------------*/
+/**
+ * @brief Refreshes the published snapshot once per period
+ * @note Sampling only runs while the host has us configured, because that
+ *       is the only time anyone can read it.
+ * @param pvParameters UNUSED, for FreeRTOS consistency only
+ * @retval none
+ */
+static void telemetryTask(void *pvParameters)
+{
+	UNUSED(pvParameters);
+	for (;;)
+	{
+		xEventGroupWaitBits(utilsEvents, utilsEVT_USB_CONFIGURED, pdFALSE,
+				pdTRUE, portMAX_DELAY);
+		vTaskDelay(pdMS_TO_TICKS(telemetryPERIOD_MS));
+		telemetrySample();
+	}
+}
+
+/**
+ * @brief Builds a snapshot from the kernel's task table and publishes it
+ * @note CPU share is the change in each task's run time counter over the
+ *       change in total run time since the previous sample. A window long
+ *       enough for the cycle counter to have wrapped (e.g. the first sample
+ *       after re-enumeration) only re-baselines and reports a zero window.
+ * @param none
+ * @retval none
+ */
+static void telemetrySample(void)
+{
+	UBaseType_t count;
+	uint32_t totalTime;
+	uint32_t totalDelta;
+	uint32_t now = HAL_GetTick();
+	uint32_t windowMs = now - lastSampleMs;
+	uint32_t cyclesPerUs = SystemCoreClock / 1000000U;
+	usbif_stats_t usb;
+	_Bool validWindow;
+
+	count = uxTaskGetSystemState(taskStatus, telemetryMAX_TASKS, &totalTime);
+	totalDelta = totalTime - lastTotalTime;
+	validWindow = (windowMs <= telemetryMAX_WINDOW_MS) && (totalDelta != 0);
+
+	working.id = HID_TELEMETRY_REPORT_ID;
+	working.numTasks = 0;
+	working.windowMs = validWindow ? (uint16_t)MIN(windowMs, UINT16_MAX) : 0;
+	working.uptimeMs = now;
+	usbifGetStats(&usb);
+	working.reportsSent = usb.reportsSent;
+	working.reportsPerSec = (validWindow && windowMs != 0) ? (uint16_t)MIN(
+			(uint64_t)(usb.reportsSent - lastReportsSent) * 1000U / windowMs,
+			UINT16_MAX) : 0;
+	working.reportDrops = (uint16_t)MIN(usb.changeDrops, UINT16_MAX);
+	working.pollMs = (uint16_t)usb.pollMs;
+	lastReportsSent = usb.reportsSent;
+	for (UBaseType_t ii = 0; ii < count; ii++)
+	{
+		TaskStatus_t *status = &taskStatus[ii];
+		telemetry_task_t *entry;
+		UBaseType_t slot = status->xTaskNumber;
+		uint32_t runDelta;
+
+		if (slot >= telemetryMAX_TASKS)
+		{
+			continue;
+		}
+		runDelta = status->ulRunTimeCounter - lastRunTime[slot];
+		lastRunTime[slot] = status->ulRunTimeCounter;
+
+		entry = &working.tasks[working.numTasks++];
+		strncpy(entry->name, status->pcTaskName, telemetryNAME_LEN);
+		entry->cpuPermille = validWindow ?
+				(uint16_t)(((uint64_t)runDelta * 1000U) / totalDelta) : 0;
+		entry->stackFree = status->usStackHighWaterMark;
+		entry->maxRunUs = peakCycles[slot] / cyclesPerUs;
+	}
+	memset(&working.tasks[working.numTasks], 0,
+			(telemetryMAX_TASKS - working.numTasks) * sizeof(telemetry_task_t));
+	powerGetStats(&working.power);
+	governorGetStats(&working.governor);
+	lastTotalTime = totalTime;
+	lastSampleMs = now;
+
+	taskENTER_CRITICAL();
+	published = working;
+	taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief Copies the most recent snapshot
+ * @note Safe to call from the USB interrupt.
+ * @param snapshot Destination for the snapshot
+ * @retval none
+ */
+void telemetryGetSnapshot(telemetry_snapshot_t *snapshot)
+{
+	UBaseType_t mask = taskENTER_CRITICAL_FROM_ISR();
+	*snapshot = published;
+	taskEXIT_CRITICAL_FROM_ISR(mask);
+}
+
+/**
+ * @brief Restarts the worst-case activation tracking for every task
+ * @param none
+ * @retval none
+ */
+void telemetryClearPeaks(void)
+{
+	taskENTER_CRITICAL();
+	memset(peakCycles, 0, sizeof(peakCycles));
+	taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief traceTASK_SWITCHED_IN() hook, stamps the start of an activation
+ * @note Runs inside the context switch, keep it short.
+ * @param ulTaskNumber TCB number of the task about to run
+ * @retval none
+ */
+void telemetryTaskSwitchedIn(uint32_t ulTaskNumber)
+{
+	if (ulTaskNumber < telemetryMAX_TASKS)
+	{
+		switchedInAt[ulTaskNumber] = utilsCYCLES();
+	}
+}
+
+/**
+ * @brief traceTASK_SWITCHED_OUT() hook, records the longest activation
+ * @note Runs inside the context switch, keep it short. Time spent in ISRs
+ *       during the activation is included, and so is tickless sleep for the
+ *       idle task, whose peak is therefore the longest sleep.
+ * @param ulTaskNumber TCB number of the task being switched out
+ * @retval none
+ */
+void telemetryTaskSwitchedOut(uint32_t ulTaskNumber)
+{
+	uint32_t run;
+
+	if (ulTaskNumber < telemetryMAX_TASKS)
+	{
+		run = utilsCYCLES() - switchedInAt[ulTaskNumber];
+		if (run > peakCycles[ulTaskNumber])
+		{
+			peakCycles[ulTaskNumber] = run;
+		}
+	}
+}
+
+/**
+ * @brief Starts the cycle counter and creates the sampling task
+ * @param none
+ * @retval none
+ */
+void telemetryInit(void)
+{
+	utilsCycleCounterInit();
+	published = (telemetry_snapshot_t) {
+		.id = HID_TELEMETRY_REPORT_ID
+	};
+	xTaskCreateStatic(telemetryTask, "telem", telemetrySTACK_SIZE, NULL,
+			telemetryPRIORITY, telemetryStack, &telemetryTcb);
+}
+/* EOF */
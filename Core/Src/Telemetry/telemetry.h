@@ -0,0 +1,76 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file telemetry.h
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief Definitions and prototypes for task runtime and stack telemetry
+ ******************************************************************************/
+// @formatter:off
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __TELEMETRY_H
+#define __TELEMETRY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx_hal.h"
+#include "main.h"
+#include "../Power/power.h"
+#include "../Keyboard/governor.h"
+
+/* Defines -------------------------------------------------------------------*/
+#define telemetrySTACK_SIZE			( configMINIMAL_STACK_SIZE )
+#define telemetryPRIORITY			( tskIDLE_PRIORITY + 1 )
+#define telemetryPERIOD_MS			( 1000 )
+
+/* Tasks are tracked by TCB number, anything created later than this is not */
+#define telemetryMAX_TASKS			( 8 )
+#define telemetryNAME_LEN			( 8 )
+
+/* Structures ----------------------------------------------------------------*/
+typedef struct _TELEMETRY_TASK_S_
+{
+	char name[telemetryNAME_LEN];	/* Task name, truncated, not terminated */
+	uint16_t cpuPermille;	/* Share of the CPU over the last window */
+	uint16_t stackFree;		/* Stack high-water mark, words never touched */
+	uint32_t maxRunUs;		/* Longest single activation since cleared */
+} telemetry_task_t;
+
+/**
+ * Exported as-is as HID feature report 3, so the layout is the wire format.
+ * All fields are naturally aligned and little endian.
+ */
+typedef struct _TELEMETRY_SNAPSHOT_S_
+{
+	uint8_t id;				/* HID report ID */
+	uint8_t numTasks;		/* Valid entries in tasks[] */
+	uint16_t windowMs;		/* Length of the window cpuPermille covers */
+	uint32_t uptimeMs;		/* HAL tick when the snapshot was taken */
+	uint32_t reportsSent;	/* Keyboard reports since boot */
+	uint16_t reportsPerSec;	/* Over the last window */
+	uint16_t reportDrops;	/* Key changes lost since boot, saturating */
+	uint16_t pollMs;		/* Host's IN poll interval as measured, 0 until known */
+	uint16_t reserved;
+	telemetry_task_t tasks[telemetryMAX_TASKS];
+	power_stats_t power;	/* Tickless sleep residency since powerClearStats() */
+	governor_stats_t governor;	/* Time and wakes per scan rate, level changes */
+} telemetry_snapshot_t;
+
+/* Prototypes ----------------------------------------------------------------*/
+void telemetryInit(void);
+void telemetryGetSnapshot(telemetry_snapshot_t *snapshot);
+void telemetryClearPeaks(void);
+void telemetryTaskSwitchedIn(uint32_t ulTaskNumber);
+void telemetryTaskSwitchedOut(uint32_t ulTaskNumber);
+
+/* Exported variables --------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TELEMETRY_H */
+/* EOF */
@@ -0,0 +1,346 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file trace.c
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief Binary event recorder fed by the FreeRTOS trace macros and ISRs
+ ******************************************************************************/
+// @formatter:off
+
+/* Includes ------------------------------------------------------------------*/
+#include "trace.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "main.h"
+#include "../Utilities/utils.h"
+
+#include <string.h>
+
+/* Defines -------------------------------------------------------------------*/
+#define LATENCY_IDLE		( 0 )	/* No key edge waiting on the host */
+#define LATENCY_PENDING		( 1 )	/* Edge seen, report not yet queued */
+#define LATENCY_QUEUED		( 2 )	/* Report carrying the edge is queued */
+#define CLAMP16(x)			( (uint16_t)((x) > UINT16_MAX ? UINT16_MAX : (x)) )
+
+_Static_assert((traceBUFFER_EVENTS & (traceBUFFER_EVENTS - 1)) == 0,
+		"traceBUFFER_EVENTS must be a power of two");
+
+/* Global variables ---------------------------------------------------------*/
+trace_recorder_t traceRecorder;
+
+/* Private variables ---------------------------------------------------------*/
+static uint16_t readOffset;
+static uint32_t edgeAt;
+static uint8_t latencyState;
+static uint8_t runningTask;		/* TCB number, for hooks outside tasks.c */
+
+/* Static prototypes ---------------------------------------------------------*/
+
+/* Code ----------------------------------------------------------------------*/
+/**
+ * @brief Appends one event to the ring unless the recorder is frozen
+ * @note Callable from any context. Masking is done with BASEPRI so it nests
+ *       inside kernel critical sections and ISRs at or below the syscall
+ *       priority, which is every interrupt in this firmware.
+ * @param type What happened
+ * @param arg Event specific, usually a TCB number
+ * @param data Event specific
+ * @retval none
+ */
+void traceEvent(trace_event_type_t type, uint8_t arg, uint16_t data)
+{
+	UBaseType_t mask;
+	trace_event_t *evt;
+
+	if (traceRecorder.frozen)
+	{
+		return;
+	}
+	mask = portSET_INTERRUPT_MASK_FROM_ISR();
+	if (!traceRecorder.frozen)
+	{
+		evt = &traceRecorder.events[traceRecorder.head & (traceBUFFER_EVENTS - 1)];
+		evt->cycles = utilsCYCLES();
+		evt->type = (uint8_t)type;
+		evt->arg = arg;
+		evt->data = data;
+		traceRecorder.head++;
+		if (traceRecorder.postTrigger && --traceRecorder.postTrigger == 0)
+		{
+			traceRecorder.frozen = traceFROZEN_LATENCY;
+		}
+	}
+	portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+}
+
+/**
+ * @brief Records entry to the current interrupt handler
+ * @param none
+ * @retval none
+ */
+void traceIsrEnter(void)
+{
+	traceEvent(traceEVT_ISR_ENTER, (uint8_t)__get_IPSR(), 0);
+}
+
+/**
+ * @brief Records exit from the current interrupt handler
+ * @param none
+ * @retval none
+ */
+void traceIsrExit(void)
+{
+	traceEvent(traceEVT_ISR_EXIT, (uint8_t)__get_IPSR(), 0);
+}
+
+/**
+ * @brief Records a debounced key change and starts a latency measurement
+ * @note Only the oldest outstanding edge is timed; edges arriving while one
+ *       is in flight are recorded but not measured.
+ * @param key Index of the key in the matrix
+ * @param pressed 1 for a press, 0 for a release
+ * @retval none
+ */
+void traceKeyEdge(uint16_t key, uint8_t pressed)
+{
+	UBaseType_t mask;
+
+	traceEvent(traceEVT_KEY_EDGE, pressed, key);
+	mask = portSET_INTERRUPT_MASK_FROM_ISR();
+	if (latencyState == LATENCY_IDLE)
+	{
+		edgeAt = utilsCYCLES();
+		latencyState = LATENCY_PENDING;
+	}
+	portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+}
+
+/**
+ * @brief Records that a report was handed to the IN endpoint
+ * @param none
+ * @retval none
+ */
+void traceReportQueued(void)
+{
+	UBaseType_t mask;
+
+	traceEvent(traceEVT_REPORT_QUEUED, 0, 0);
+	mask = portSET_INTERRUPT_MASK_FROM_ISR();
+	if (latencyState == LATENCY_PENDING)
+	{
+		latencyState = LATENCY_QUEUED;
+	}
+	portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+}
+
+/**
+ * @brief Records that the host collected a report, closing any measurement
+ * @note Runs in the USB interrupt. A breach of the threshold arms the post
+ *       trigger count, and the recorder freezes once that many more events
+ *       have been logged.
+ * @param none
+ * @retval none
+ */
+void traceReportSent(void)
+{
+	UBaseType_t mask;
+	uint32_t latencyUs = 0;
+	_Bool trigger = 0;
+
+	mask = portSET_INTERRUPT_MASK_FROM_ISR();
+	if (latencyState == LATENCY_QUEUED)
+	{
+		latencyUs = (utilsCYCLES() - edgeAt) / (SystemCoreClock / 1000000U);
+		latencyState = LATENCY_IDLE;
+		if (latencyUs > traceRecorder.worstLatencyUs)
+		{
+			traceRecorder.worstLatencyUs = latencyUs;
+		}
+		trigger = traceRecorder.thresholdUs && latencyUs > traceRecorder.thresholdUs
+				&& !traceRecorder.postTrigger && !traceRecorder.frozen;
+	}
+	traceEvent(traceEVT_REPORT_SENT, 0, CLAMP16(latencyUs));
+	if (trigger)
+	{
+		traceEvent(traceEVT_TRIGGER, 0, CLAMP16(latencyUs));
+		traceRecorder.postTrigger = tracePOST_TRIGGER_EVENTS;
+	}
+	portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+}
+
+/**
+ * @brief Controls the recorder, see traceCMD_x
+ * @note Safe to call from the USB interrupt.
+ * @param cmd Command
+ * @param arg Command argument, if any
+ * @retval none
+ */
+void traceCommand(uint8_t cmd, uint32_t arg)
+{
+	UBaseType_t mask = portSET_INTERRUPT_MASK_FROM_ISR();
+
+	switch (cmd)
+	{
+	case traceCMD_RESTART:
+		traceRecorder.head = 0;
+		traceRecorder.postTrigger = 0;
+		traceRecorder.worstLatencyUs = 0;
+		traceRecorder.frozen = traceFROZEN_NO;
+		latencyState = LATENCY_IDLE;
+		readOffset = 0;
+		break;
+	case traceCMD_FREEZE:
+		if (!traceRecorder.frozen)
+		{
+			traceRecorder.frozen = traceFROZEN_MANUAL;
+		}
+		break;
+	case traceCMD_THRESHOLD:
+		traceRecorder.thresholdUs = arg;
+		break;
+	case traceCMD_REWIND:
+		readOffset = 0;
+		break;
+	default:
+		break;
+	}
+	portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+}
+
+/**
+ * @brief Copies the next piece of the recorder image for export
+ * @note Reads walk the whole trace_recorder_t and wrap to the start. Freeze
+ *       first, or the image will mix old and new events.
+ * @param dst Destination buffer
+ * @param len Bytes wanted
+ * @param offset Set to the image offset the copied bytes came from
+ * @retval Number of bytes copied
+ */
+uint16_t traceRead(uint8_t *dst, uint16_t len, uint16_t *offset)
+{
+	uint16_t count;
+
+	*offset = readOffset;
+	count = sizeof(trace_recorder_t) - readOffset;
+	if (count > len)
+	{
+		count = len;
+	}
+	memcpy(dst, (uint8_t *)&traceRecorder + readOffset, count);
+	readOffset += count;
+	if (readOffset >= sizeof(trace_recorder_t))
+	{
+		readOffset = 0;
+	}
+	return count;
+}
+
+/**
+ * @brief traceTASK_CREATE() hook, keeps a name for each TCB number
+ * @param ulTaskNumber TCB number of the new task
+ * @param pcName Task name
+ * @retval none
+ */
+void traceTaskCreated(uint32_t ulTaskNumber, const char *pcName)
+{
+	if (ulTaskNumber < traceMAX_TASKS)
+	{
+		strncpy(traceRecorder.taskNames[ulTaskNumber], pcName, traceNAME_LEN);
+	}
+}
+
+/**
+ * @brief traceTASK_SWITCHED_IN() hook
+ * @param ulTaskNumber TCB number of the task about to run
+ * @retval none
+ */
+void traceTaskSwitchedIn(uint32_t ulTaskNumber)
+{
+	runningTask = (uint8_t)ulTaskNumber;
+	traceEvent(traceEVT_TASK_IN, (uint8_t)ulTaskNumber, 0);
+}
+
+/**
+ * @brief traceTASK_SWITCHED_OUT() hook
+ * @param ulTaskNumber TCB number of the task leaving the CPU
+ * @retval none
+ */
+void traceTaskSwitchedOut(uint32_t ulTaskNumber)
+{
+	traceEvent(traceEVT_TASK_OUT, (uint8_t)ulTaskNumber, 0);
+}
+
+/**
+ * @brief traceTASK_INCREMENT_TICK() hook
+ * @param ulTickCount Tick count before the increment
+ * @retval none
+ */
+void traceTick(uint32_t ulTickCount)
+{
+	traceEvent(traceEVT_TICK, 0, (uint16_t)(ulTickCount + 1));
+}
+
+/**
+ * @brief traceTASK_NOTIFY() and traceTASK_NOTIFY_FROM_ISR() hook
+ * @param ulTaskNumber TCB number of the task being notified
+ * @param ulFromIsr Non-zero when sent from an interrupt
+ * @retval none
+ */
+void traceNotify(uint32_t ulTaskNumber, uint32_t ulFromIsr)
+{
+	traceEvent(ulFromIsr ? traceEVT_NOTIFY_ISR : traceEVT_NOTIFY,
+			(uint8_t)ulTaskNumber, 0);
+}
+
+/**
+ * @brief traceTASK_NOTIFY_WAIT_BLOCK() and traceTASK_NOTIFY_WAIT() hook
+ * @param ulTaskNumber TCB number of the waiting task
+ * @param ulBlocking Non-zero when the task is about to block
+ * @retval none
+ */
+void traceNotifyWait(uint32_t ulTaskNumber, uint32_t ulBlocking)
+{
+	traceEvent(ulBlocking ? traceEVT_NOTIFY_BLOCK : traceEVT_NOTIFY_TAKEN,
+			(uint8_t)ulTaskNumber, 0);
+}
+
+/**
+ * @brief traceQUEUE_SEND() and traceQUEUE_RECEIVE() hook
+ * @param ulQueueNumber Number given with vQueueSetQueueNumber(), 0 if none
+ * @param ulReceive Non-zero for a receive
+ * @retval none
+ */
+void traceQueue(uint32_t ulQueueNumber, uint32_t ulReceive)
+{
+	traceEvent(ulReceive ? traceEVT_QUEUE_RECEIVE : traceEVT_QUEUE_SEND,
+			runningTask, (uint16_t)ulQueueNumber);
+}
+
+/**
+ * @brief traceEVENT_GROUP_SET_BITS() hook
+ * @param ulBits Bits being set
+ * @retval none
+ */
+void traceEventBits(uint32_t ulBits)
+{
+	traceEvent(traceEVT_EVENT_BITS, runningTask, (uint16_t)ulBits);
+}
+
+/**
+ * @brief Fills in the recorder header and starts the cycle counter
+ * @note Task names already captured by traceTaskCreated() are kept, so this
+ *       may run after tasks have been created.
+ * @param none
+ * @retval none
+ */
+void traceInit(void)
+{
+	utilsCycleCounterInit();
+	traceRecorder.magic = traceMAGIC;
+	traceRecorder.version = traceVERSION;
+	traceRecorder.capacity = traceBUFFER_EVENTS;
+	traceRecorder.cpuHz = SystemCoreClock;
+	traceRecorder.thresholdUs = traceDEFAULT_THRESHOLD_US;
+}
+/* EOF */
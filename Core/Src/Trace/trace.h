@@ -0,0 +1,125 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file trace.h
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief Definitions and prototypes for the context switch and ISR recorder
+ ******************************************************************************/
+// @formatter:off
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __TRACE_H
+#define __TRACE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx_hal.h"
+#include "main.h"
+#include "FreeRTOS.h"
+
+/* Defines -------------------------------------------------------------------*/
+#define traceMAGIC					( 0x31435254UL )	/* "TRC1" */
+#define traceVERSION				( 1 )
+#define traceBUFFER_EVENTS			( 1024 )	/* Must be a power of two */
+#define traceMAX_TASKS				( 8 )
+#define traceNAME_LEN				( 8 )
+/* Events still recorded after a latency trigger, so the dump shows the tail */
+#define tracePOST_TRIGGER_EVENTS	( 64 )
+/* Key edge to report delivered latency that freezes the recorder, 0 is off */
+#define traceDEFAULT_THRESHOLD_US	( 0 )
+
+/* Why the recorder stopped */
+#define traceFROZEN_NO				( 0 )
+#define traceFROZEN_MANUAL			( 1 )
+#define traceFROZEN_LATENCY			( 2 )
+
+/* Commands accepted by traceCommand() */
+#define traceCMD_RESTART			( 0 )	/* Clear and start recording */
+#define traceCMD_FREEZE				( 1 )	/* Stop recording now */
+#define traceCMD_THRESHOLD			( 2 )	/* arg is the threshold in us */
+#define traceCMD_REWIND				( 3 )	/* Read back from offset 0 */
+
+/* Structures ----------------------------------------------------------------*/
+typedef enum
+{
+	traceEVT_NONE = 0,
+	traceEVT_TASK_IN,		/* arg: TCB number */
+	traceEVT_TASK_OUT,		/* arg: TCB number */
+	traceEVT_ISR_ENTER,		/* arg: IRQ number + 16 (exception number) */
+	traceEVT_ISR_EXIT,		/* arg: IRQ number + 16 (exception number) */
+	traceEVT_TICK,			/* data: low half of the new tick count */
+	traceEVT_NOTIFY,		/* arg: TCB number notified */
+	traceEVT_NOTIFY_ISR,	/* arg: TCB number notified */
+	traceEVT_NOTIFY_BLOCK,	/* arg: TCB number now waiting */
+	traceEVT_NOTIFY_TAKEN,	/* arg: TCB number done waiting */
+	traceEVT_QUEUE_SEND,	/* arg: running TCB number, data: queue number */
+	traceEVT_QUEUE_RECEIVE,	/* arg: running TCB number, data: queue number */
+	traceEVT_EVENT_BITS,	/* arg: running TCB number, data: bits set */
+	traceEVT_KEY_EDGE,		/* arg: 1 pressed / 0 released, data: key index */
+	traceEVT_REPORT_QUEUED,	/* Report handed to the IN endpoint */
+	traceEVT_REPORT_SENT,	/* data: key edge to delivery latency in us */
+	traceEVT_TRIGGER,		/* data: latency in us that breached the threshold */
+	traceEVT_SCAN_RATE,		/* arg: governor level, data: frame delay in ms */
+} trace_event_type_t;
+
+typedef struct _TRACE_EVENT_S_
+{
+	uint32_t cycles;		/* DWT cycle count */
+	uint8_t type;			/* trace_event_type_t */
+	uint8_t arg;
+	uint16_t data;
+} trace_event_t;
+
+/**
+ * The whole recorder is the dump format read by Tools/trace_decode.py, so
+ * field order and sizes here are the wire format. Little endian throughout.
+ */
+typedef struct _TRACE_RECORDER_S_
+{
+	uint32_t magic;
+	uint16_t version;
+	uint16_t capacity;		/* Entries in events[] */
+	uint32_t cpuHz;			/* Cycle counter rate */
+	uint32_t head;			/* Events ever written, next is head % capacity */
+	uint8_t frozen;			/* traceFROZEN_x */
+	uint8_t reserved;
+	uint16_t postTrigger;	/* Events left to record before freezing */
+	uint32_t worstLatencyUs;/* Worst key edge to report delivered latency */
+	uint32_t thresholdUs;	/* Latency that triggers a freeze, 0 is off */
+	char taskNames[traceMAX_TASKS][traceNAME_LEN];	/* By TCB number */
+	trace_event_t events[traceBUFFER_EVENTS];
+} trace_recorder_t;
+
+/* Prototypes ----------------------------------------------------------------*/
+void traceInit(void);
+void traceEvent(trace_event_type_t type, uint8_t arg, uint16_t data);
+void traceIsrEnter(void);
+void traceIsrExit(void);
+void traceKeyEdge(uint16_t key, uint8_t pressed);
+void traceReportQueued(void);
+void traceReportSent(void);
+void traceCommand(uint8_t cmd, uint32_t arg);
+uint16_t traceRead(uint8_t *dst, uint16_t len, uint16_t *offset);
+
+/* Kernel hooks, wired to the trace macros in FreeRTOSConfig.h */
+void traceTaskCreated(uint32_t ulTaskNumber, const char *pcName);
+void traceTaskSwitchedIn(uint32_t ulTaskNumber);
+void traceTaskSwitchedOut(uint32_t ulTaskNumber);
+void traceTick(uint32_t ulTickCount);
+void traceNotify(uint32_t ulTaskNumber, uint32_t ulFromIsr);
+void traceNotifyWait(uint32_t ulTaskNumber, uint32_t ulBlocking);
+void traceQueue(uint32_t ulQueueNumber, uint32_t ulReceive);
+void traceEventBits(uint32_t ulBits);
+
+/* Exported variables --------------------------------------------------------*/
+extern trace_recorder_t traceRecorder;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TRACE_H */
+/* EOF */
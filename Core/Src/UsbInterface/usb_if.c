@@ -15,32 +15,731 @@
 #include "cmsis_os.h"
 #include "usb_device.h"
 #include "usbd_hid.h"
+#include "../Utilities/utils.h"
+#include "../Telemetry/telemetry.h"
+#include "../Trace/trace.h"
+#include "../Bench/bench.h"
+#include "../Boot/boot.h"
+#include "../Indicator/indicator.h"
+#include "../Keyboard/macro.h"
+#include "../Keyboard/health.h"
+#include "../Keyboard/usb_hid_keys.h"
+#include "../Settings/settings.h"
+
+#include <string.h>
 
 /* Defines -------------------------------------------------------------------*/
+#define QUEUE_MASK			( usbifQUEUE_LEN - 1 )
+#define CHANGE_KEY			( 0 )	/* Slot index gets a usage, 0 clears it */
+#define CHANGE_MOD			( 1 )	/* Modifier bits set or cleared */
+#define FRAME_MASK			( 0x7FFU )	/* Full speed frame numbers are 11 bits */
+
+_Static_assert((usbifQUEUE_LEN & QUEUE_MASK) == 0, "Queue length must be a power of 2");
+_Static_assert(sizeof(usb_hid_trace_rpt_t) == HID_TRACE_REPORT_SIZE,
+		"Trace chunk no longer matches the HID feature report");
+_Static_assert(sizeof(usb_hid_health_rpt_t) == HID_HEALTH_REPORT_SIZE,
+		"Health chunk no longer matches the HID feature report");
+_Static_assert(sizeof(usb_hid_settings_cmd_t) == HID_SETTINGS_REPORT_SIZE
+		&& sizeof(usb_hid_settings_rpt_t) == HID_SETTINGS_REPORT_SIZE,
+		"Settings command no longer matches the HID feature report");
+_Static_assert(sizeof(bench_results_t) == HID_BENCH_REPORT_SIZE,
+		"Benchmark results no longer match the HID feature report");
 
 /* Global variables ---------------------------------------------------------*/
 extern USBD_HandleTypeDef hUsbDeviceFS;
 
+/* Private types -------------------------------------------------------------*/
+typedef struct _USBIF_CHANGE_S_
+{
+	uint8_t kind;			/* CHANGE_x */
+	uint8_t arg;			/* Slot for keys, bits for modifiers */
+	uint8_t value;			/* Usage for keys, 1 set / 0 clear for modifiers */
+	uint8_t reserved;
+	uint32_t timeMs;		/* Tick it was queued at */
+} usbif_change_t;
+
 /* Private variables ---------------------------------------------------------*/
-static usb_hid_kb_rpt_t hidKeyboard;
+static usb_hid_kb_rpt_t hidKeyboard;	/* Latest state, used to allocate slots */
+static usb_hid_kb_rpt_t hidWire;		/* State the host has been sent */
+static usb_hid_kb_rpt_t hidTxReport;	/* Owned by the endpoint while in flight */
+
+/* Changes from the scan task, in edge order, not yet sent */
+static usbif_change_t changes[usbifQUEUE_LEN];
+static volatile uint8_t changeHead;
+static volatile uint8_t changeTail;
+static volatile _Bool resync;			/* Queue overflowed or stale, resend hidKeyboard */
+static volatile uint32_t reportsSent;
+static volatile uint32_t changeDrops;
+static TaskHandle_t reportTask;
+#if !benchENABLE
+static StackType_t reportStack[usbifREPORT_STACK_SIZE];
+static StaticTask_t reportTcb;
+#endif
+static volatile _Bool reportDirty;
+static volatile _Bool configured;
+static volatile _Bool rollOver;		/* Report ErrorRollOver in every key slot */
+static usb_hid_kb_rpt_t getReportTx;	/* Control pipe copies, see GET_REPORT */
+static telemetry_snapshot_t telemetryTx;
+static usb_hid_trace_rpt_t traceTx;
+static bench_results_t benchTx;
+static usb_hid_health_rpt_t healthTx;
+static usb_hid_settings_rpt_t settingsTx;
+static volatile uint8_t settingsStatus = pdPASS;	/* Of the last settings command */
+
+/* Host poll interval discovery, see usbifPollSample() */
+static uint16_t doneFrame;			/* Frame the last IN transfer completed in */
+static volatile _Bool doneValid;
+static volatile _Bool chained;		/* Transfer in flight was queued in doneFrame */
+static uint8_t pollGaps[usbifPOLL_SAMPLES];
+static uint8_t pollGapCount;
+static volatile uint8_t pollMs;		/* Measured IN poll interval, 0 until known */
 
 /* Static prototypes ---------------------------------------------------------*/
 static void usbifReportTask(void *pvParameters);
+static void usbifNotifyReport(void);
+static TickType_t usbifIdleTimeout(void);
+static TickType_t usbifMacroTimeout(uint32_t waitMs);
+static void usbifApplyRollOver(usb_hid_kb_rpt_t *report);
+static void usbifQueueChange(uint8_t kind, uint8_t arg, uint8_t value);
+static _Bool usbifNextFrame(void);
+static void usbifPromoteModifier(void);
+static void usbifReplayOrResync(void);
+static void usbifPollSample(void);
 
 /* Code ----------------------------------------------------------------------*/
 /**
- * @brief Periodically sends HID keyboard report to the USB host
+ * @brief Sends the HID keyboard report to the USB host whenever it changes
+ * @note The task sleeps until it is notified that the report changed, that the
+ *       IN endpoint finished the previous transfer, or that the configuration
+ *       changed. The only timed wake-ups are the host's SET_IDLE rate and
+ *       waits inside a playing macro.
+ *
+ *       Key changes are queued in edge order and sent as the fewest distinct
+ *       reports that keep every intermediate state: one report per transfer,
+ *       so one per host poll. A transfer carries either one macro step or one
+ *       report's worth of queued changes, never both, so a macro's modifier
+ *       and a live key never change together. When both are waiting they take
+ *       turns, so live keys are never held back behind a whole macro.
+ *
+ *       Once configured, the current report is repeated usbifPROBE_REPORTS
+ *       times, back to back, so the host's poll interval is known before the
+ *       first key comes along.
  * @param pvParameters UNUSED, for FreeRTOS consistency only
  * @retval none
  */
 static void usbifReportTask(void *pvParameters)
 {
+	uint32_t events;
+	uint32_t macroWaitMs = macroNO_WAIT;
+	TickType_t idleTimeout;
+	TickType_t timeout;
+	_Bool txBusy = 0;
+	_Bool macroTurn = 0;		/* Macro step goes first in the next transfer */
+	_Bool framed;
+	_Bool stepped;
+	uint8_t probeLeft = 0;
+
 	UNUSED(pvParameters);
 	for (;;)
 	{
-		USBD_HID_SendReport(&hUsbDeviceFS, (uint8_t *)&hidKeyboard, sizeof(usb_hid_kb_rpt_t));
-		vTaskDelay(pdMS_TO_TICKS(20));
+		events = 0;
+		idleTimeout = usbifIdleTimeout();
+		timeout = (txBusy || !configured) ? idleTimeout
+				: usbifMacroTimeout(macroWaitMs);
+		if (idleTimeout < timeout)
+		{
+			timeout = idleTimeout;
+		}
+		if (xTaskNotifyWait(0, UINT32_MAX, &events, timeout) == pdFALSE
+				&& timeout == idleTimeout)
+		{
+			/* Idle period elapsed, the host expects the report again */
+			reportDirty = 1;
+		}
+		if (events & usbifNOTIFY_STATE)
+		{
+			txBusy = 0;
+			reportDirty = 1;
+			if (configured)
+			{
+				probeLeft = usbifPROBE_REPORTS;
+				usbifReplayOrResync();
+				xEventGroupSetBits(utilsEvents, utilsEVT_USB_CONFIGURED);
+			}
+			else
+			{
+				xEventGroupClearBits(utilsEvents, utilsEVT_USB_CONFIGURED);
+				macroInit();
+				macroWaitMs = macroNO_WAIT;
+			}
+		}
+		if (events & usbifNOTIFY_SENT)
+		{
+			txBusy = 0;
+		}
+		if (configured && !txBusy)
+		{
+			stepped = 0;
+			framed = !macroTurn && usbifNextFrame();
+			if (!framed)
+			{
+				stepped = macroStep(xTaskGetTickCount() * portTICK_PERIOD_MS,
+						&macroWaitMs);
+			}
+			if (!framed && !stepped && macroTurn)
+			{
+				framed = usbifNextFrame();
+			}
+			macroTurn = framed;
+			if (framed || stepped)
+			{
+				reportDirty = 1;
+			}
+			if (!reportDirty && probeLeft)
+			{
+				probeLeft--;
+				reportDirty = 1;
+			}
+		}
+		if (configured && reportDirty && !txBusy)
+		{
+			reportDirty = 0;
+			hidTxReport = hidWire;
+			macroMerge(&hidTxReport.modifiers, hidTxReport.keys);
+			usbifApplyRollOver(&hidTxReport);
+			chained = doneValid && (USBD_LL_GetFrameNumber(&hUsbDeviceFS)
+					& FRAME_MASK) == doneFrame;
+			if (USBD_HID_SendReport(&hUsbDeviceFS, (uint8_t *)&hidTxReport,
+					sizeof(usb_hid_kb_rpt_t)) == USBD_OK)
+			{
+				txBusy = 1;
+				reportsSent++;
+				traceReportQueued();
+			}
+			else
+			{
+				reportDirty = 1;
+			}
+		}
+		bootLog();
+	}
+}
+
+/**
+ * @brief Computes how long the report task may sleep without input
+ * @note SET_IDLE duration is in units of 4 ms, and 0 means report on change
+ *       only. Nothing is sent while unconfigured so the task sleeps forever.
+ * @param none
+ * @retval Ticks to block for
+ */
+static TickType_t usbifIdleTimeout(void)
+{
+	USBD_HID_HandleTypeDef *hhid;
+
+	if (!configured)
+	{
+		return portMAX_DELAY;
+	}
+	hhid = (USBD_HID_HandleTypeDef *)hUsbDeviceFS.pClassData;
+	if (hhid == NULL || hhid->IdleState == 0)
+	{
+		return portMAX_DELAY;
+	}
+	return pdMS_TO_TICKS(hhid->IdleState * 4);
+}
+
+/**
+ * @brief Converts the macro player's wait into a block time
+ * @note A step that is due with the endpoint free means the last send failed,
+ *       so back off a tick rather than spin.
+ * @param waitMs Time until the next macro step, as set by macroStep()
+ * @retval Ticks to block for
+ */
+static TickType_t usbifMacroTimeout(uint32_t waitMs)
+{
+	if (waitMs == macroNO_WAIT)
+	{
+		return portMAX_DELAY;
 	}
+	return waitMs ? pdMS_TO_TICKS(waitMs) : 1;
+}
+
+/**
+ * @brief Advances the wire state by one report's worth of queued changes
+ * @note A report takes queued changes in order until the next one would
+ *       overwrite a slot or modifier already changed in it, so a tap shorter
+ *       than a poll still shows up as a press and then a release. Modifier
+ *       and key changes never share a report, so the host always sees a
+ *       modifier go down before, and come up after, the keys it applies to.
+ * @param none
+ * @retval 1 if hidWire changed
+ */
+static _Bool usbifNextFrame(void)
+{
+	usbif_change_t *change;
+	uint8_t touchedSlots = 0;
+	uint8_t touchedMods = 0;
+	uint8_t kind = 0xFF;
+	_Bool changed = 0;
+
+	if (resync)
+	{
+		/* Intermediate states were lost, jump straight to the latest */
+		taskENTER_CRITICAL();
+		resync = 0;
+		changeTail = changeHead;
+		changed = (memcmp(&hidWire, &hidKeyboard, sizeof(hidWire)) != 0);
+		hidWire = hidKeyboard;
+		taskEXIT_CRITICAL();
+		return changed;
+	}
+
+	usbifPromoteModifier();
+	while (changeTail != changeHead)
+	{
+		change = &changes[changeTail & QUEUE_MASK];
+		if (kind != 0xFF && change->kind != kind)
+		{
+			break;
+		}
+		if (change->kind == CHANGE_KEY)
+		{
+			if (touchedSlots & (1U << change->arg))
+			{
+				break;
+			}
+			touchedSlots |= 1U << change->arg;
+			hidWire.keys[change->arg] = change->value;
+		}
+		else
+		{
+			if (touchedMods & change->arg)
+			{
+				break;
+			}
+			touchedMods |= change->arg;
+			hidWire.modifiers = change->value ? (hidWire.modifiers | change->arg)
+					: (hidWire.modifiers & ~change->arg);
+		}
+		kind = change->kind;
+		changeTail = changeTail + 1;
+		changed = 1;
+	}
+	return changed;
+}
+
+/**
+ * @brief Moves a modifier press ahead of key presses queued in the same tick
+ * @note Keys read in the same scan pass have no meaningful order between
+ *       them, and a shortcut only works if the modifier arrives first.
+ * @param none
+ * @retval none
+ */
+static void usbifPromoteModifier(void)
+{
+	usbif_change_t first;
+	usbif_change_t promoted;
+	uint8_t at = changeTail;
+
+	if (at == changeHead)
+	{
+		return;
+	}
+	first = changes[at & QUEUE_MASK];
+	if (first.kind != CHANGE_KEY || first.value == 0)
+	{
+		return;
+	}
+	for (at++; at != changeHead; at++)
+	{
+		promoted = changes[at & QUEUE_MASK];
+		if (promoted.timeMs != first.timeMs
+				|| (promoted.kind == CHANGE_KEY && promoted.value == 0))
+		{
+			return;
+		}
+		if (promoted.kind == CHANGE_MOD && promoted.value)
+		{
+			break;
+		}
+	}
+	if (at == changeHead)
+	{
+		return;
+	}
+	/* Only the report task moves entries between tail and head */
+	for (; at != changeTail; at--)
+	{
+		changes[at & QUEUE_MASK] = changes[(uint8_t)(at - 1) & QUEUE_MASK];
+	}
+	changes[changeTail & QUEUE_MASK] = promoted;
+}
+
+/**
+ * @brief Decides what the host gets first once it configures us
+ * @note Changes keep queueing while unconfigured, from power-on or a
+ *       re-enumeration, so a key typed before the host was ready is
+ *       replayed in order rather than lost. Changes older than
+ *       usbifREPLAY_MAX_MS would only surprise the user, and the report
+ *       jumps to the current state instead.
+ * @param none
+ * @retval none
+ */
+static void usbifReplayOrResync(void)
+{
+	uint8_t tail = changeTail;
+
+	if (tail != changeHead && xTaskGetTickCount() - changes[tail & QUEUE_MASK].timeMs
+			> pdMS_TO_TICKS(usbifREPLAY_MAX_MS))
+	{
+		resync = 1;
+	}
+}
+
+/**
+ * @brief Times an IN completion against the last one
+ * @note Runs in the USB interrupt. A report queued in the same frame as the
+ *       previous completion goes out at the very next poll, so the frames
+ *       between the two completions are one poll interval. The SOF frame
+ *       number is read from the core instead of counting SOF interrupts,
+ *       which would wake the core every ms. The estimate is the median of
+ *       usbifPOLL_SAMPLES such gaps, so one late interrupt can't skew it.
+ * @param none
+ * @retval none
+ */
+static void usbifPollSample(void)
+{
+	uint16_t frame = USBD_LL_GetFrameNumber(&hUsbDeviceFS) & FRAME_MASK;
+	uint16_t gap = (frame - doneFrame) & FRAME_MASK;
+	uint8_t sorted[usbifPOLL_SAMPLES];
+	uint8_t value;
+	uint8_t jj;
+
+	if (chained && doneValid && gap != 0 && gap <= UINT8_MAX)
+	{
+		pollGaps[pollGapCount++] = (uint8_t)gap;
+		if (pollGapCount == usbifPOLL_SAMPLES)
+		{
+			for (uint8_t ii = 0; ii < usbifPOLL_SAMPLES; ii++)
+			{
+				value = pollGaps[ii];
+				for (jj = ii; jj > 0 && sorted[jj - 1] > value; jj--)
+				{
+					sorted[jj] = sorted[jj - 1];
+				}
+				sorted[jj] = value;
+			}
+			pollMs = sorted[usbifPOLL_SAMPLES / 2];
+			pollGapCount = 0;
+		}
+	}
+	chained = 0;
+	doneFrame = frame;
+	doneValid = 1;
+}
+
+/**
+ * @brief Queues a change for the report task
+ * @note Call from the scan task only. If the queue is full the change is
+ *       counted as a drop and the report task resends the latest state.
+ * @param kind CHANGE_KEY or CHANGE_MOD
+ * @param arg Slot or modifier bits
+ * @param value Usage, or 1 to set and 0 to clear modifier bits
+ * @retval none
+ */
+static void usbifQueueChange(uint8_t kind, uint8_t arg, uint8_t value)
+{
+	uint8_t head = changeHead;
+
+	if ((uint8_t)(head - changeTail) >= usbifQUEUE_LEN)
+	{
+		changeDrops++;
+		resync = 1;
+	}
+	else
+	{
+		changes[head & QUEUE_MASK] = (usbif_change_t) {
+			.kind = kind,
+					.arg = arg,
+					.value = value,
+					.timeMs = xTaskGetTickCount()
+		};
+		changeHead = head + 1;
+	}
+	if (reportTask != NULL)
+	{
+		xTaskNotify(reportTask, usbifNOTIFY_REPORT, eSetBits);
+	}
+}
+
+/**
+ * @brief Replaces the key slots with ErrorRollOver while it is in force
+ * @note Modifiers are still reported, as the HID spec asks.
+ * @param report Report about to go to the host
+ * @retval none
+ */
+static void usbifApplyRollOver(usb_hid_kb_rpt_t *report)
+{
+	if (rollOver)
+	{
+		memset(report->keys, KEY_ERR_OVF, sizeof(report->keys));
+	}
+}
+
+/**
+ * @brief Marks the report as changed and wakes the report task
+ * @param none
+ * @retval none
+ */
+static void usbifNotifyReport(void)
+{
+	reportDirty = 1;
+	if (reportTask != NULL)
+	{
+		xTaskNotify(reportTask, usbifNOTIFY_REPORT, eSetBits);
+	}
+}
+
+/**
+ * @brief Forwards HID class events to the report task
+ * @note Runs in the USB interrupt.
+ * @param pdev USB device handle
+ * @param event Class event
+ * @retval none
+ */
+void USBD_HID_EventCallback(USBD_HandleTypeDef *pdev, HID_EventTypeDef event)
+{
+	BaseType_t woken = pdFALSE;
+	uint32_t bits;
+
+	UNUSED(pdev);
+	switch (event)
+	{
+	case HID_EVENT_CONFIGURED:
+		bootMark(bootMARK_CONFIGURED);
+		indicatorSetHost(1);
+		configured = 1;
+		doneValid = 0;
+		pollGapCount = 0;
+		bits = usbifNOTIFY_STATE;
+		break;
+	case HID_EVENT_DECONFIGURED:
+		indicatorSetHost(0);
+		configured = 0;
+		bits = usbifNOTIFY_STATE;
+		break;
+	case HID_EVENT_REPORT_SENT:
+	default:
+		traceReportSent();
+		usbifPollSample();
+		if (bootReached(bootMARK_FIRST_EDGE))
+		{
+			bootMark(bootMARK_FIRST_REPORT);
+		}
+		bits = usbifNOTIFY_SENT;
+		break;
+	}
+	if (reportTask != NULL)
+	{
+		xTaskNotifyFromISR(reportTask, bits, eSetBits, &woken);
+		portYIELD_FROM_ISR(woken);
+	}
+}
+
+/**
+ * @brief Answers GET_REPORT requests on the control pipe
+ * @note Runs in the USB interrupt. Reports are copied because the control
+ *       transfer reads the buffer after we return.
+ * @param pdev USB device handle
+ * @param type HID report type
+ * @param id Report ID
+ * @param len Set to the length of the returned report
+ * @retval Report to send, or NULL to stall
+ */
+uint8_t *USBD_HID_GetReportCallback(USBD_HandleTypeDef *pdev, uint8_t type,
+		uint8_t id, uint16_t *len)
+{
+	UBaseType_t mask;
+	settings_stats_t stats;
+
+	UNUSED(pdev);
+	if (type == HID_REPORT_TYPE_INPUT && id == hidKeyboard.id)
+	{
+		mask = taskENTER_CRITICAL_FROM_ISR();
+		getReportTx = hidKeyboard;
+		taskEXIT_CRITICAL_FROM_ISR(mask);
+		usbifApplyRollOver(&getReportTx);
+		*len = sizeof(usb_hid_kb_rpt_t);
+		return (uint8_t *)&getReportTx;
+	}
+	if (type == HID_REPORT_TYPE_FEATURE && id == HID_TELEMETRY_REPORT_ID)
+	{
+		telemetryGetSnapshot(&telemetryTx);
+		*len = sizeof(telemetry_snapshot_t);
+		return (uint8_t *)&telemetryTx;
+	}
+	if (type == HID_REPORT_TYPE_FEATURE && id == HID_TRACE_REPORT_ID)
+	{
+		memset(&traceTx, 0, sizeof(traceTx));
+		traceTx.id = HID_TRACE_REPORT_ID;
+		traceTx.length = (uint8_t)traceRead(traceTx.data, sizeof(traceTx.data),
+				&traceTx.offset);
+		*len = sizeof(usb_hid_trace_rpt_t);
+		return (uint8_t *)&traceTx;
+	}
+	if (type == HID_REPORT_TYPE_FEATURE && id == HID_HEALTH_REPORT_ID)
+	{
+		memset(&healthTx, 0, sizeof(healthTx));
+		healthTx.id = HID_HEALTH_REPORT_ID;
+		healthTx.length = (uint8_t)healthRead(healthTx.data, sizeof(healthTx.data),
+				&healthTx.offset);
+		*len = sizeof(usb_hid_health_rpt_t);
+		return (uint8_t *)&healthTx;
+	}
+	if (type == HID_REPORT_TYPE_FEATURE && id == HID_SETTINGS_REPORT_ID)
+	{
+		settingsGetStats(&stats);
+		settingsTx = (usb_hid_settings_rpt_t) {
+			.id = HID_SETTINGS_REPORT_ID,
+					.status = settingsStatus,
+					.profile = stats.profile,
+					.pending = stats.pending,
+					.used = stats.used
+		};
+		*len = sizeof(usb_hid_settings_rpt_t);
+		return (uint8_t *)&settingsTx;
+	}
+	if (type == HID_REPORT_TYPE_FEATURE && id == HID_BENCH_REPORT_ID)
+	{
+		benchGetResults(&benchTx);
+		*len = sizeof(bench_results_t);
+		return (uint8_t *)&benchTx;
+	}
+	*len = 0;
+	return NULL;
+}
+
+/**
+ * @brief Acts on SET_REPORT requests from the control pipe
+ * @note Runs in the USB interrupt.
+ * @param pdev USB device handle
+ * @param type HID report type
+ * @param id Report ID
+ * @param report Report data, starting with the ID
+ * @param len Length of report
+ * @retval none
+ */
+void USBD_HID_SetReportCallback(USBD_HandleTypeDef *pdev, uint8_t type,
+		uint8_t id, uint8_t *report, uint16_t len)
+{
+	usb_hid_trace_cmd_t cmd;
+	usb_hid_health_cmd_t health;
+	usb_hid_settings_cmd_t set;
+
+	UNUSED(pdev);
+	if (type == HID_REPORT_TYPE_OUTPUT && id == hidKeyboard.id && len >= 2)
+	{
+		/* ID, then the lock LED bits */
+		indicatorSetLocks(report[1]);
+	}
+	if (type == HID_REPORT_TYPE_FEATURE && id == HID_TRACE_REPORT_ID
+			&& len >= sizeof(usb_hid_trace_cmd_t))
+	{
+		memcpy(&cmd, report, sizeof(cmd));
+		traceCommand(cmd.cmd, cmd.arg);
+	}
+	if (type == HID_REPORT_TYPE_FEATURE && id == HID_HEALTH_REPORT_ID
+			&& len >= sizeof(usb_hid_health_cmd_t))
+	{
+		memcpy(&health, report, sizeof(health));
+		healthCommand(health.cmd);
+	}
+	if (type == HID_REPORT_TYPE_FEATURE && id == HID_SETTINGS_REPORT_ID
+			&& len >= sizeof(usb_hid_settings_cmd_t))
+	{
+		memcpy(&set, report, sizeof(set));
+		if (set.cmd == settingsCMD_WRITE && set.length <= sizeof(set.data))
+		{
+			settingsStatus = (uint8_t)settingsWritePart(set.key, set.offset,
+					set.total, set.data, set.length);
+		}
+		else if (set.cmd == settingsCMD_SELECT && set.key <= UINT8_MAX)
+		{
+			settingsStatus = (uint8_t)settingsSelectProfile((uint8_t)set.key);
+		}
+		else
+		{
+			settingsStatus = pdFAIL;
+		}
+	}
+}
+
+/**
+ * @brief Reports whether the host has configured the device
+ * @param none
+ * @retval 1 if configured, otherwise 0
+ */
+_Bool usbifIsConfigured(void)
+{
+	return configured;
+}
+
+/**
+ * @brief Reports how often the host polls the keyboard endpoint
+ * @note Measured, not taken from bInterval: hosts round it, and some ignore it.
+ * @param none
+ * @retval Poll interval in ms, 0 until measured
+ */
+uint8_t usbifPollMs(void)
+{
+	return pollMs;
+}
+
+/**
+ * @brief Copies the report counters
+ * @param stats Destination for the counters
+ * @retval none
+ */
+void usbifGetStats(usbif_stats_t *stats)
+{
+	stats->reportsSent = reportsSent;
+	stats->changeDrops = changeDrops;
+	stats->pollMs = pollMs;
+}
+
+/**
+ * @brief Enters or leaves the ErrorRollOver (phantom) state
+ * @note Used when more keys are down than the report holds, or when the
+ *       matrix cannot tell which keys are down.
+ * @param on 1 to report ErrorRollOver, 0 to report keys again
+ * @retval none
+ */
+void usbifSetRollOver(_Bool on)
+{
+	if (rollOver != on)
+	{
+		rollOver = on;
+		usbifNotifyReport();
+	}
+}
+
+/**
+ * @brief Queues a macro and wakes the report task to play it
+ * @note Call from the scan task. Returns at once.
+ * @param macro Macro number
+ * @retval 1 if queued, 0 if unknown or too many macros are waiting
+ */
+_Bool usbifPlayMacro(uint16_t macro)
+{
+	if (!macroQueue(macro))
+	{
+		return 0;
+	}
+	if (reportTask != NULL)
+	{
+		xTaskNotify(reportTask, usbifNOTIFY_REPORT, eSetBits);
+	}
+	return 1;
 }
 
 /**
@@ -72,6 +771,7 @@ uint16_t usbifUpdateKey(uint16_t idx, uint8_t val)
 	if (idx < 6 && hidKeyboard.keys[idx] == 0)
 	{
 		hidKeyboard.keys[idx] = val;
+		usbifQueueChange(CHANGE_KEY, (uint8_t)idx, val);
 		return idx;
 	}
 	return 0;
@@ -85,6 +785,7 @@ uint16_t usbifUpdateKey(uint16_t idx, uint8_t val)
 uint16_t usbifClearKey(uint16_t idx)
 {
 	hidKeyboard.keys[idx] = 0;
+	usbifQueueChange(CHANGE_KEY, (uint8_t)idx, 0);
 	return 0;
 }
 
@@ -96,6 +797,7 @@ uint16_t usbifClearKey(uint16_t idx)
 uint16_t usbifUpdateMod(uint8_t val)
 {
 	hidKeyboard.modifiers |= val;
+	usbifQueueChange(CHANGE_MOD, val, 1);
 	return 0;
 }
 
@@ -107,9 +809,37 @@ uint16_t usbifUpdateMod(uint8_t val)
 uint16_t usbifClearMod(uint8_t val)
 {
 	hidKeyboard.modifiers &= ~val;
+	usbifQueueChange(CHANGE_MOD, val, 0);
 	return 0;
 }
 
+#if benchENABLE
+/**
+ * @brief One key change taken from the queue to a report, for the benchmarks
+ * @note What the scan task and report task do between them for an edge,
+ *       minus the notifications. Alternate presses and releases so the
+ *       report stays clear.
+ * @param press 1 to press a key, 0 to release it
+ * @retval Report as it would be sent
+ */
+usb_hid_kb_rpt_t *usbifBenchReport(_Bool press)
+{
+	if (press)
+	{
+		usbifUpdateKey(usbifRequestKey(), KEY_A);
+	}
+	else
+	{
+		usbifClearKey(0);
+	}
+	usbifNextFrame();
+	hidTxReport = hidWire;
+	macroMerge(&hidTxReport.modifiers, hidTxReport.keys);
+	usbifApplyRollOver(&hidTxReport);
+	return &hidTxReport;
+}
+#endif
+
 /**
  * @brief Initializes necessary components and creates tasks
  * @param none
@@ -123,10 +853,15 @@ void usbifInit()
 				.modifiers = 0,
 				.keys = { 0 }
 	};
+	hidWire = hidKeyboard;
 
 	/* Initialize RTOS features ----------------------------------------------*/
-	xTaskCreate(usbifReportTask, "usbrpt", usbifREPORT_STACK_SIZE, NULL,
-			usbifREPORT_PRIORITY, NULL);
+#if !benchENABLE
+	/* The benchmark build sends its own reports from Bench/bench.c */
+	reportTask = xTaskCreateStatic(usbifReportTask, "usbrpt",
+			usbifREPORT_STACK_SIZE, NULL, usbifREPORT_PRIORITY, reportStack,
+			&reportTcb);
+#endif
 }
 
 /* EOF */
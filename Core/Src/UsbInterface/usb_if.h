@@ -23,6 +23,20 @@ extern "C" {
 #define usbifREPORT_STACK_SIZE		( 512 )
 #define usbifREPORT_PRIORITY		( tskIDLE_PRIORITY + 2 )
 
+/* Notification bits understood by the report task */
+#define usbifNOTIFY_REPORT			( 1UL << 0 )	/* Report contents changed */
+#define usbifNOTIFY_SENT			( 1UL << 1 )	/* IN endpoint is free again */
+#define usbifNOTIFY_STATE			( 1UL << 2 )	/* Configuration changed */
+
+/* Key and modifier changes waiting to be sent, power of 2 */
+#define usbifQUEUE_LEN				( 32 )
+/* Changes queued before configuration are replayed unless this old, in ms */
+#define usbifREPLAY_MAX_MS			( 2000 )
+
+/* Host poll interval discovery, see usbifPollSample() */
+#define usbifPOLL_SAMPLES			( 5 )	/* Back-to-back gaps per estimate, odd */
+#define usbifPROBE_REPORTS			( usbifPOLL_SAMPLES )	/* Repeats sent once configured */
+
 /* Structures ----------------------------------------------------------------*/
 typedef struct _USB_KEYBOARD_REPORT_S_
 {
@@ -31,14 +45,82 @@ typedef struct _USB_KEYBOARD_REPORT_S_
 	uint8_t keys[6];
 } usb_hid_kb_rpt_t;
 
+typedef struct _USB_IF_STATS_S_
+{
+	uint32_t reportsSent;	/* Keyboard reports queued on the IN endpoint */
+	uint32_t changeDrops;	/* Changes lost to a full queue */
+	uint32_t pollMs;		/* Host's IN poll interval as measured, 0 until known */
+} usbif_stats_t;
+
+/* Feature report 4 read back: the next chunk of the trace recorder image */
+typedef struct _USB_TRACE_REPORT_S_
+{
+	uint8_t id;
+	uint8_t length;			/* Valid bytes in data[] */
+	uint16_t offset;		/* Offset of data[0] within the recorder image */
+	uint8_t data[60];
+} usb_hid_trace_rpt_t;
+
+/* Feature report 4 written by the host: a recorder command */
+typedef struct _USB_TRACE_COMMAND_S_
+{
+	uint8_t id;
+	uint8_t cmd;			/* traceCMD_x */
+	uint8_t reserved[2];
+	uint32_t arg;
+} usb_hid_trace_cmd_t;
+
+/* Feature report 6 read back: the health counters, chunked as report 4 is */
+typedef usb_hid_trace_rpt_t usb_hid_health_rpt_t;
+
+/* Feature report 6 written by the host: a health command */
+typedef struct _USB_HEALTH_COMMAND_S_
+{
+	uint8_t id;
+	uint8_t cmd;			/* healthCMD_x */
+	uint8_t reserved[2];
+} usb_hid_health_cmd_t;
+
+/* Feature report 7 written by the host: a settings command */
+typedef struct _USB_SETTINGS_COMMAND_S_
+{
+	uint8_t id;
+	uint8_t cmd;			/* settingsCMD_x */
+	uint16_t key;			/* Record key, or the profile to select */
+	uint16_t offset;		/* Position of data[0] within the record */
+	uint16_t total;			/* Payload bytes of the whole record */
+	uint8_t length;			/* Valid bytes in data[] */
+	uint8_t reserved[3];
+	uint8_t data[52];
+} usb_hid_settings_cmd_t;
+
+/* Feature report 7 read back: how the last command went */
+typedef struct _USB_SETTINGS_REPORT_S_
+{
+	uint8_t id;
+	uint8_t status;			/* pdPASS or pdFAIL */
+	uint8_t profile;		/* Active profile, 0xFF while on the built-in keymap */
+	uint8_t pending;		/* Records staged, not yet programmed */
+	uint16_t used;			/* Bytes of the active flash page in use */
+	uint8_t reserved[58];
+} usb_hid_settings_rpt_t;
+
 /* Prototypes ----------------------------------------------------------------*/
 uint16_t usbifRequestKey(void);
 uint16_t usbifUpdateKey(uint16_t idx, uint8_t val);
 uint16_t usbifClearKey(uint16_t idx);
 uint16_t usbifUpdateMod(uint8_t val);
 uint16_t usbifClearMod(uint8_t val);
+_Bool usbifIsConfigured(void);
+uint8_t usbifPollMs(void);
+_Bool usbifPlayMacro(uint16_t macro);
+void usbifSetRollOver(_Bool on);
+void usbifGetStats(usbif_stats_t *stats);
 void usbifInit(void);
 
+/* Benchmark build only, see Bench/bench.c */
+usb_hid_kb_rpt_t *usbifBenchReport(_Bool press);
+
 /* Exported variables --------------------------------------------------------*/
 
 #ifdef __cplusplus
@@ -23,21 +23,15 @@
 
 /* Defines -------------------------------------------------------------------*/
 
+/* Global variables ---------------------------------------------------------*/
+EventGroupHandle_t utilsEvents;
+
 /* Private variables ---------------------------------------------------------*/
+static StaticEventGroup_t utilsEventsBuffer;
 
 /* Static prototypes ---------------------------------------------------------*/
-static void utilsHeartbeatTask(void *pvParameters);
 
 /* Code ----------------------------------------------------------------------*/
-static void utilsHeartbeatTask(void *pvParameters)
-{
-	for (;;)
-	{
-		HAL_GPIO_TogglePin(LD2_GPIO_Port, LD2_Pin);
-		vTaskDelay(pdMS_TO_TICKS(500));
-	}
-}
-
 #ifdef __USART_H
 /**
  * @see https://electronics.stackexchange.com/questions/206113/how-do-i-use-the-printf-function-on-stm32
@@ -67,8 +61,48 @@ int _write(int file, char *data, int len)
 }
 #endif
 
+/**
+ * @brief Starts the DWT cycle counter behind utilsCYCLES()
+ * @note Safe to call more than once; the count is only reset the first time so
+ *       measurements already in progress stay valid.
+ * @param none
+ * @retval none
+ */
+void utilsCycleCounterInit(void)
+{
+	if (!(DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk))
+	{
+		CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+		DWT->CYCCNT = 0;
+		DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+	}
+}
+
+/**
+ * @brief Busy-waits on the cycle counter
+ * @note For the microsecond waits of the matrix scan, where a tick based
+ *       delay is far too coarse. Keep it to tens of us; it does not yield.
+ * @param us Time to wait, in us
+ * @retval none
+ */
+void utilsDelayUs(uint32_t us)
+{
+	uint32_t start = utilsCYCLES();
+	uint32_t cycles = us * (SystemCoreClock / 1000000U);
+
+	while (utilsCYCLES() - start < cycles)
+	{
+	}
+}
+
+/**
+ * @brief Creates the shared system event group
+ * @note Must run before any other module's init, they publish into utilsEvents.
+ * @param none
+ * @retval none
+ */
 void utilsInit(void)
 {
-	xTaskCreate(utilsHeartbeatTask, "hbeat", configMINIMAL_STACK_SIZE, NULL, utilsHEARTBEAT_PRIORITY, NULL);
+	utilsEvents = xEventGroupCreateStatic(&utilsEventsBuffer);
 }
 /* EOF */
@@ -18,14 +18,20 @@ extern "C" {
 /* Includes ------------------------------------------------------------------*/
 #include "stm32f4xx_hal.h"
 #include "main.h"
+#include "FreeRTOS.h"
+#include "event_groups.h"
 #include <stdio.h>
 
 /* Defines -------------------------------------------------------------------*/
-#define utilsHEARTBEAT_PRIORITY		( tskIDLE_PRIORITY )
+/* System state bits kept in utilsEvents */
+#define utilsEVT_USB_CONFIGURED		( 1UL << 0 )	/* Host has configured us */
 
 /* Structures ----------------------------------------------------------------*/
 
 /* Exported macros -----------------------------------------------------------*/
+/* Free-running core clock cycle count, see utilsCycleCounterInit() */
+#define utilsCYCLES()		( DWT->CYCCNT )
+
 #define os_printf(fmt, ...) do {\
 	if (os_running) taskENTER_CRITICAL();\
 	printf(fmt, ## __VA_ARGS__);\
@@ -34,8 +40,11 @@ extern "C" {
 
 /* Prototypes ----------------------------------------------------------------*/
 void utilsInit(void);
+void utilsCycleCounterInit(void);
+void utilsDelayUs(uint32_t us);
 
 /* Exported variables --------------------------------------------------------*/
+extern EventGroupHandle_t utilsEvents;
 
 #ifdef __cplusplus
 }
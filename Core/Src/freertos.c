@@ -29,6 +29,13 @@
 #include "Keyboard/keyboard.h"
 #include "UsbInterface/usb_if.h"
 #include "Utilities/utils.h"
+#include "Power/power.h"
+#include "Indicator/indicator.h"
+#include "Telemetry/telemetry.h"
+#include "Trace/trace.h"
+#include "Settings/settings.h"
+#include "Bench/bench.h"
+#include "Boot/boot.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -38,6 +45,31 @@
 
 /* Private define ------------------------------------------------------------*/
 /* USER CODE BEGIN PD */
+/**
+ * Every RTOS object is statically allocated; there is no FreeRTOS heap. Run
+ * Tools/membudget.py on the linker map (done as a post-build step) for the
+ * per-subsystem stack, static and heap budget.
+ *
+ * Task priority map. Every task blocks until it has work; the idle task turns
+ * the gaps into tickless sleep.
+ *
+ *   defaultTask  osPriorityAboveNormal  Starts USB, then deletes itself; runs
+ *                (+4)                   first so the host sees us at once
+ *                                       (Boot/boot.c)
+ *   kbscan       tskIDLE_PRIORITY + 3   Matrix scan, never waits behind USB
+ *   usbrpt       tskIDLE_PRIORITY + 2   Woken by report changes and IN
+ *                                       completions, or the SET_IDLE rate
+ *   telem        tskIDLE_PRIORITY + 1   Task stats snapshot, only while
+ *                                       configured (Telemetry/telemetry.c)
+ *   settings     tskIDLE_PRIORITY + 1   Background flash writes, erases only
+ *                                       while the matrix is idle
+ *   IDLE         tskIDLE_PRIORITY       Tickless sleep (Power/power.c)
+ *
+ * The LEDs need no task: the timers run them (Indicator/indicator.c).
+ *
+ * The benchmark build (benchENABLE, Bench/bench.h) starts no kbscan or usbrpt;
+ * a bench task at tskIDLE_PRIORITY + 3 runs their code under the cycle counter.
+ */
 
 /* USER CODE END PD */
 
@@ -51,6 +83,8 @@
 
 /* USER CODE END Variables */
 osThreadId defaultTaskHandle;
+uint32_t defaultTaskBuffer[ 128 ];
+osStaticThreadDef_t defaultTaskControlBlock;
 
 /* Private function prototypes -----------------------------------------------*/
 /* USER CODE BEGIN FunctionPrototypes */
@@ -62,6 +96,22 @@ void StartDefaultTask(void const * argument);
 extern void MX_USB_DEVICE_Init(void);
 void MX_FREERTOS_Init(void); /* (MISRA C 2004 rule 8.1) */
 
+/* GetIdleTaskMemory prototype (linked to static allocation support) */
+void vApplicationGetIdleTaskMemory( StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer, uint32_t *pulIdleTaskStackSize );
+
+/* USER CODE BEGIN GET_IDLE_TASK_MEMORY */
+static StaticTask_t xIdleTaskTCBBuffer;
+static StackType_t xIdleStack[configMINIMAL_STACK_SIZE];
+
+void vApplicationGetIdleTaskMemory( StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer, uint32_t *pulIdleTaskStackSize )
+{
+	*ppxIdleTaskTCBBuffer = &xIdleTaskTCBBuffer;
+	*ppxIdleTaskStackBuffer = &xIdleStack[0];
+	*pulIdleTaskStackSize = configMINIMAL_STACK_SIZE;
+	/* place for user code */
+}
+/* USER CODE END GET_IDLE_TASK_MEMORY */
+
 /**
  * @brief  FreeRTOS initialization
  * @param  None
@@ -90,14 +140,20 @@ void MX_FREERTOS_Init(void) {
 
 	/* Create the thread(s) */
 	/* definition and creation of defaultTask */
-	osThreadDef(defaultTask, StartDefaultTask, osPriorityNormal, 0, 128);
+	osThreadStaticDef(defaultTask, StartDefaultTask, osPriorityAboveNormal, 0, 128, defaultTaskBuffer, &defaultTaskControlBlock);
 	defaultTaskHandle = osThreadCreate(osThread(defaultTask), NULL);
 
 	/* USER CODE BEGIN RTOS_THREADS */
 	/* add threads, ... */
+	utilsInit();
+	powerInit();
+	indicatorInit();
+	telemetryInit();
+	traceInit();
+	settingsInit();
 	usbifInit();
 	keyboardInit();
-	utilsInit();
+	benchInit();
 	/* USER CODE END RTOS_THREADS */
 
 }
@@ -115,12 +171,10 @@ void StartDefaultTask(void const * argument)
 	MX_USB_DEVICE_Init();
 
 	/* USER CODE BEGIN StartDefaultTask */
+	bootMark(bootMARK_USB_STARTED);
 	os_running = 1;
-	/* Infinite loop */
-	for(;;)
-	{
-		osDelay(1);
-	}
+	/* Nothing left to do once USB is up, give the stack back */
+	osThreadTerminate(NULL);
 	/* USER CODE END StartDefaultTask */
 }
 
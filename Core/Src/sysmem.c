@@ -52,17 +52,22 @@
 
 /* Variables */
 extern int errno;
-register char * stack_ptr asm("sp");
 
 /* Functions */
 
 /**
  _sbrk
  Increase program data space. Malloc and related functions depend on this
+
+ The heap is confined to the _Min_Heap_Size bytes the linker script reserves
+ after .bss. It is only used by newlib; RTOS objects and USB class data are
+ statically allocated. Comparing against the stack pointer does not work
+ under FreeRTOS since task stacks live below the heap, inside .bss.
 **/
 caddr_t _sbrk(int incr)
 {
 	extern char end asm("end");
+	extern char heap_size asm("_Min_Heap_Size");
 	static char *heap_end;
 	char *prev_heap_end;
 
@@ -70,7 +75,7 @@ caddr_t _sbrk(int incr)
 		heap_end = &end;
 
 	prev_heap_end = heap_end;
-	if (heap_end + incr > stack_ptr)
+	if (heap_end + incr > &end + (size_t)&heap_size)
 	{
 		errno = ENOMEM;
 		return (caddr_t) -1;
@@ -42,11 +42,25 @@
   * @{
   */
 #define HID_EPIN_ADDR                 0x81U
-#define HID_EPIN_SIZE                 0x05U
+#define HID_EPIN_SIZE                 0x08U  /* ID, modifiers, 6 keys */
 
 #define USB_HID_CONFIG_DESC_SIZ       34U
 #define USB_HID_DESC_SIZ              9U
-#define HID_KEYBOARD_REPORT_DESC_SIZE    78U
+#define HID_KEYBOARD_REPORT_DESC_SIZE    149U
+
+#define HID_TELEMETRY_REPORT_ID       0x03U
+#define HID_TELEMETRY_REPORT_SIZE     224U  /* Including the report ID */
+#define HID_TRACE_REPORT_ID           0x04U
+#define HID_TRACE_REPORT_SIZE         64U   /* Including the report ID */
+#define HID_BENCH_REPORT_ID           0x05U
+#define HID_BENCH_REPORT_SIZE         160U  /* Including the report ID */
+#define HID_HEALTH_REPORT_ID          0x06U
+#define HID_HEALTH_REPORT_SIZE        64U   /* Including the report ID */
+#define HID_SETTINGS_REPORT_ID        0x07U
+#define HID_SETTINGS_REPORT_SIZE      64U   /* Including the report ID */
+
+/* Largest SET_REPORT data stage accepted on the control pipe */
+#define HID_SET_REPORT_MAX            64U
 
 #define HID_DESCRIPTOR_TYPE           0x21U
 #define HID_REPORT_DESC               0x22U
@@ -67,6 +81,10 @@
 
 #define HID_REQ_SET_REPORT            0x09U
 #define HID_REQ_GET_REPORT            0x01U
+
+#define HID_REPORT_TYPE_INPUT         0x01U
+#define HID_REPORT_TYPE_OUTPUT        0x02U
+#define HID_REPORT_TYPE_FEATURE       0x03U
 /**
   * @}
   */
@@ -83,12 +101,25 @@ typedef enum
 HID_StateTypeDef;
 
 
+typedef enum
+{
+  HID_EVENT_CONFIGURED = 0,
+  HID_EVENT_DECONFIGURED,
+  HID_EVENT_REPORT_SENT,
+}
+HID_EventTypeDef;
+
+
 typedef struct
 {
   uint32_t             Protocol;
   uint32_t             IdleState;
   uint32_t             AltSetting;
   HID_StateTypeDef     state;
+  uint8_t              ReportType;   /* Pending SET_REPORT */
+  uint8_t              ReportId;
+  uint16_t             ReportLen;
+  uint8_t              ReportBuf[HID_SET_REPORT_MAX];
 }
 USBD_HID_HandleTypeDef;
 /**
@@ -124,6 +155,20 @@ uint8_t USBD_HID_SendReport (USBD_HandleTypeDef *pdev,
 
 uint32_t USBD_HID_GetPollingInterval (USBD_HandleTypeDef *pdev);
 
+void USBD_HID_EventCallback (USBD_HandleTypeDef *pdev,
+                             HID_EventTypeDef event);
+
+uint8_t *USBD_HID_GetReportCallback (USBD_HandleTypeDef *pdev,
+                                     uint8_t type,
+                                     uint8_t id,
+                                     uint16_t *len);
+
+void USBD_HID_SetReportCallback (USBD_HandleTypeDef *pdev,
+                                 uint8_t type,
+                                 uint8_t id,
+                                 uint8_t *report,
+                                 uint16_t len);
+
 /**
   * @}
   */
@@ -108,6 +108,8 @@ static uint8_t  *USBD_HID_GetOtherSpeedCfgDesc (uint16_t *length);
 static uint8_t  *USBD_HID_GetDeviceQualifierDesc (uint16_t *length);
 
 static uint8_t  USBD_HID_DataIn (USBD_HandleTypeDef *pdev, uint8_t epnum);
+
+static uint8_t  USBD_HID_EP0_RxReady (USBD_HandleTypeDef *pdev);
 /**
  * @}
  */
@@ -122,7 +124,7 @@ USBD_ClassTypeDef  USBD_HID =
 		USBD_HID_DeInit,
 		USBD_HID_Setup,
 		NULL, /*EP0_TxSent*/
-		NULL, /*EP0_RxReady*/
+		USBD_HID_EP0_RxReady, /*EP0_RxReady*/
 		USBD_HID_DataIn, /*DataIn*/
 		NULL, /*DataOut*/
 		NULL, /*SOF */
@@ -178,7 +180,7 @@ __ALIGN_BEGIN static uint8_t USBD_HID_CfgFSDesc[USB_HID_CONFIG_DESC_SIZ]  __ALIG
 
 		HID_EPIN_ADDR,     /*bEndpointAddress: Endpoint Address (IN)*/
 		0x03,          /*bmAttributes: Interrupt endpoint*/
-		HID_EPIN_SIZE, /*wMaxPacketSize: 4 Byte max */
+		HID_EPIN_SIZE, /*wMaxPacketSize: one keyboard report */
 		0x00,
 		HID_FS_BINTERVAL,          /*bInterval: Polling Interval */
 		/* 34 */
@@ -228,7 +230,7 @@ __ALIGN_BEGIN static uint8_t USBD_HID_CfgHSDesc[USB_HID_CONFIG_DESC_SIZ]  __ALIG
 
 		HID_EPIN_ADDR,     /*bEndpointAddress: Endpoint Address (IN)*/
 		0x03,          /*bmAttributes: Interrupt endpoint*/
-		HID_EPIN_SIZE, /*wMaxPacketSize: 4 Byte max */
+		HID_EPIN_SIZE, /*wMaxPacketSize: one keyboard report */
 		0x00,
 		HID_HS_BINTERVAL,          /*bInterval: Polling Interval */
 		/* 34 */
@@ -278,7 +280,7 @@ __ALIGN_BEGIN static uint8_t USBD_HID_OtherSpeedCfgDesc[USB_HID_CONFIG_DESC_SIZ]
 
 		HID_EPIN_ADDR,     /*bEndpointAddress: Endpoint Address (IN)*/
 		0x03,          /*bmAttributes: Interrupt endpoint*/
-		HID_EPIN_SIZE, /*wMaxPacketSize: 4 Byte max */
+		HID_EPIN_SIZE, /*wMaxPacketSize: one keyboard report */
 		0x00,
 		HID_FS_BINTERVAL,          /*bInterval: Polling Interval */
 		/* 34 */
@@ -317,7 +319,7 @@ __ALIGN_BEGIN static uint8_t USBD_HID_DeviceQualifierDesc[USB_LEN_DEV_QUALIFIER_
 
 __ALIGN_BEGIN static uint8_t HID_KEYBOARD_ReportDesc[HID_KEYBOARD_REPORT_DESC_SIZE]  __ALIGN_END =
 {
-		// 78 bytes
+		// 149 bytes
 		0x05, 0x01,        //   Usage Page (Generic Desktop Ctrls)
 		0x09, 0x06,        //   Usage (Keyboard)
 		0xA1, 0x01,        //   Collection (Application)
@@ -330,10 +332,18 @@ __ALIGN_BEGIN static uint8_t HID_KEYBOARD_ReportDesc[HID_KEYBOARD_REPORT_DESC_SI
 		0x15, 0x00,        //   Logical Minimum (0)
 		0x25, 0x01,        //   Logical Maximum (1)
 		0x81, 0x02,        //   Input (Data,Var,Abs,No Wrap,Linear,Preferred State,No Null Position)
-		0x95, 0x03,        //   Report Count (3)
+		0x95, 0x05,        //   Report Count (5)
+		0x05, 0x08,        //   Usage Page (LEDs)
+		0x19, 0x01,        //   Usage Minimum (Num Lock)
+		0x29, 0x05,        //   Usage Maximum (Kana)
+		0x91, 0x02,        //   Output (Data,Var,Abs,No Wrap,Linear,Preferred State,No Null Position,Non-volatile)
+		0x95, 0x01,        //   Report Count (1)
+		0x75, 0x03,        //   Report Size (3)
+		0x91, 0x03,        //   Output (Const,Var,Abs,No Wrap,Linear,Preferred State,No Null Position,Non-volatile)
+		0x95, 0x06,        //   Report Count (6)
 		0x75, 0x08,        //   Report Size (8)
 		0x15, 0x00,        //   Logical Minimum (0)
-		0x25, 0x64,        //   Logical Maximum (100)
+		0x25, 0x65,        //   Logical Maximum (101)
 		0x05, 0x07,        //   Usage Page (Kbrd/Keypad)
 		0x19, 0x00,        //   Usage Minimum (0x00)
 		0x29, 0x65,        //   Usage Maximum (0x65)
@@ -357,6 +367,33 @@ __ALIGN_BEGIN static uint8_t HID_KEYBOARD_ReportDesc[HID_KEYBOARD_REPORT_DESC_SI
 		0x09, 0xE9,        //   Usage (Volume Increment)
 		0x09, 0xEA,        //   Usage (Volume Decrement)
 		0x81, 0x02,        //   Input (Data,Var,Abs,No Wrap,Linear,Preferred State,No Null Position)
+		0xC0,              //   End Collection
+		0x06, 0x00, 0xFF,  //   Usage Page (Vendor Defined 0xFF00)
+		0x09, 0x01,        //   Usage (0x01)
+		0xA1, 0x01,        //   Collection (Application)
+		0x85, HID_TELEMETRY_REPORT_ID, //   Report ID (3)
+		0x15, 0x00,        //   Logical Minimum (0)
+		0x26, 0xFF, 0x00,  //   Logical Maximum (255)
+		0x75, 0x08,        //   Report Size (8)
+		0x95, HID_TELEMETRY_REPORT_SIZE - 1U, //   Report Count (223)
+		0x09, 0x01,        //   Usage (0x01)
+		0xB1, 0x02,        //   Feature (Data,Var,Abs,No Wrap,Linear,Preferred State,No Null Position,Non-volatile)
+		0x85, HID_TRACE_REPORT_ID, //   Report ID (4)
+		0x95, HID_TRACE_REPORT_SIZE - 1U, //   Report Count (63)
+		0x09, 0x02,        //   Usage (0x02)
+		0xB1, 0x02,        //   Feature (Data,Var,Abs,No Wrap,Linear,Preferred State,No Null Position,Non-volatile)
+		0x85, HID_BENCH_REPORT_ID, //   Report ID (5)
+		0x95, HID_BENCH_REPORT_SIZE - 1U, //   Report Count (159)
+		0x09, 0x03,        //   Usage (0x03)
+		0xB1, 0x02,        //   Feature (Data,Var,Abs,No Wrap,Linear,Preferred State,No Null Position,Non-volatile)
+		0x85, HID_HEALTH_REPORT_ID, //   Report ID (6)
+		0x95, HID_HEALTH_REPORT_SIZE - 1U, //   Report Count (63)
+		0x09, 0x04,        //   Usage (0x04)
+		0xB1, 0x02,        //   Feature (Data,Var,Abs,No Wrap,Linear,Preferred State,No Null Position,Non-volatile)
+		0x85, HID_SETTINGS_REPORT_ID, //   Report ID (7)
+		0x95, HID_SETTINGS_REPORT_SIZE - 1U, //   Report Count (63)
+		0x09, 0x05,        //   Usage (0x05)
+		0xB1, 0x02,        //   Feature (Data,Var,Abs,No Wrap,Linear,Preferred State,No Null Position,Non-volatile)
 		0xC0               //   End Collection
 };
 
@@ -390,6 +427,8 @@ static uint8_t  USBD_HID_Init (USBD_HandleTypeDef *pdev, uint8_t cfgidx)
 
 	((USBD_HID_HandleTypeDef *)pdev->pClassData)->state = HID_IDLE;
 
+	USBD_HID_EventCallback(pdev, HID_EVENT_CONFIGURED);
+
 	return USBD_OK;
 }
 
@@ -414,6 +453,8 @@ static uint8_t  USBD_HID_DeInit (USBD_HandleTypeDef *pdev,
 		pdev->pClassData = NULL;
 	}
 
+	USBD_HID_EventCallback(pdev, HID_EVENT_DECONFIGURED);
+
 	return USBD_OK;
 }
 
@@ -454,6 +495,31 @@ static uint8_t  USBD_HID_Setup (USBD_HandleTypeDef *pdev,
 			USBD_CtlSendData (pdev, (uint8_t *)(void *)&hhid->IdleState, 1U);
 			break;
 
+		case HID_REQ_GET_REPORT:
+			pbuf = USBD_HID_GetReportCallback (pdev, (uint8_t)(req->wValue >> 8),
+					(uint8_t)(req->wValue), &len);
+			if (pbuf == NULL)
+			{
+				USBD_CtlError (pdev, req);
+				ret = USBD_FAIL;
+				break;
+			}
+			USBD_CtlSendData (pdev, pbuf, MIN(len, req->wLength));
+			break;
+
+		case HID_REQ_SET_REPORT:
+			if (req->wLength == 0U || req->wLength > HID_SET_REPORT_MAX)
+			{
+				USBD_CtlError (pdev, req);
+				ret = USBD_FAIL;
+				break;
+			}
+			hhid->ReportType = (uint8_t)(req->wValue >> 8);
+			hhid->ReportId = (uint8_t)(req->wValue);
+			hhid->ReportLen = req->wLength;
+			USBD_CtlPrepareRx (pdev, hhid->ReportBuf, hhid->ReportLen);
+			break;
+
 		default:
 			USBD_CtlError (pdev, req);
 			ret = USBD_FAIL;
@@ -540,7 +606,8 @@ static uint8_t  USBD_HID_Setup (USBD_HandleTypeDef *pdev,
  *         Send HID Report
  * @param  pdev: device instance
  * @param  buff: pointer to report
- * @retval status
+ * @retval USBD_OK if the transfer was queued, USBD_BUSY if the previous
+ *         report is still in flight, USBD_FAIL if the device is not configured
  */
 uint8_t USBD_HID_SendReport     (USBD_HandleTypeDef  *pdev,
 		uint8_t *report,
@@ -557,9 +624,11 @@ uint8_t USBD_HID_SendReport     (USBD_HandleTypeDef  *pdev,
 					HID_EPIN_ADDR,
 					report,
 					len);
+			return USBD_OK;
 		}
+		return USBD_BUSY;
 	}
-	return USBD_OK;
+	return USBD_FAIL;
 }
 
 /**
@@ -643,9 +712,93 @@ static uint8_t  USBD_HID_DataIn (USBD_HandleTypeDef *pdev,
 	/* Ensure that the FIFO is empty before a new transfer, this condition could
   be caused by  a new transfer before the end of the previous transfer */
 	((USBD_HID_HandleTypeDef *)pdev->pClassData)->state = HID_IDLE;
+	USBD_HID_EventCallback(pdev, HID_EVENT_REPORT_SENT);
 	return USBD_OK;
 }
 
+/**
+ * @brief  USBD_HID_EP0_RxReady
+ *         handle the data stage of a SET_REPORT request
+ * @param  pdev: device instance
+ * @retval status
+ */
+static uint8_t  USBD_HID_EP0_RxReady (USBD_HandleTypeDef *pdev)
+{
+	USBD_HID_HandleTypeDef *hhid = (USBD_HID_HandleTypeDef*) pdev->pClassData;
+
+	if (hhid != NULL && hhid->ReportLen != 0U)
+	{
+		USBD_HID_SetReportCallback (pdev, hhid->ReportType, hhid->ReportId,
+				hhid->ReportBuf, hhid->ReportLen);
+		hhid->ReportLen = 0U;
+	}
+	return USBD_OK;
+}
+
+/**
+ * @brief  USBD_HID_EventCallback
+ *         Notifies the application of class state changes. Called from the
+ *         USB interrupt, so implementations must only use ISR-safe calls.
+ * @param  pdev: device instance
+ * @param  event: what happened
+ * @retval None
+ */
+__weak void USBD_HID_EventCallback (USBD_HandleTypeDef *pdev,
+		HID_EventTypeDef event)
+{
+	UNUSED(pdev);
+	UNUSED(event);
+}
+
+
+/**
+ * @brief  USBD_HID_GetReportCallback
+ *         Supplies the data stage of a GET_REPORT request. Called from the
+ *         USB interrupt; the returned buffer must stay valid until the
+ *         control transfer completes.
+ * @param  pdev: device instance
+ * @param  type: HID_REPORT_TYPE_INPUT, _OUTPUT or _FEATURE
+ * @param  id: report ID
+ * @param  len: set to the report length, including the ID
+ * @retval pointer to the report, or NULL to stall the request
+ */
+__weak uint8_t *USBD_HID_GetReportCallback (USBD_HandleTypeDef *pdev,
+		uint8_t type,
+		uint8_t id,
+		uint16_t *len)
+{
+	UNUSED(pdev);
+	UNUSED(type);
+	UNUSED(id);
+	*len = 0U;
+	return NULL;
+}
+
+
+/**
+ * @brief  USBD_HID_SetReportCallback
+ *         Delivers the data stage of a SET_REPORT request. Called from the
+ *         USB interrupt; the buffer is only valid for the duration of the call.
+ * @param  pdev: device instance
+ * @param  type: HID_REPORT_TYPE_INPUT, _OUTPUT or _FEATURE
+ * @param  id: report ID
+ * @param  report: report data, starting with the ID if the report has one
+ * @param  len: length of the data stage
+ * @retval None
+ */
+__weak void USBD_HID_SetReportCallback (USBD_HandleTypeDef *pdev,
+		uint8_t type,
+		uint8_t id,
+		uint8_t *report,
+		uint16_t len)
+{
+	UNUSED(pdev);
+	UNUSED(type);
+	UNUSED(id);
+	UNUSED(report);
+	UNUSED(len);
+}
+
 
 /**
  * @brief  DeviceQualifierDescriptor
@@ -0,0 +1,50 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file FreeRTOSConfig.h
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief Firmware kernel configuration, adjusted for the host port
+ ******************************************************************************/
+// @formatter:off
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __SIM_FREERTOS_CONFIG_H
+#define __SIM_FREERTOS_CONFIG_H
+
+/**
+ * The firmware's own configuration is used as is, so priorities, tick rate and
+ * the trace and telemetry hooks match the board. Only what cannot work on a
+ * host is replaced: the sleep hook, the Cortex-M specific task selection, the
+ * run time counter read straight from the DWT address, and an assert that
+ * would hang with interrupts off.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "../../Core/Inc/FreeRTOSConfig.h"
+
+/* Defines -------------------------------------------------------------------*/
+#undef configUSE_TICKLESS_IDLE
+#define configUSE_TICKLESS_IDLE						0
+#undef portSUPPRESS_TICKS_AND_SLEEP
+
+/* The idle task is where virtual time moves on when nothing is ready */
+#undef configUSE_IDLE_HOOK
+#define configUSE_IDLE_HOOK							1
+
+#undef configUSE_PORT_OPTIMISED_TASK_SELECTION
+#define configUSE_PORT_OPTIMISED_TASK_SELECTION		0
+
+extern uint32_t simClockCycles(void);
+#undef portGET_RUN_TIME_COUNTER_VALUE
+#define portGET_RUN_TIME_COUNTER_VALUE()			simClockCycles()
+
+extern void simAssert(const char *file, int line);
+#undef configASSERT
+#define configASSERT(x)								if ((x) == 0) { simAssert(__FILE__, __LINE__); }
+
+#undef vPortSVCHandler
+#undef xPortPendSVHandler
+#undef xPortSysTickHandler
+
+#endif /* __SIM_FREERTOS_CONFIG_H */
+/* EOF */
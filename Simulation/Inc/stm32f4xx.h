@@ -0,0 +1,102 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file stm32f4xx.h
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief Host stand-in for the CMSIS device header
+ ******************************************************************************/
+// @formatter:off
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __STM32F4xx_H
+#define __STM32F4xx_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Only what the firmware sources outside Drivers/ actually touch. Peripherals
+ * are plain structs in host memory; the ones that have to behave, GPIO and the
+ * DWT cycle counter, are kept up to date by Simulation/Src/sim_gpio.c and
+ * sim_clock.c.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stddef.h>
+
+/* Defines -------------------------------------------------------------------*/
+#define __IO						volatile
+#define __I							volatile const
+#define __O							volatile
+#define __NVIC_PRIO_BITS			( 4U )
+
+#define DWT_CTRL_CYCCNTENA_Msk		( 1UL << 0 )
+#define CoreDebug_DEMCR_TRCENA_Msk	( 1UL << 24 )
+
+/* Structures ----------------------------------------------------------------*/
+typedef struct
+{
+	__IO uint32_t MODER;
+	__IO uint32_t OTYPER;
+	__IO uint32_t OSPEEDR;
+	__IO uint32_t PUPDR;
+	__IO uint32_t IDR;
+	__IO uint32_t ODR;
+	__IO uint32_t BSRR;
+	__IO uint32_t LCKR;
+	__IO uint32_t AFR[2];
+} GPIO_TypeDef;
+
+typedef struct
+{
+	__IO uint32_t CTRL;
+	__IO uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct
+{
+	__IO uint32_t DEMCR;
+} CoreDebug_Type;
+
+/* Exported macros -----------------------------------------------------------*/
+/* Every access to DWT advances the virtual clock, so cycle waits terminate */
+#define DWT							( simClockDwt() )
+#define CoreDebug					( &simCoreDebug )
+
+#define GPIOA						( &simGpioA )
+#define GPIOB						( &simGpioB )
+#define GPIOC						( &simGpioC )
+
+/* Unique device ID, read by usbd_desc.c for the serial number string */
+#define UID_BASE					( (uintptr_t)simUid )
+
+/* Prototypes ----------------------------------------------------------------*/
+DWT_Type *simClockDwt(void);
+uint32_t ulPortSimException(void);
+
+/**
+ * @brief Active exception number, as the firmware's trace hooks expect
+ * @param none
+ * @retval 0 in a task, otherwise the simulated interrupt's exception number
+ */
+static inline uint32_t __get_IPSR(void)
+{
+	return ulPortSimException();
+}
+
+/* Exported variables --------------------------------------------------------*/
+extern uint32_t SystemCoreClock;
+extern CoreDebug_Type simCoreDebug;
+extern GPIO_TypeDef simGpioA;
+extern GPIO_TypeDef simGpioB;
+extern GPIO_TypeDef simGpioC;
+extern const uint32_t simUid[3];
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __STM32F4xx_H */
+/* EOF */
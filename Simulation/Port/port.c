@@ -0,0 +1,311 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file port.c
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief FreeRTOS port that runs the real kernel on one host thread
+ ******************************************************************************/
+// @formatter:off
+
+/* Includes ------------------------------------------------------------------*/
+#include "FreeRTOS.h"
+#include "task.h"
+#include "sim_clock.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <ucontext.h>
+
+/**
+ * Every task is a ucontext on its own host stack, and only one ever runs, so
+ * the simulation is deterministic and needs no locking. Nothing preempts a
+ * task on its own: time only moves when the firmware reads the cycle counter
+ * or a simulated peripheral, or when the idle task runs (see sim_clock.c).
+ * Interrupts are delivered at those points, and a context switch they ask for
+ * happens there too, exactly as PendSV would on the board.
+ *
+ * Interrupts are masked inside critical sections, inside a handler and while
+ * switching. Whatever became due meanwhile is delivered when the mask drops.
+ *
+ * The kernel still hands each task its static stack, but the task runs on a
+ * host stack big enough for glibc's printf; the static one is left untouched.
+ */
+
+/* Defines -------------------------------------------------------------------*/
+#define portSIM_STACK_BYTES			( 256 * 1024 )
+#define portINITIAL_NESTING			( 0xAAAAAAAAUL )	/* Masked until started */
+
+/* Private types -------------------------------------------------------------*/
+typedef struct _PORT_THREAD_S_
+{
+	ucontext_t context;
+	TaskFunction_t code;
+	void *parameters;
+} port_thread_t;
+
+/* Private variables ---------------------------------------------------------*/
+extern void * volatile pxCurrentTCB;
+
+static ucontext_t schedulerContext;
+static UBaseType_t criticalNesting = portINITIAL_NESTING;
+static _Bool interruptsOff;
+static _Bool yieldPending;
+static uint8_t exceptionNumber;		/* 0 in a task */
+
+/* Static prototypes ---------------------------------------------------------*/
+static port_thread_t *portCurrentThread(void);
+static void portTaskEntry(void);
+static void portSwitch(void);
+static void portUnmasked(void);
+
+/* Code ----------------------------------------------------------------------*/
+/**
+ * @brief Finds the host thread of the running task
+ * @note The port owns the first word of every TCB, the "top of stack".
+ * @param none
+ * @retval Thread set up by pxPortInitialiseStack()
+ */
+static port_thread_t *portCurrentThread(void)
+{
+	return *(port_thread_t **)pxCurrentTCB;
+}
+
+/**
+ * @brief First code every task runs, on its own host stack
+ * @param none
+ * @retval none
+ */
+static void portTaskEntry(void)
+{
+	port_thread_t *thread = portCurrentThread();
+
+	criticalNesting = 0;
+	portUnmasked();
+	thread->code(thread->parameters);
+	fprintf(stderr, "sim: a task returned from its function\n");
+	abort();
+}
+
+/**
+ * @brief Picks the next task and switches to it
+ * @note Returns once this task is picked again.
+ * @param none
+ * @retval none
+ */
+static void portSwitch(void)
+{
+	port_thread_t *from = portCurrentThread();
+	port_thread_t *to;
+
+	yieldPending = 0;
+	criticalNesting++;
+	vTaskSwitchContext();
+	to = portCurrentThread();
+	if (to != from)
+	{
+		swapcontext(&from->context, &to->context);
+	}
+	criticalNesting--;
+	portUnmasked();
+}
+
+/**
+ * @brief Delivers whatever the mask held back, then any switch it asked for
+ * @param none
+ * @retval none
+ */
+static void portUnmasked(void)
+{
+	if (xPortInterruptsMasked())
+	{
+		return;
+	}
+	simClockService();
+	if (yieldPending && !xPortInterruptsMasked())
+	{
+		portSwitch();
+	}
+}
+
+/**
+ * @brief Sets up a new task's host thread
+ * @param pxTopOfStack Unused, the task runs on a host stack
+ * @param pxCode Task function
+ * @param pvParameters Task function argument
+ * @retval Handle the kernel stores as the task's top of stack
+ */
+StackType_t *pxPortInitialiseStack(StackType_t *pxTopOfStack, TaskFunction_t pxCode,
+		void *pvParameters)
+{
+	port_thread_t *thread = calloc(1, sizeof(port_thread_t));
+
+	(void)pxTopOfStack;
+	if (thread == NULL || getcontext(&thread->context) != 0)
+	{
+		abort();
+	}
+	thread->code = pxCode;
+	thread->parameters = pvParameters;
+	thread->context.uc_stack.ss_sp = malloc(portSIM_STACK_BYTES);
+	thread->context.uc_stack.ss_size = portSIM_STACK_BYTES;
+	thread->context.uc_link = NULL;
+	if (thread->context.uc_stack.ss_sp == NULL)
+	{
+		abort();
+	}
+	makecontext(&thread->context, portTaskEntry, 0);
+	return (StackType_t *)thread;
+}
+
+/**
+ * @brief Runs the first task, returns when vTaskEndScheduler() is called
+ * @param none
+ * @retval pdFALSE once the scheduler has ended
+ */
+BaseType_t xPortStartScheduler(void)
+{
+	interruptsOff = 0;
+	simClockStart();
+	swapcontext(&schedulerContext, &portCurrentThread()->context);
+	return pdFALSE;
+}
+
+/**
+ * @brief Abandons every task and resumes the caller of vTaskStartScheduler()
+ * @param none
+ * @retval none
+ */
+void vPortEndScheduler(void)
+{
+	criticalNesting = portINITIAL_NESTING;
+	setcontext(&schedulerContext);
+}
+
+/**
+ * @brief Requests a context switch
+ * @note Deferred while interrupts are masked, like PendSV.
+ * @param none
+ * @retval none
+ */
+void vPortYield(void)
+{
+	yieldPending = 1;
+	if (!xPortInterruptsMasked())
+	{
+		portSwitch();
+	}
+}
+
+/**
+ * @brief Masks interrupts until vPortEnableInterrupts()
+ * @param none
+ * @retval none
+ */
+void vPortDisableInterrupts(void)
+{
+	interruptsOff = 1;
+}
+
+/**
+ * @brief Unmasks interrupts
+ * @param none
+ * @retval none
+ */
+void vPortEnableInterrupts(void)
+{
+	interruptsOff = 0;
+	portUnmasked();
+}
+
+/**
+ * @brief Enters a critical section
+ * @param none
+ * @retval none
+ */
+void vPortEnterCritical(void)
+{
+	criticalNesting++;
+}
+
+/**
+ * @brief Leaves a critical section, delivering anything that came due
+ * @param none
+ * @retval none
+ */
+void vPortExitCritical(void)
+{
+	criticalNesting--;
+	portUnmasked();
+}
+
+/**
+ * @brief Masks interrupts from inside a handler
+ * @param none
+ * @retval Value for vPortClearInterruptMask(), unused
+ */
+UBaseType_t ulPortSetInterruptMask(void)
+{
+	criticalNesting++;
+	return 0;
+}
+
+/**
+ * @brief Undoes ulPortSetInterruptMask()
+ * @param ulMask Unused
+ * @retval none
+ */
+void vPortClearInterruptMask(UBaseType_t ulMask)
+{
+	(void)ulMask;
+	vPortExitCritical();
+}
+
+/**
+ * @brief Tells whether the caller runs in a simulated interrupt
+ * @param none
+ * @retval pdTRUE inside a handler
+ */
+BaseType_t xPortIsInsideInterrupt(void)
+{
+	return exceptionNumber != 0 ? pdTRUE : pdFALSE;
+}
+
+/**
+ * @brief Tells whether an interrupt could be delivered right now
+ * @param none
+ * @retval 1 before the scheduler runs, in a critical section or a handler
+ */
+_Bool xPortInterruptsMasked(void)
+{
+	return criticalNesting != 0 || interruptsOff || exceptionNumber != 0;
+}
+
+/**
+ * @brief Runs a simulated interrupt handler
+ * @note Only call it while xPortInterruptsMasked() is 0. A switch the handler
+ *       asks for happens on the way out.
+ * @param handler Handler to run
+ * @param exception Exception number it runs as, what __get_IPSR() returns
+ * @retval none
+ */
+void vPortSimInterrupt(void (*handler)(void), uint8_t exception)
+{
+	exceptionNumber = exception;
+	handler();
+	exceptionNumber = 0;
+	if (yieldPending && !xPortInterruptsMasked())
+	{
+		portSwitch();
+	}
+}
+
+/**
+ * @brief Exception number for __get_IPSR()
+ * @param none
+ * @retval 0 in a task, otherwise the running handler's exception number
+ */
+uint32_t ulPortSimException(void)
+{
+	return exceptionNumber;
+}
+/* EOF */
@@ -0,0 +1,80 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file portmacro.h
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief FreeRTOS port definitions for the single threaded host simulation
+ ******************************************************************************/
+// @formatter:off
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef PORTMACRO_H
+#define PORTMACRO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Defines -------------------------------------------------------------------*/
+#define portCHAR					char
+#define portFLOAT					float
+#define portDOUBLE					double
+#define portLONG					long
+#define portSHORT					short
+#define portSTACK_TYPE				uintptr_t
+#define portBASE_TYPE				long
+#define portPOINTER_SIZE_TYPE		uintptr_t
+
+typedef portSTACK_TYPE StackType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define portMAX_DELAY				( (TickType_t)0xffffffffUL )
+#define portTICK_TYPE_IS_ATOMIC		1
+#define portSTACK_GROWTH			( -1 )
+#define portTICK_PERIOD_MS			( (TickType_t)1000 / configTICK_RATE_HZ )
+#define portBYTE_ALIGNMENT			8
+
+/* Scheduling, see port.c */
+#define portYIELD()					vPortYield()
+#define portYIELD_WITHIN_API()		vPortYield()
+#define portEND_SWITCHING_ISR(x)	do { if ((x) != pdFALSE) vPortYield(); } while (0)
+#define portYIELD_FROM_ISR(x)		portEND_SWITCHING_ISR(x)
+
+/* Critical sections, see port.c */
+#define portDISABLE_INTERRUPTS()				vPortDisableInterrupts()
+#define portENABLE_INTERRUPTS()					vPortEnableInterrupts()
+#define portENTER_CRITICAL()					vPortEnterCritical()
+#define portEXIT_CRITICAL()						vPortExitCritical()
+#define portSET_INTERRUPT_MASK_FROM_ISR()		ulPortSetInterruptMask()
+#define portCLEAR_INTERRUPT_MASK_FROM_ISR(x)	vPortClearInterruptMask(x)
+
+#define portTASK_FUNCTION_PROTO(vFunction, pvParameters)	void vFunction(void *pvParameters)
+#define portTASK_FUNCTION(vFunction, pvParameters)			void vFunction(void *pvParameters)
+
+#define portNOP()
+
+/* Prototypes ----------------------------------------------------------------*/
+void vPortYield(void);
+void vPortDisableInterrupts(void);
+void vPortEnableInterrupts(void);
+void vPortEnterCritical(void);
+void vPortExitCritical(void);
+UBaseType_t ulPortSetInterruptMask(void);
+void vPortClearInterruptMask(UBaseType_t ulMask);
+BaseType_t xPortIsInsideInterrupt(void);
+
+/* Host side, for the simulated peripherals */
+_Bool xPortInterruptsMasked(void);
+void vPortSimInterrupt(void (*handler)(void), uint8_t exception);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PORTMACRO_H */
+/* EOF */
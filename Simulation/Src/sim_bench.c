@@ -0,0 +1,291 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file sim_bench.c
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief Debounce benchmark: scores the firmware's key edges against the script
+ ******************************************************************************/
+// @formatter:off
+
+/* Includes ------------------------------------------------------------------*/
+#include "sim_bench.h"
+#include "sim_clock.h"
+#include "sim_matrix.h"
+
+#include "main.h"
+#include "../../Core/Src/Keyboard/keyboard.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Whatever keyboardRefresh() is built in gets measured. The Makefile wraps
+ * the trace hooks the firmware already calls, so the debounced edges and the
+ * scan task's time on the CPU are seen without touching firmware code.
+ *
+ * Each key's debounced edges are walked against its scripted presses and
+ * releases in time order. An edge in the expected direction closes the
+ * event and gives its latency from the first contact change; any other edge
+ * is a false trigger; an event still open when the next one comes, or at the
+ * end, was missed.
+ *
+ * Cycles are virtual: only GPIO accesses and cycle counter waits cost
+ * anything in the simulation, so this is the scan's I/O and settle time, not
+ * its code. Time code on the board.
+ */
+
+/* Defines -------------------------------------------------------------------*/
+#define INITIAL_CAPACITY	( 256 )
+
+/* Private types -------------------------------------------------------------*/
+typedef struct _BENCH_EDGE_S_
+{
+	uint64_t atUs;
+	uint16_t key;
+	_Bool pressed;
+} bench_edge_t;
+
+typedef struct _BENCH_LATENCIES_S_
+{
+	uint32_t *us;
+	uint32_t count;
+	uint32_t capacity;
+} bench_latencies_t;
+
+/* Private variables ---------------------------------------------------------*/
+static bench_edge_t *seen;
+static uint32_t seenCount;
+static uint32_t seenCapacity;
+
+static uint32_t scanTask;			/* TCB number, 0 until created */
+static uint32_t scanSwitchedIn;
+static uint64_t scanCycles;
+
+/* Static prototypes ---------------------------------------------------------*/
+static void simBenchAdd(bench_latencies_t *list, uint32_t us);
+static int simBenchCompare(const void *a, const void *b);
+static void simBenchPrint(FILE *out, const char *what, bench_latencies_t *list);
+
+/* Wrapped firmware hooks, see the Makefile */
+void __real_traceKeyEdge(uint16_t key, uint8_t pressed);
+void __real_traceTaskCreated(uint32_t ulTaskNumber, const char *pcName);
+void __real_traceTaskSwitchedIn(uint32_t ulTaskNumber);
+void __real_traceTaskSwitchedOut(uint32_t ulTaskNumber);
+
+/* Code ----------------------------------------------------------------------*/
+/**
+ * @brief Adds a latency to a list
+ * @param list List
+ * @param us Latency
+ * @retval none
+ */
+static void simBenchAdd(bench_latencies_t *list, uint32_t us)
+{
+	if (list->count == list->capacity)
+	{
+		list->capacity = list->capacity ? list->capacity * 2 : INITIAL_CAPACITY;
+		list->us = realloc(list->us, list->capacity * sizeof(uint32_t));
+		if (list->us == NULL)
+		{
+			abort();
+		}
+	}
+	list->us[list->count++] = us;
+}
+
+/**
+ * @brief qsort order for latencies
+ * @param a First
+ * @param b Second
+ * @retval <0, 0 or >0
+ */
+static int simBenchCompare(const void *a, const void *b)
+{
+	uint32_t ua = *(const uint32_t *)a;
+	uint32_t ub = *(const uint32_t *)b;
+
+	return (ua > ub) - (ua < ub);
+}
+
+/**
+ * @brief Prints a latency distribution
+ * @param out Where to
+ * @param what Label
+ * @param list Latencies, sorted here
+ * @retval none
+ */
+static void simBenchPrint(FILE *out, const char *what, bench_latencies_t *list)
+{
+	uint32_t nn = list->count;
+
+	if (nn == 0)
+	{
+		fprintf(out, "sim: debounce %-7s none\n", what);
+		return;
+	}
+	qsort(list->us, nn, sizeof(uint32_t), simBenchCompare);
+	fprintf(out, "sim: debounce %-7s %5u  min %.3f  p50 %.3f  p90 %.3f  p99 %.3f"
+			"  max %.3f ms\n", what, nn, list->us[0] / 1000.0,
+			list->us[(nn - 1) * 50 / 100] / 1000.0, list->us[(nn - 1) * 90 / 100] / 1000.0,
+			list->us[(nn - 1) * 99 / 100] / 1000.0, list->us[nn - 1] / 1000.0);
+}
+
+/**
+ * @brief Forgets everything seen so far
+ * @param none
+ * @retval none
+ */
+void simBenchInit(void)
+{
+	free(seen);
+	seen = NULL;
+	seenCount = 0;
+	seenCapacity = 0;
+	scanTask = 0;
+	scanCycles = 0;
+}
+
+/**
+ * @brief Scores the run and prints the numbers
+ * @param out Where to
+ * @param frames Scan frames the run took
+ * @retval none
+ */
+void simBenchReport(FILE *out, uint32_t frames)
+{
+	const sim_matrix_edge_t *edges;
+	uint32_t count = simMatrixGetEdges(&edges);
+	uint64_t endUs = simClockNowUs();
+	bench_latencies_t press = { 0 };
+	bench_latencies_t release = { 0 };
+	uint32_t falseEdges = 0;
+	uint32_t missed = 0;
+
+	for (uint16_t key = 0; key < keyboardNUM_KEYS; key++)
+	{
+		const sim_matrix_edge_t *pending = NULL;
+		uint32_t ee = 0;
+		uint32_t ss = 0;
+
+		for (;;)
+		{
+			const sim_matrix_edge_t *edge = NULL;
+			const bench_edge_t *got = NULL;
+
+			while (ee < count && (GET_IDX(edges[ee].col, edges[ee].row, keyboardNUM_COLS) != key
+					|| edges[ee].atUs > endUs))
+			{
+				ee++;
+			}
+			while (ss < seenCount && seen[ss].key != key)
+			{
+				ss++;
+			}
+			edge = (ee < count) ? &edges[ee] : NULL;
+			got = (ss < seenCount) ? &seen[ss] : NULL;
+			if (edge == NULL && got == NULL)
+			{
+				break;
+			}
+			if (edge != NULL && (got == NULL || edge->atUs <= got->atUs))
+			{
+				missed += (pending != NULL);
+				pending = edge;
+				ee++;
+			}
+			else
+			{
+				if (pending != NULL && pending->pressed == got->pressed)
+				{
+					simBenchAdd(pending->pressed ? &press : &release,
+							(uint32_t)(got->atUs - pending->atUs));
+					pending = NULL;
+				}
+				else
+				{
+					falseEdges++;
+				}
+				ss++;
+			}
+		}
+		missed += (pending != NULL);
+	}
+
+	simBenchPrint(out, "press", &press);
+	simBenchPrint(out, "release", &release);
+	fprintf(out, "sim: debounce %u false triggers, %u missed events\n",
+			falseEdges, missed);
+	fprintf(out, "sim: scan task %.0f cycles per frame, I/O and settle waits only\n",
+			frames ? (double)scanCycles / frames : 0.0);
+	free(press.us);
+	free(release.us);
+}
+
+/**
+ * @brief Notes each debounced edge, then passes it on
+ * @param key Key index
+ * @param pressed 1 for a press
+ * @retval none
+ */
+void __wrap_traceKeyEdge(uint16_t key, uint8_t pressed)
+{
+	if (seenCount == seenCapacity)
+	{
+		seenCapacity = seenCapacity ? seenCapacity * 2 : INITIAL_CAPACITY;
+		seen = realloc(seen, seenCapacity * sizeof(bench_edge_t));
+		if (seen == NULL)
+		{
+			abort();
+		}
+	}
+	seen[seenCount++] = (bench_edge_t) {
+		.atUs = simClockNowUs(),
+				.key = key,
+				.pressed = pressed
+	};
+	__real_traceKeyEdge(key, pressed);
+}
+
+/**
+ * @brief Picks out the scan task as it is created
+ * @param ulTaskNumber TCB number
+ * @param pcName Task name
+ * @retval none
+ */
+void __wrap_traceTaskCreated(uint32_t ulTaskNumber, const char *pcName)
+{
+	if (!strcmp(pcName, simbenchSCAN_TASK))
+	{
+		scanTask = ulTaskNumber;
+	}
+	__real_traceTaskCreated(ulTaskNumber, pcName);
+}
+
+/**
+ * @brief Starts the scan task's clock
+ * @param ulTaskNumber TCB number
+ * @retval none
+ */
+void __wrap_traceTaskSwitchedIn(uint32_t ulTaskNumber)
+{
+	if (ulTaskNumber == scanTask)
+	{
+		scanSwitchedIn = simClockCycles();
+	}
+	__real_traceTaskSwitchedIn(ulTaskNumber);
+}
+
+/**
+ * @brief Stops the scan task's clock
+ * @param ulTaskNumber TCB number
+ * @retval none
+ */
+void __wrap_traceTaskSwitchedOut(uint32_t ulTaskNumber)
+{
+	if (ulTaskNumber == scanTask)
+	{
+		scanCycles += simClockCycles() - scanSwitchedIn;
+	}
+	__real_traceTaskSwitchedOut(ulTaskNumber);
+}
+/* EOF */
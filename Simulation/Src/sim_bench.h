@@ -0,0 +1,36 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file sim_bench.h
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief Definitions and prototypes for the debounce benchmark
+ ******************************************************************************/
+// @formatter:off
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __SIM_BENCH_H
+#define __SIM_BENCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdio.h>
+
+/* Defines -------------------------------------------------------------------*/
+#define simbenchSCAN_TASK			"kbscan"	/* Task the cycles are counted for */
+
+/* Prototypes ----------------------------------------------------------------*/
+void simBenchInit(void);
+void simBenchReport(FILE *out, uint32_t frames);
+
+/* Exported variables --------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SIM_BENCH_H */
+/* EOF */
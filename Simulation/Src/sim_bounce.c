@@ -0,0 +1,270 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file sim_bounce.c
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief Switch waveform library: bounce, chatter and release ringing
+ ******************************************************************************/
+// @formatter:off
+
+/* Includes ------------------------------------------------------------------*/
+#include "sim_bounce.h"
+#include "sim_matrix.h"
+
+#include "../../Core/Src/Keyboard/keyboard.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * A buckling spring keystroke, as far as the membrane sees it: the hammer
+ * hits and the contact bounces for a few ms; a worn or dirty membrane may
+ * open for a moment while the key is held; on release the hammer leaves
+ * cleanly, then the spring rings and can touch the contact again a few ms
+ * later. The profiles below put numbers on that, from a new board to a
+ * neglected one. They are synthesized; recordings off a scope can be played
+ * back with simBounceReplay() in the same way.
+ *
+ * Every keystroke records its intended press and release with
+ * simMatrixEdge(), so the benchmark knows the truth whatever the contact
+ * does in between.
+ */
+
+/* Defines -------------------------------------------------------------------*/
+#define STROKE_HOLD_MIN_US		( 40000 )	/* Shortest deliberate keystroke */
+#define STROKE_HOLD_MAX_US		( 150000 )
+#define STROKE_GAP_MIN_US		( 30000 )	/* Between one settling and the next press */
+#define STROKE_GAP_MAX_US		( 120000 )
+
+/* Private variables ---------------------------------------------------------*/
+static const sim_bounce_profile_t profiles[] = {
+		{ .name = "ideal" },
+		{ .name = "crisp", .pressUs = 1000, .ringUs = 300,
+				.pulseMinUs = 30, .pulseMaxUs = 200 },
+		{ .name = "typical", .pressUs = 3000, .ringDelayUs = 1500, .ringUs = 1000,
+				.pulseMinUs = 50, .pulseMaxUs = 500 },
+		{ .name = "ringing", .pressUs = 2000, .ringDelayUs = 5000, .ringUs = 6000,
+				.pulseMinUs = 100, .pulseMaxUs = 600 },
+		{ .name = "worn", .pressUs = 8000, .ringDelayUs = 2000, .ringUs = 3000,
+				.pulseMinUs = 100, .pulseMaxUs = 1500,
+				.chatterPerSec = 2, .chatterUs = 400 },
+		{ .name = "dirty", .pressUs = 15000, .ringDelayUs = 1000, .ringUs = 5000,
+				.pulseMinUs = 200, .pulseMaxUs = 3000,
+				.chatterPerSec = 10, .chatterUs = 1500 },
+};
+
+/* Static prototypes ---------------------------------------------------------*/
+static uint32_t simBounceBetween(uint32_t min, uint32_t max);
+static void simBounceBurst(uint8_t row, uint8_t col, uint64_t atUs,
+		uint32_t lengthUs, const sim_bounce_profile_t *profile, _Bool endClosed);
+
+/* Code ----------------------------------------------------------------------*/
+/**
+ * @brief Seeded random value in a range
+ * @param min Lowest value
+ * @param max Highest value
+ * @retval Value
+ */
+static uint32_t simBounceBetween(uint32_t min, uint32_t max)
+{
+	return (max > min) ? min + simMatrixRandom() % (max - min + 1) : min;
+}
+
+/**
+ * @brief Adds a burst of pulses to a contact that has just changed
+ * @param row Matrix row
+ * @param col Matrix column
+ * @param atUs Start of the burst, the contact is in endClosed state here
+ * @param lengthUs Length of the burst
+ * @param profile Pulse widths
+ * @param endClosed State the contact settles in
+ * @retval none
+ */
+static void simBounceBurst(uint8_t row, uint8_t col, uint64_t atUs,
+		uint32_t lengthUs, const sim_bounce_profile_t *profile, _Bool endClosed)
+{
+	uint64_t at = atUs;
+	_Bool closed = endClosed;
+
+	if (lengthUs == 0)
+	{
+		return;
+	}
+	for (;;)
+	{
+		at += simBounceBetween(profile->pulseMinUs ? profile->pulseMinUs : 1,
+				profile->pulseMaxUs);
+		if (at >= atUs + lengthUs)
+		{
+			break;
+		}
+		closed = !closed;
+		simMatrixContact(row, col, at, closed);
+	}
+	if (closed != endClosed)
+	{
+		simMatrixContact(row, col, at, endClosed);
+	}
+}
+
+/**
+ * @brief Looks a profile up by name
+ * @param name Profile name
+ * @retval Profile, or NULL if there is none by that name
+ */
+const sim_bounce_profile_t *simBounceFind(const char *name)
+{
+	for (uint32_t ii = 0; ii < sizeof(profiles) / sizeof(profiles[0]); ii++)
+	{
+		if (!strcmp(profiles[ii].name, name))
+		{
+			return &profiles[ii];
+		}
+	}
+	return NULL;
+}
+
+/**
+ * @brief The built-in corpus
+ * @param count Set to the number of profiles
+ * @retval First profile
+ */
+const sim_bounce_profile_t *simBounceGetProfiles(uint32_t *count)
+{
+	*count = sizeof(profiles) / sizeof(profiles[0]);
+	return profiles;
+}
+
+/**
+ * @brief Schedules one keystroke
+ * @note The press burst is cut short if the key is let go within it.
+ * @param profile How the switch behaves
+ * @param row Matrix row
+ * @param col Matrix column
+ * @param atUs First contact
+ * @param holdUs First contact to first opening
+ * @retval none
+ */
+void simBounceStrike(const sim_bounce_profile_t *profile, uint8_t row,
+		uint8_t col, uint64_t atUs, uint64_t holdUs)
+{
+	uint64_t releaseUs = atUs + holdUs;
+	uint32_t pressUs = (profile->pressUs < holdUs / 2) ? profile->pressUs
+			: (uint32_t)(holdUs / 2);
+	uint64_t at = atUs + pressUs;
+
+	simMatrixEdge(row, col, atUs, 1);
+	simMatrixContact(row, col, atUs, 1);
+	simBounceBurst(row, col, atUs, pressUs, profile, 1);
+
+	while (profile->chatterPerSec)
+	{
+		/* Uniform gaps around the mean rate, enough for a benchmark */
+		at += simBounceBetween(0, 2000000U / profile->chatterPerSec);
+		if (at + profile->chatterUs >= releaseUs)
+		{
+			break;
+		}
+		simMatrixContact(row, col, at, 0);
+		simMatrixContact(row, col, at + profile->chatterUs, 1);
+	}
+
+	simMatrixEdge(row, col, releaseUs, 0);
+	simMatrixContact(row, col, releaseUs, 0);
+	if (profile->ringUs)
+	{
+		at = releaseUs + profile->ringDelayUs;
+		simBounceBurst(row, col, at, profile->ringUs, profile, 0);
+	}
+}
+
+/**
+ * @brief Schedules a run of keystrokes on random keys, one at a time
+ * @param profile How every switch behaves
+ * @param atUs First contact of the first keystroke
+ * @param count Keystrokes
+ * @retval Time the last keystroke has settled by
+ */
+uint64_t simBounceStrokes(const sim_bounce_profile_t *profile, uint64_t atUs,
+		uint32_t count)
+{
+	uint64_t at = atUs;
+
+	for (uint32_t ii = 0; ii < count; ii++)
+	{
+		uint16_t key = (uint16_t)(simMatrixRandom() % keyboardNUM_KEYS);
+		uint32_t holdUs = simBounceBetween(STROKE_HOLD_MIN_US, STROKE_HOLD_MAX_US);
+
+		simBounceStrike(profile, (uint8_t)(key / keyboardNUM_COLS),
+				(uint8_t)(key % keyboardNUM_COLS), at, holdUs);
+		at += holdUs + profile->ringDelayUs + profile->ringUs
+				+ simBounceBetween(STROKE_GAP_MIN_US, STROKE_GAP_MAX_US);
+	}
+	return at;
+}
+
+/**
+ * @brief Plays a recorded waveform back on one key
+ * @note One entry per line, times in us from the start, # for comments:
+ *         <t> 0|1       contact opens or closes
+ *         press <t>     where the press was meant to be
+ *         release <t>   where the release was meant to be
+ * @param path Recording
+ * @param row Matrix row
+ * @param col Matrix column
+ * @param atUs Where the recording's time 0 lands
+ * @param endUs Set to the time of its last change
+ * @retval 1 on success, 0 after printing what was wrong
+ */
+_Bool simBounceReplay(const char *path, uint8_t row, uint8_t col, uint64_t atUs,
+		uint64_t *endUs)
+{
+	FILE *in = fopen(path, "r");
+	char line[simbounceLINE_LEN];
+	unsigned long long at;
+	unsigned level;
+	int lineNo = 0;
+
+	if (in == NULL)
+	{
+		perror(path);
+		return 0;
+	}
+	*endUs = atUs;
+	while (fgets(line, sizeof(line), in) != NULL)
+	{
+		char *hash = strchr(line, '#');
+
+		lineNo++;
+		if (hash != NULL)
+		{
+			*hash = '\0';
+		}
+		if (sscanf(line, " press %llu", &at) == 1)
+		{
+			simMatrixEdge(row, col, atUs + at, 1);
+		}
+		else if (sscanf(line, " release %llu", &at) == 1)
+		{
+			simMatrixEdge(row, col, atUs + at, 0);
+		}
+		else if (sscanf(line, "%llu %u", &at, &level) == 2 && level <= 1)
+		{
+			simMatrixContact(row, col, atUs + at, level);
+		}
+		else if (strspn(line, " \t\r\n") != strlen(line))
+		{
+			fprintf(stderr, "%s:%d: cannot make sense of: %s", path, lineNo, line);
+			fclose(in);
+			return 0;
+		}
+		else
+		{
+			continue;
+		}
+		*endUs = (atUs + at > *endUs) ? atUs + at : *endUs;
+	}
+	fclose(in);
+	return 1;
+}
+/* EOF */
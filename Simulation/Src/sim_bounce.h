@@ -0,0 +1,58 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file sim_bounce.h
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief Definitions and prototypes for the switch waveform library
+ ******************************************************************************/
+// @formatter:off
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __SIM_BOUNCE_H
+#define __SIM_BOUNCE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Defines -------------------------------------------------------------------*/
+#define simbounceLINE_LEN			( 128 )
+
+/* Structures ----------------------------------------------------------------*/
+/**
+ * How one switch behaves. Times are in us. A burst is a run of open and
+ * closed pulses, each pulseMinUs to pulseMaxUs long, ending in the new state.
+ */
+typedef struct _SIM_BOUNCE_PROFILE_S_
+{
+	const char *name;
+	uint32_t pressUs;		/* Burst after the first close */
+	uint32_t ringDelayUs;	/* Clean gap after the first open */
+	uint32_t ringUs;		/* Burst after that gap, the spring ringing */
+	uint32_t pulseMinUs;
+	uint32_t pulseMaxUs;
+	uint32_t chatterPerSec;	/* Spurious opens while held */
+	uint32_t chatterUs;		/* Length of each */
+} sim_bounce_profile_t;
+
+/* Prototypes ----------------------------------------------------------------*/
+const sim_bounce_profile_t *simBounceFind(const char *name);
+const sim_bounce_profile_t *simBounceGetProfiles(uint32_t *count);
+void simBounceStrike(const sim_bounce_profile_t *profile, uint8_t row,
+		uint8_t col, uint64_t atUs, uint64_t holdUs);
+uint64_t simBounceStrokes(const sim_bounce_profile_t *profile, uint64_t atUs,
+		uint32_t count);
+_Bool simBounceReplay(const char *path, uint8_t row, uint8_t col, uint64_t atUs,
+		uint64_t *endUs);
+
+/* Exported variables --------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SIM_BOUNCE_H */
+/* EOF */
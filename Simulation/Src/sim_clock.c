@@ -0,0 +1,188 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file sim_clock.c
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief Virtual time: the cycle counter, the tick and HAL_GetTick()
+ ******************************************************************************/
+// @formatter:off
+
+/* Includes ------------------------------------------------------------------*/
+#include "sim_clock.h"
+#include "sim_gpio.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "main.h"
+
+/**
+ * There is one clock, counted in core cycles. It moves forward only when the
+ * firmware spins on the cycle counter, touches a GPIO, or has nothing to do:
+ * the idle hook skips straight to the next tick. Runs are therefore exactly
+ * repeatable, and a second of keyboard time takes as long on the host as the
+ * firmware's work in it, not a second.
+ *
+ * Each millisecond boundary is one simulated interrupt: the kernel tick, then
+ * every attached peripheral hook.
+ */
+
+/* Defines -------------------------------------------------------------------*/
+#define CYCLES_PER_TICK		( simclockCORE_HZ / configTICK_RATE_HZ )
+
+/* Global variables ----------------------------------------------------------*/
+uint32_t SystemCoreClock = simclockCORE_HZ;
+CoreDebug_Type simCoreDebug;
+
+/* Private variables ---------------------------------------------------------*/
+static uint64_t cycles;
+static uint64_t nextTick = CYCLES_PER_TICK;
+static volatile uint32_t ticks;		/* Delivered, like the HAL's uwTick */
+static DWT_Type dwt;
+static void (*hooks[simclockMAX_HOOKS])(uint32_t nowMs);
+static uint8_t hookCount;
+
+/* Static prototypes ---------------------------------------------------------*/
+static void simClockIsr(void);
+
+/* Code ----------------------------------------------------------------------*/
+/**
+ * @brief The millisecond interrupt
+ * @param none
+ * @retval none
+ */
+static void simClockIsr(void)
+{
+	ticks++;
+	if (xTaskIncrementTick() != pdFALSE)
+	{
+		portYIELD_FROM_ISR(pdTRUE);
+	}
+	for (int hh = 0; hh < hookCount; hh++)
+	{
+		hooks[hh](ticks);
+	}
+}
+
+/**
+ * @brief Delivers the ticks that are due, unless interrupts are masked
+ * @note The port calls this again as soon as the mask drops.
+ * @param none
+ * @retval none
+ */
+void simClockService(void)
+{
+	while (cycles >= nextTick && !xPortInterruptsMasked())
+	{
+		nextTick += CYCLES_PER_TICK;
+		vPortSimInterrupt(simClockIsr, simclockTICK_EXCEPTION);
+	}
+}
+
+/**
+ * @brief Moves virtual time forward
+ * @param n Core cycles
+ * @retval none
+ */
+void simClockAdvance(uint32_t n)
+{
+	cycles += n;
+	simClockService();
+}
+
+/**
+ * @brief Lines the tick up with the clock as the scheduler starts
+ * @param none
+ * @retval none
+ */
+void simClockStart(void)
+{
+	nextTick = cycles - (cycles % CYCLES_PER_TICK) + CYCLES_PER_TICK;
+}
+
+/**
+ * @brief Adds a peripheral to the millisecond interrupt
+ * @param hook Called in interrupt context with the new tick count
+ * @retval none
+ */
+void simClockAttach(void (*hook)(uint32_t nowMs))
+{
+	if (hookCount < simclockMAX_HOOKS)
+	{
+		hooks[hookCount++] = hook;
+	}
+}
+
+/**
+ * @brief The cycle counter, for portGET_RUN_TIME_COUNTER_VALUE()
+ * @param none
+ * @retval Low 32 bits of the core cycle count, as DWT->CYCCNT
+ */
+uint32_t simClockCycles(void)
+{
+	return (uint32_t)cycles;
+}
+
+/**
+ * @brief Virtual time since reset
+ * @param none
+ * @retval Microseconds
+ */
+uint64_t simClockNowUs(void)
+{
+	return cycles / (simclockCORE_HZ / 1000000UL);
+}
+
+/**
+ * @brief Backs the DWT macro, every access costs a turn of a wait loop
+ * @note The GPIO inputs are brought up to date too, so code that polls IDR
+ *       while spinning on the counter sees the lines move.
+ * @param none
+ * @retval The DWT registers
+ */
+DWT_Type *simClockDwt(void)
+{
+	simClockAdvance(simclockDWT_READ_CYCLES);
+	simGpioSync();
+	dwt.CYCCNT = (uint32_t)cycles;
+	return &dwt;
+}
+
+/**
+ * @brief HAL millisecond tick
+ * @param none
+ * @retval Ticks delivered since the scheduler started
+ */
+uint32_t HAL_GetTick(void)
+{
+	return ticks;
+}
+
+/**
+ * @brief Busy waits, as the HAL does
+ * @note Counts cycles rather than ticks, so it also ends with interrupts masked.
+ * @param Delay Milliseconds
+ * @retval none
+ */
+void HAL_Delay(uint32_t Delay)
+{
+	uint64_t end = cycles + (uint64_t)Delay * CYCLES_PER_TICK;
+
+	while (cycles < end)
+	{
+		simClockAdvance(simclockDWT_READ_CYCLES);
+	}
+}
+
+/**
+ * @brief Nothing is ready to run: skip to the next tick
+ * @param none
+ * @retval none
+ */
+void vApplicationIdleHook(void)
+{
+	if (cycles < nextTick)
+	{
+		simClockAdvance((uint32_t)(nextTick - cycles));
+	}
+}
+/* EOF */
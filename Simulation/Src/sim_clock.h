@@ -0,0 +1,50 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file sim_clock.h
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief Definitions and prototypes for the simulation's virtual clock
+ ******************************************************************************/
+// @formatter:off
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __SIM_CLOCK_H
+#define __SIM_CLOCK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Defines -------------------------------------------------------------------*/
+#define simclockCORE_HZ				( 64000000UL )	/* As SystemClock_Config() sets */
+#define simclockMAX_HOOKS			( 8 )
+
+/**
+ * Firmware code costs nothing in virtual time, except for these accesses.
+ * They are rough figures for the M4 at 64 MHz, enough for busy waits on the
+ * cycle counter to make progress at about the board's rate.
+ */
+#define simclockDWT_READ_CYCLES		( 4 )	/* One turn of a cycle counter loop */
+#define simclockGPIO_CYCLES			( 12 )	/* A HAL_GPIO_ReadPin()/WritePin() call */
+
+#define simclockTICK_EXCEPTION		( 15 )	/* SysTick */
+
+/* Prototypes ----------------------------------------------------------------*/
+uint32_t simClockCycles(void);
+uint64_t simClockNowUs(void);
+void simClockAdvance(uint32_t cycles);
+void simClockService(void);
+void simClockStart(void);
+void simClockAttach(void (*hook)(uint32_t nowMs));
+
+/* Exported variables --------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SIM_CLOCK_H */
+/* EOF */
@@ -0,0 +1,145 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file sim_flash.c
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief The two settings sectors and the HAL flash calls, in host memory
+ ******************************************************************************/
+// @formatter:off
+
+/* Includes ------------------------------------------------------------------*/
+#include "sim_flash.h"
+
+#include "stm32f4xx_hal.h"
+#include "../../Core/Src/Settings/settings.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * settings.c hands flash addresses to the HAL as 32 bit integers, so the
+ * sectors live in the executable's data, which the Makefile links below
+ * 4 GiB with -no-pie. Programming follows NOR rules: bits only ever go from
+ * 1 to 0, and a word that was already programmed is counted as an overwrite,
+ * which settings.c must never do. simFlashFailAfter() makes programming fail
+ * from some point on, as a brown-out or a reset in the middle of a write
+ * would look to the firmware.
+ */
+
+/* Defines -------------------------------------------------------------------*/
+#define SECTORS				( 2 )
+#define ERASED_WORD			( 0xFFFFFFFFUL )
+
+/* Global variables ----------------------------------------------------------*/
+/* The SETTINGS region of STM32F401RETX_FLASH.ld, erased */
+uint8_t _settings_start[SECTORS * settingsPAGE_SIZE] __attribute__((aligned(4))) = {
+		[0 ... SECTORS * settingsPAGE_SIZE - 1] = 0xFF
+};
+
+/* Private variables ---------------------------------------------------------*/
+static _Bool unlocked;
+static int32_t failAfter = simflashNEVER_FAIL;
+static sim_flash_stats_t stats;
+
+/* Code ----------------------------------------------------------------------*/
+/**
+ * @brief Allows programming and erasing
+ * @param none
+ * @retval HAL_OK
+ */
+HAL_StatusTypeDef HAL_FLASH_Unlock(void)
+{
+	unlocked = 1;
+	return HAL_OK;
+}
+
+/**
+ * @brief Forbids programming and erasing
+ * @param none
+ * @retval HAL_OK
+ */
+HAL_StatusTypeDef HAL_FLASH_Lock(void)
+{
+	unlocked = 0;
+	return HAL_OK;
+}
+
+/**
+ * @brief Programs one word
+ * @param TypeProgram Only FLASH_TYPEPROGRAM_WORD is supported
+ * @param Address Word aligned, inside the settings sectors
+ * @param Data Value, the low 32 bits are used
+ * @retval HAL_OK, or HAL_ERROR if locked, out of range or told to fail
+ */
+HAL_StatusTypeDef HAL_FLASH_Program(uint32_t TypeProgram, uint32_t Address, uint64_t Data)
+{
+	uint8_t *at = (uint8_t *)(uintptr_t)Address;
+	uint32_t word;
+
+	if (!unlocked || TypeProgram != FLASH_TYPEPROGRAM_WORD || (Address & 3U)
+			|| at < _settings_start || at + 4 > _settings_start + sizeof(_settings_start)
+			|| failAfter == 0)
+	{
+		stats.failures++;
+		return HAL_ERROR;
+	}
+	if (failAfter > 0)
+	{
+		failAfter--;
+	}
+	memcpy(&word, at, sizeof(word));
+	if (word != ERASED_WORD)
+	{
+		stats.overwrites++;
+	}
+	word &= (uint32_t)Data;
+	memcpy(at, &word, sizeof(word));
+	stats.programs++;
+	return HAL_OK;
+}
+
+/**
+ * @brief Erases settings sectors
+ * @param pEraseInit Sectors to erase, FLASH_SECTOR_1 is the first settings page
+ * @param SectorError Set to 0xFFFFFFFF on success, else the failing sector
+ * @retval HAL_OK, or HAL_ERROR if locked or not a settings sector
+ */
+HAL_StatusTypeDef HAL_FLASHEx_Erase(FLASH_EraseInitTypeDef *pEraseInit, uint32_t *SectorError)
+{
+	for (uint32_t ii = 0; ii < pEraseInit->NbSectors; ii++)
+	{
+		uint32_t sector = pEraseInit->Sector + ii;
+
+		if (!unlocked || sector < FLASH_SECTOR_1 || sector >= FLASH_SECTOR_1 + SECTORS)
+		{
+			*SectorError = sector;
+			return HAL_ERROR;
+		}
+		memset(&_settings_start[(sector - FLASH_SECTOR_1) * settingsPAGE_SIZE], 0xFF,
+				settingsPAGE_SIZE);
+		stats.erases++;
+	}
+	*SectorError = ERASED_WORD;
+	return HAL_OK;
+}
+
+/**
+ * @brief Makes every program after the next few fail
+ * @param words Programs that still succeed, simflashNEVER_FAIL to stop failing
+ * @retval none
+ */
+void simFlashFailAfter(int32_t words)
+{
+	failAfter = words;
+}
+
+/**
+ * @brief Copies the flash counters
+ * @param out Destination for the counters
+ * @retval none
+ */
+void simFlashGetStats(sim_flash_stats_t *out)
+{
+	*out = stats;
+}
+/* EOF */
@@ -0,0 +1,44 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file sim_flash.h
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief Definitions and prototypes for the simulated settings flash
+ ******************************************************************************/
+// @formatter:off
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __SIM_FLASH_H
+#define __SIM_FLASH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Defines -------------------------------------------------------------------*/
+#define simflashNEVER_FAIL			( -1 )
+
+/* Structures ----------------------------------------------------------------*/
+typedef struct _SIM_FLASH_STATS_S_
+{
+	uint32_t programs;		/* Words programmed */
+	uint32_t erases;		/* Sectors erased */
+	uint32_t failures;		/* Programs refused, injected or not */
+	uint32_t overwrites;	/* Programs of a word that was not erased */
+} sim_flash_stats_t;
+
+/* Prototypes ----------------------------------------------------------------*/
+void simFlashFailAfter(int32_t words);
+void simFlashGetStats(sim_flash_stats_t *stats);
+
+/* Exported variables --------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SIM_FLASH_H */
+/* EOF */
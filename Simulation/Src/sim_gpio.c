@@ -0,0 +1,241 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file sim_gpio.c
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief GPIO registers and the HAL GPIO calls, wired to the virtual matrix
+ ******************************************************************************/
+// @formatter:off
+
+/* Includes ------------------------------------------------------------------*/
+#include "sim_gpio.h"
+#include "sim_clock.h"
+#include "sim_matrix.h"
+
+#include "main.h"
+#include "../../Core/Src/Keyboard/keyboard.h"
+
+/**
+ * The ports are plain structs, so the firmware can poke BSRR and read IDR
+ * directly as settle.c does. simGpioSync() then plays the part of the
+ * hardware: it applies BSRR to ODR and works out every input from the rows
+ * being driven, the switches the virtual matrix has closed, and the pulls.
+ * It runs on every HAL GPIO call and every cycle counter read.
+ */
+
+/* Defines -------------------------------------------------------------------*/
+#define MODER_OUTPUT		( 1UL )
+#define PUPDR_DOWN			( 2UL )
+#define PORT_COUNT			( 3 )
+
+/* Global variables ----------------------------------------------------------*/
+GPIO_TypeDef simGpioA;
+GPIO_TypeDef simGpioB;
+GPIO_TypeDef simGpioC;
+
+/* Private variables ---------------------------------------------------------*/
+static GPIO_TypeDef * const ports[PORT_COUNT] = { GPIOA, GPIOB, GPIOC };
+
+/* The board's wiring, as main.h has it */
+static const gpio_struct_t rowPins[keyboardNUM_ROWS] = {
+		{ ROW_0_GPIO_Port, ROW_0_Pin }, { ROW_1_GPIO_Port, ROW_1_Pin },
+		{ ROW_2_GPIO_Port, ROW_2_Pin }, { ROW_3_GPIO_Port, ROW_3_Pin },
+		{ ROW_4_GPIO_Port, ROW_4_Pin }, { ROW_5_GPIO_Port, ROW_5_Pin },
+		{ ROW_6_GPIO_Port, ROW_6_Pin }, { ROW_7_GPIO_Port, ROW_7_Pin },
+};
+static const gpio_struct_t colPins[keyboardNUM_COLS] = {
+		{ COL_0_GPIO_Port, COL_0_Pin }, { COL_1_GPIO_Port, COL_1_Pin },
+		{ COL_2_GPIO_Port, COL_2_Pin }, { COL_3_GPIO_Port, COL_3_Pin },
+		{ COL_4_GPIO_Port, COL_4_Pin }, { COL_5_GPIO_Port, COL_5_Pin },
+		{ COL_6_GPIO_Port, COL_6_Pin }, { COL_7_GPIO_Port, COL_7_Pin },
+		{ COL_8_GPIO_Port, COL_8_Pin }, { COL_9_GPIO_Port, COL_9_Pin },
+		{ COL_10_GPIO_Port, COL_10_Pin }, { COL_11_GPIO_Port, COL_11_Pin },
+		{ COL_12_GPIO_Port, COL_12_Pin }, { COL_13_GPIO_Port, COL_13_Pin },
+		{ COL_14_GPIO_Port, COL_14_Pin }, { COL_15_GPIO_Port, COL_15_Pin },
+		{ COL_16_GPIO_Port, COL_16_Pin }, { COL_17_GPIO_Port, COL_17_Pin },
+		{ COL_18_GPIO_Port, COL_18_Pin }, { COL_19_GPIO_Port, COL_19_Pin },
+};
+static const gpio_struct_t ledPins[] = {
+		{ LD0_GPIO_Port, LD0_Pin }, { LD1_GPIO_Port, LD1_Pin },
+		{ LD2_GPIO_Port, LD2_Pin },
+};
+
+static uint32_t frames;
+
+/* Static prototypes ---------------------------------------------------------*/
+static uint32_t simGpioShift(uint16_t pin);
+
+/* Code ----------------------------------------------------------------------*/
+/**
+ * @brief Bit position of a pin's 2 bit field in MODER or PUPDR
+ * @param pin GPIO_PIN_x
+ * @retval Shift
+ */
+static uint32_t simGpioShift(uint16_t pin)
+{
+	return 2U * (uint32_t)__builtin_ctz(pin);
+}
+
+/**
+ * @brief Puts the pins in the state MX_GPIO_Init() leaves them in
+ * @note Rows and LEDs are push-pull outputs, rows idle high; columns are
+ *       inputs with pull-ups.
+ * @param none
+ * @retval none
+ */
+void simGpioInit(void)
+{
+	for (int pp = 0; pp < PORT_COUNT; pp++)
+	{
+		*ports[pp] = (GPIO_TypeDef) { 0 };
+	}
+	for (int rr = 0; rr < keyboardNUM_ROWS; rr++)
+	{
+		rowPins[rr].port->MODER |= MODER_OUTPUT << simGpioShift(rowPins[rr].pin);
+		rowPins[rr].port->ODR |= rowPins[rr].pin;
+	}
+	for (int ll = 0; ll < sizeof(ledPins) / sizeof(ledPins[0]); ll++)
+	{
+		ledPins[ll].port->MODER |= MODER_OUTPUT << simGpioShift(ledPins[ll].pin);
+	}
+	for (int cc = 0; cc < keyboardNUM_COLS; cc++)
+	{
+		colPins[cc].port->PUPDR |= 1UL << simGpioShift(colPins[cc].pin);
+	}
+	simGpioSync();
+}
+
+/**
+ * @brief Brings every port's IDR up to date with the outputs and the matrix
+ * @note Runs on every GPIO call and cycle counter read, so it returns early
+ *       unless a switch, an output or a pull has changed since last time.
+ * @param none
+ * @retval none
+ */
+void simGpioSync(void)
+{
+	static uint32_t seen[PORT_COUNT][3];
+	static uint32_t seenVersion = UINT32_MAX;
+	uint32_t version = simMatrixAdvance();
+	_Bool changed = (version != seenVersion);
+	uint8_t lowRows = 0;
+	uint32_t lowCols;
+
+	for (int pp = 0; pp < PORT_COUNT; pp++)
+	{
+		GPIO_TypeDef *port = ports[pp];
+		uint32_t bsrr = port->BSRR;
+
+		/* Reset wins over set, as on the part */
+		port->ODR = (port->ODR | (bsrr & 0xFFFF)) & ~(bsrr >> 16);
+		port->BSRR = 0;
+		if (seen[pp][0] != port->ODR || seen[pp][1] != port->MODER
+				|| seen[pp][2] != port->PUPDR)
+		{
+			seen[pp][0] = port->ODR;
+			seen[pp][1] = port->MODER;
+			seen[pp][2] = port->PUPDR;
+			changed = 1;
+		}
+	}
+	if (!changed)
+	{
+		return;
+	}
+	seenVersion = version;
+
+	for (int rr = 0; rr < keyboardNUM_ROWS; rr++)
+	{
+		if (!(rowPins[rr].port->ODR & rowPins[rr].pin))
+		{
+			lowRows |= 1U << rr;
+		}
+	}
+	lowCols = simMatrixColumns(lowRows);
+
+	for (int pp = 0; pp < PORT_COUNT; pp++)
+	{
+		GPIO_TypeDef *port = ports[pp];
+		uint32_t idr = 0;
+
+		for (int bit = 0; bit < 16; bit++)
+		{
+			uint32_t mode = (port->MODER >> (2 * bit)) & 3;
+			uint32_t pull = (port->PUPDR >> (2 * bit)) & 3;
+
+			if (mode == MODER_OUTPUT)
+			{
+				idr |= port->ODR & (1UL << bit);
+			}
+			else if (pull != PUPDR_DOWN)
+			{
+				/* Floating inputs read high too, close enough here */
+				idr |= 1UL << bit;
+			}
+		}
+		port->IDR = idr;
+	}
+	for (int cc = 0; cc < keyboardNUM_COLS; cc++)
+	{
+		if (lowCols & (1UL << cc))
+		{
+			colPins[cc].port->IDR &= ~(uint32_t)colPins[cc].pin;
+		}
+	}
+}
+
+/**
+ * @brief Frames the scanner has started
+ * @param none
+ * @retval Times row 0 was driven through the HAL
+ */
+uint32_t simGpioFrames(void)
+{
+	return frames;
+}
+
+/**
+ * @brief HAL pin read
+ * @param GPIOx Port
+ * @param GPIO_Pin Pin
+ * @retval Level on the pin
+ */
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+	simClockAdvance(simclockGPIO_CYCLES);
+	simGpioSync();
+	return (GPIOx->IDR & GPIO_Pin) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+/**
+ * @brief HAL pin write
+ * @param GPIOx Port
+ * @param GPIO_Pin Pin
+ * @param PinState Level to drive
+ * @retval none
+ */
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState)
+{
+	if (GPIOx == rowPins[0].port && GPIO_Pin == rowPins[0].pin
+			&& PinState == GPIO_PIN_RESET)
+	{
+		frames++;
+	}
+	GPIOx->BSRR = (PinState == GPIO_PIN_SET) ? GPIO_Pin : (uint32_t)GPIO_Pin << 16;
+	simClockAdvance(simclockGPIO_CYCLES);
+	simGpioSync();
+}
+
+/**
+ * @brief HAL pin toggle
+ * @param GPIOx Port
+ * @param GPIO_Pin Pin
+ * @retval none
+ */
+void HAL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+	GPIOx->ODR ^= GPIO_Pin;
+	simClockAdvance(simclockGPIO_CYCLES);
+	simGpioSync();
+}
+/* EOF */
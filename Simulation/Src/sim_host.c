@@ -0,0 +1,767 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file sim_host.c
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief Simulated USB host: enumerates the device and polls its IN endpoint
+ ******************************************************************************/
+// @formatter:off
+
+/* Includes ------------------------------------------------------------------*/
+#include "sim_host.h"
+#include "sim_clock.h"
+#include "sim_matrix.h"
+#include "sim_usbd_conf.h"
+
+#include "main.h"
+#include "usbd_core.h"
+#include "usbd_hid.h"
+#include "../../Core/Src/Keyboard/usb_hid_keys.h"
+#include "../../Core/Src/Keyboard/keyboard.h"
+#include "../../Core/Src/Keyboard/keymap.h"
+
+#include <stdarg.h>
+#include <string.h>
+
+/**
+ * The host runs once per 1 ms frame, from the tick interrupt, which stands in
+ * for the OTG interrupt the transfers would complete in on the board. Each
+ * frame starts with SOF. Until the device is ready the host does one step of
+ * enumeration per frame, the way a real host spaces its control transfers:
+ *
+ *   connect, debounce, bus reset, recovery
+ *   GET_DESCRIPTOR device (64), SET_ADDRESS, GET_DESCRIPTOR device
+ *   GET_DESCRIPTOR configuration, header then whole
+ *   GET_DESCRIPTOR string 0 and the product string
+ *   SET_CONFIGURATION, SET_IDLE 0, GET_DESCRIPTOR report
+ *   SET_REPORT output with the lock LEDs, SET_PROTOCOL report
+ *
+ * after which it sends the report endpoint one IN token every pollMs frames,
+ * at the endpoint descriptor's bInterval unless told otherwise. Packets move
+ * through sim_usbd_conf.c's endpoints and every completion goes back into the
+ * real usbd_core.c, so the descriptors, request handling and HID class under
+ * test are the ones that ship.
+ *
+ * Latency is measured from the first contact change of each scripted press or
+ * release to the first report showing it, for keys that map to a plain usage.
+ *
+ * Keyboard reports a script expects are checked in the order given: once an
+ * expectation's time has come, the next report that differs from the one
+ * before it must be the one expected. Repeats, from SET_IDLE or the poll
+ * probe, are ignored. After the first mismatch nothing more is checked.
+ */
+
+/* Defines -------------------------------------------------------------------*/
+#define TOKEN_NAK			( -1 )
+#define TOKEN_STALL			( -2 )
+
+#define EP0_OUT				( 0x00U )
+#define EP0_IN				( 0x80U )
+
+#define STRING_BUF_LEN		( 255 )
+#define REPORT_KEYS_AT		( 2 )	/* Report ID, modifiers, then the keys */
+#define LANGID_EN_US		( 0x0409 )
+
+/* Private types -------------------------------------------------------------*/
+typedef enum
+{
+	HOST_DETACHED = 0,
+	HOST_DEBOUNCE,
+	HOST_RESET,
+	HOST_RECOVERY,
+	HOST_GET_DEVICE_SHORT,
+	HOST_SET_ADDRESS,
+	HOST_GET_DEVICE,
+	HOST_GET_CONFIG_HEAD,
+	HOST_GET_CONFIG,
+	HOST_GET_LANGIDS,
+	HOST_GET_PRODUCT,
+	HOST_SET_CONFIGURATION,
+	HOST_SET_IDLE,
+	HOST_GET_REPORT_DESC,
+	HOST_SET_LEDS,
+	HOST_SET_PROTOCOL,
+	HOST_READY,
+	HOST_FAILED,
+} host_state_t;
+
+typedef struct _HOST_EDGE_S_
+{
+	uint64_t atUs;
+	uint16_t key;
+	uint8_t usage;
+	uint8_t modifier;		/* Modifier bit, 0 for an ordinary key */
+	_Bool pressed;
+} host_edge_t;
+
+/* Private variables ---------------------------------------------------------*/
+extern USBD_HandleTypeDef hUsbDeviceFS;
+
+static host_state_t state;
+static uint32_t waitUntil;		/* Frame the next step may run in */
+static uint32_t pollOverride;	/* Polling interval from the command line, or 0 */
+static uint32_t nextPoll;
+static FILE *hostLog;
+static sim_host_stats_t stats;
+
+/* What enumeration learnt */
+static uint16_t configLength;
+static uint16_t reportDescLength;
+static uint8_t productIndex;
+static uint8_t reportEp;
+static uint16_t reportMps;
+static uint8_t reportInterval;
+static uint8_t buf[USBD_MAX_STR_DESC_SIZ];
+
+static host_edge_t open[simhostMAX_OPEN_EDGES];
+static uint32_t openCount;
+static uint32_t edgesTaken;		/* Scripted edges already looked at */
+
+static sim_host_expect_t expects[simhostMAX_EXPECTS];
+static uint32_t expectNext;		/* First expectation not yet seen */
+static uint8_t lastReport[8];	/* Last keyboard report received */
+
+/* Static prototypes ---------------------------------------------------------*/
+static void simHostFrame(uint32_t nowMs);
+static void simHostLog(const char *format, ...);
+static int simHostIn(uint8_t epAddr, uint8_t *dst, uint16_t max);
+static int simHostOut(uint8_t epAddr, const uint8_t *src, uint16_t len);
+static int simHostControl(uint8_t bmRequest, uint8_t bRequest, uint16_t wValue,
+		uint16_t wIndex, uint16_t wLength, const char *what);
+static void simHostEnumerate(uint32_t nowMs);
+static void simHostParseConfig(uint16_t length);
+static void simHostPoll(uint32_t nowMs);
+static void simHostTakeEdges(void);
+static void simHostMatch(const uint8_t *report, uint16_t length);
+static void simHostDropEdge(uint32_t idx);
+static void simHostCheck(const uint8_t *report, uint16_t length);
+static _Bool simHostSame(const sim_host_expect_t *expect, const uint8_t *report);
+
+/* Code ----------------------------------------------------------------------*/
+/**
+ * @brief Writes a time stamped line to the log
+ * @param format printf format
+ * @retval none
+ */
+static void simHostLog(const char *format, ...)
+{
+	va_list args;
+
+	if (hostLog == NULL)
+	{
+		return;
+	}
+	fprintf(hostLog, "%10.3f ms  ", simClockNowUs() / 1000.0);
+	va_start(args, format);
+	vfprintf(hostLog, format, args);
+	va_end(args);
+	fprintf(hostLog, "\n");
+}
+
+/**
+ * @brief Sends an IN token and takes one packet
+ * @note EP0 completes every packet, as the OTG core does for it; other
+ *       endpoints complete once the whole transfer has gone.
+ * @param epAddr Endpoint address, bit 7 set
+ * @param dst Where the data goes, NULL to drop it
+ * @param max Most the host will take
+ * @retval Bytes received, TOKEN_NAK or TOKEN_STALL
+ */
+static int simHostIn(uint8_t epAddr, uint8_t *dst, uint16_t max)
+{
+	sim_usbd_ep_t *ep = simUsbdGetEp(epAddr);
+	uint16_t len;
+
+	if (ep == NULL || !ep->armed)
+	{
+		return (ep != NULL && ep->stalled) ? TOKEN_STALL : TOKEN_NAK;
+	}
+	len = MIN(MIN(ep->length, ep->mps), max);
+	if (dst != NULL && ep->buf != NULL)
+	{
+		memcpy(dst, ep->buf, len);
+	}
+	ep->buf = (ep->buf != NULL) ? ep->buf + len : NULL;
+	ep->length -= len;
+	if ((epAddr & 0x7FU) == 0 || ep->length == 0)
+	{
+		ep->armed = 0;
+		USBD_LL_DataInStage(&hUsbDeviceFS, epAddr & 0x7FU, ep->buf);
+	}
+	return len;
+}
+
+/**
+ * @brief Sends an OUT token with one packet
+ * @param epAddr Endpoint address
+ * @param src Data, NULL for a zero length packet
+ * @param len Data length, at most the endpoint's max packet size
+ * @retval Bytes the device took, TOKEN_NAK or TOKEN_STALL
+ */
+static int simHostOut(uint8_t epAddr, const uint8_t *src, uint16_t len)
+{
+	sim_usbd_ep_t *ep = simUsbdGetEp(epAddr);
+	uint16_t take;
+
+	if (ep == NULL || !ep->armed)
+	{
+		return (ep != NULL && ep->stalled) ? TOKEN_STALL : TOKEN_NAK;
+	}
+	take = MIN(len, ep->length);
+	if (src != NULL && ep->buf != NULL)
+	{
+		memcpy(ep->buf, src, take);
+	}
+	ep->buf = (ep->buf != NULL) ? ep->buf + take : NULL;
+	ep->length -= take;
+	ep->count = take;
+	ep->armed = 0;
+	USBD_LL_DataOutStage(&hUsbDeviceFS, epAddr, ep->buf);
+	return take;
+}
+
+/**
+ * @brief Runs a whole control transfer on EP0
+ * @note Data for an OUT request is taken from buf, data from an IN request
+ *       is put there.
+ * @param bmRequest Request type
+ * @param bRequest Request
+ * @param wValue Value
+ * @param wIndex Index
+ * @param wLength Data stage length
+ * @param what Name for the log
+ * @retval Data stage bytes moved, or TOKEN_NAK or TOKEN_STALL
+ */
+static int simHostControl(uint8_t bmRequest, uint8_t bRequest, uint16_t wValue,
+		uint16_t wIndex, uint16_t wLength, const char *what)
+{
+	uint8_t setup[8] = {
+			bmRequest, bRequest, LOBYTE(wValue), HIBYTE(wValue),
+			LOBYTE(wIndex), HIBYTE(wIndex), LOBYTE(wLength), HIBYTE(wLength)
+	};
+	sim_usbd_ep_t *in0 = simUsbdGetEp(EP0_IN);
+	sim_usbd_ep_t *out0 = simUsbdGetEp(EP0_OUT);
+	uint16_t mps = in0->mps ? in0->mps : USB_MAX_EP0_SIZE;
+	int moved = 0;
+	int status;
+
+	stats.controls++;
+	/* A SETUP always gets through, whatever EP0 was doing */
+	in0->armed = out0->armed = 0;
+	in0->stalled = out0->stalled = 0;
+	USBD_LL_SetupStage(&hUsbDeviceFS, setup);
+
+	if (bmRequest & 0x80U)
+	{
+		do
+		{
+			status = simHostIn(EP0_IN, &buf[moved], (uint16_t)(wLength - moved));
+			if (status < 0)
+			{
+				break;
+			}
+			moved += status;
+		} while (status == mps && moved < wLength);
+		if (status >= 0)
+		{
+			status = simHostOut(EP0_OUT, NULL, 0);
+		}
+	}
+	else
+	{
+		status = 0;
+		while (moved < wLength && status >= 0)
+		{
+			status = simHostOut(EP0_OUT, &buf[moved], MIN(mps, wLength - moved));
+			moved += (status > 0) ? status : 0;
+		}
+		if (status >= 0)
+		{
+			status = simHostIn(EP0_IN, NULL, 0);
+		}
+	}
+
+	if (status < 0)
+	{
+		stats.stalls++;
+		simHostLog("%-24s %02x %02x %04x %04x %04x  %s", what, bmRequest, bRequest,
+				wValue, wIndex, wLength, (status == TOKEN_STALL) ? "STALL" : "no answer");
+		return status;
+	}
+	simHostLog("%-24s %02x %02x %04x %04x %04x  %d bytes", what, bmRequest, bRequest,
+			wValue, wIndex, wLength, moved);
+	return moved;
+}
+
+/**
+ * @brief Picks the HID and report endpoint details out of a configuration
+ * @param length Bytes of configuration descriptor in buf
+ * @retval none
+ */
+static void simHostParseConfig(uint16_t length)
+{
+	for (uint16_t at = 0; at + 1 < length && buf[at] != 0; at += buf[at])
+	{
+		uint8_t *desc = &buf[at];
+
+		if (desc[1] == HID_DESCRIPTOR_TYPE && desc[0] >= USB_HID_DESC_SIZ)
+		{
+			reportDescLength = desc[7] | (desc[8] << 8);
+		}
+		else if (desc[1] == USB_DESC_TYPE_ENDPOINT && (desc[2] & 0x80U)
+				&& (desc[3] & 0x03U) == USBD_EP_TYPE_INTR && reportEp == 0)
+		{
+			reportEp = desc[2];
+			reportMps = desc[4] | (desc[5] << 8);
+			reportInterval = desc[6];
+		}
+	}
+}
+
+/**
+ * @brief Runs the next step of attach and enumeration
+ * @param nowMs Frame number
+ * @retval none
+ */
+static void simHostEnumerate(uint32_t nowMs)
+{
+	char product[STRING_BUF_LEN / 2];
+	int got = 0;
+
+	if ((int32_t)(nowMs - waitUntil) < 0)
+	{
+		return;
+	}
+	switch (state)
+	{
+	case HOST_DETACHED:
+		if (simUsbdConnected())
+		{
+			stats.attachMs = nowMs;
+			simHostLog("attach");
+			waitUntil = nowMs + simhostATTACH_DEBOUNCE_MS;
+			state = HOST_DEBOUNCE;
+		}
+		return;
+	case HOST_DEBOUNCE:
+		waitUntil = nowMs + simhostRESET_MS;
+		state = HOST_RESET;
+		return;
+	case HOST_RESET:
+		/* As HAL_PCD_ResetCallback() does when the reset ends */
+		simUsbdReset();
+		USBD_LL_SetSpeed(&hUsbDeviceFS, USBD_SPEED_FULL);
+		USBD_LL_Reset(&hUsbDeviceFS);
+		simHostLog("reset");
+		waitUntil = nowMs + simhostRESET_RECOVERY_MS;
+		state = HOST_RECOVERY;
+		return;
+	case HOST_RECOVERY:
+		state = HOST_GET_DEVICE_SHORT;
+		/* no break */
+	case HOST_GET_DEVICE_SHORT:
+		got = simHostControl(0x80, USB_REQ_GET_DESCRIPTOR, USB_DESC_TYPE_DEVICE << 8,
+				0, 64, "GET_DESCRIPTOR device");
+		break;
+	case HOST_SET_ADDRESS:
+		got = simHostControl(0x00, USB_REQ_SET_ADDRESS, simhostADDRESS, 0, 0,
+				"SET_ADDRESS");
+		waitUntil = nowMs + simhostSET_ADDRESS_MS;
+		break;
+	case HOST_GET_DEVICE:
+		got = simHostControl(0x80, USB_REQ_GET_DESCRIPTOR, USB_DESC_TYPE_DEVICE << 8,
+				0, USB_LEN_DEV_DESC, "GET_DESCRIPTOR device");
+		productIndex = (got >= USB_LEN_DEV_DESC) ? buf[15] : 0;
+		break;
+	case HOST_GET_CONFIG_HEAD:
+		got = simHostControl(0x80, USB_REQ_GET_DESCRIPTOR,
+				USB_DESC_TYPE_CONFIGURATION << 8, 0, USB_LEN_CFG_DESC,
+				"GET_DESCRIPTOR config");
+		configLength = (got >= USB_LEN_CFG_DESC) ? (buf[2] | (buf[3] << 8)) : 0;
+		got = (configLength > sizeof(buf)) ? TOKEN_STALL : got;
+		break;
+	case HOST_GET_CONFIG:
+		got = simHostControl(0x80, USB_REQ_GET_DESCRIPTOR,
+				USB_DESC_TYPE_CONFIGURATION << 8, 0, configLength,
+				"GET_DESCRIPTOR config");
+		if (got >= 0)
+		{
+			simHostParseConfig((uint16_t)got);
+			got = (reportEp != 0) ? got : TOKEN_STALL;
+		}
+		break;
+	case HOST_GET_LANGIDS:
+		got = simHostControl(0x80, USB_REQ_GET_DESCRIPTOR, USB_DESC_TYPE_STRING << 8,
+				0, STRING_BUF_LEN, "GET_DESCRIPTOR string");
+		break;
+	case HOST_GET_PRODUCT:
+		if (productIndex == 0)
+		{
+			break;
+		}
+		got = simHostControl(0x80, USB_REQ_GET_DESCRIPTOR,
+				(USB_DESC_TYPE_STRING << 8) | productIndex, LANGID_EN_US,
+				STRING_BUF_LEN, "GET_DESCRIPTOR string");
+		if (got >= 2)
+		{
+			int len = 0;
+
+			/* UTF-16LE, keep the ASCII */
+			for (int ii = 2; ii + 1 < got && len < (int)sizeof(product) - 1; ii += 2)
+			{
+				product[len++] = buf[ii + 1] ? '?' : (char)buf[ii];
+			}
+			product[len] = '\0';
+			simHostLog("product \"%s\"", product);
+		}
+		break;
+	case HOST_SET_CONFIGURATION:
+		got = simHostControl(0x00, USB_REQ_SET_CONFIGURATION, 1, 0, 0,
+				"SET_CONFIGURATION");
+		stats.configuredMs = nowMs;
+		break;
+	case HOST_SET_IDLE:
+		got = simHostControl(0x21, HID_REQ_SET_IDLE, 0, 0, 0, "SET_IDLE");
+		break;
+	case HOST_GET_REPORT_DESC:
+		got = simHostControl(0x81, USB_REQ_GET_DESCRIPTOR, HID_REPORT_DESC << 8, 0,
+				reportDescLength, "GET_DESCRIPTOR report");
+		break;
+	case HOST_SET_LEDS:
+		buf[0] = simhostKEYBOARD_REPORT_ID;
+		buf[1] = simhostLOCK_LEDS;
+		got = simHostControl(0x21, HID_REQ_SET_REPORT,
+				(HID_REPORT_TYPE_OUTPUT << 8) | simhostKEYBOARD_REPORT_ID, 0, 2,
+				"SET_REPORT output");
+		break;
+	case HOST_SET_PROTOCOL:
+		got = simHostControl(0x21, HID_REQ_SET_PROTOCOL, 1, 0, 0, "SET_PROTOCOL");
+		stats.readyMs = nowMs;
+		stats.pollMs = pollOverride ? pollOverride : (reportInterval ? reportInterval : 1);
+		nextPoll = nowMs + 1;
+		break;
+	default:
+		return;
+	}
+	if (got < 0)
+	{
+		simHostLog("enumeration failed");
+		state = HOST_FAILED;
+		return;
+	}
+	state++;
+}
+
+/**
+ * @brief Sends the report endpoint an IN token if one is due
+ * @param nowMs Frame number
+ * @retval none
+ */
+static void simHostPoll(uint32_t nowMs)
+{
+	uint8_t report[64];
+	int got;
+
+	stats.frames++;
+	if ((int32_t)(nowMs - nextPoll) < 0)
+	{
+		return;
+	}
+	nextPoll = nowMs + stats.pollMs;
+	stats.polls++;
+	got = simHostIn(reportEp, report, MIN(reportMps, sizeof(report)));
+	if (got < 0)
+	{
+		stats.naks++;
+		return;
+	}
+	stats.reports++;
+	if (hostLog != NULL)
+	{
+		fprintf(hostLog, "%10.3f ms  report", simClockNowUs() / 1000.0);
+		for (int ii = 0; ii < got; ii++)
+		{
+			fprintf(hostLog, " %02x", report[ii]);
+		}
+		fprintf(hostLog, "\n");
+	}
+	simHostMatch(report, (uint16_t)got);
+	simHostCheck(report, (uint16_t)got);
+}
+
+/**
+ * @brief Collects the presses and releases the matrix has played
+ * @param none
+ * @retval none
+ */
+static void simHostTakeEdges(void)
+{
+	const sim_matrix_edge_t *edges;
+	uint32_t count = simMatrixGetEdges(&edges);
+	uint64_t nowUs = simClockNowUs();
+
+	for (; edgesTaken < count && edges[edgesTaken].atUs <= nowUs; edgesTaken++)
+	{
+		const sim_matrix_edge_t *edge = &edges[edgesTaken];
+		uint16_t key = GET_IDX(edge->col, edge->row, keyboardNUM_COLS);
+		uint16_t action = keymapLookup(key);
+
+		if (keymapKIND(action) != keymapKIND_KEY || action <= keymapNO
+				|| action > 0xFF || openCount == simhostMAX_OPEN_EDGES)
+		{
+			stats.unmapped++;
+			continue;
+		}
+		open[openCount++] = (host_edge_t) {
+			.atUs = edge->atUs,
+					.key = key,
+					.usage = (uint8_t)action,
+					.modifier = (action >= KEY_LEFTCTRL && action <= KEY_RIGHTMETA)
+							? (uint8_t)(1U << (action - KEY_LEFTCTRL)) : 0,
+					.pressed = edge->pressed
+		};
+	}
+}
+
+/**
+ * @brief Forgets an open edge
+ * @param idx Index in open[]
+ * @retval none
+ */
+static void simHostDropEdge(uint32_t idx)
+{
+	memmove(&open[idx], &open[idx + 1], (openCount - idx - 1) * sizeof(open[0]));
+	openCount--;
+}
+
+/**
+ * @brief Closes the open edges a report shows
+ * @note A key's edges are matched in order. A press that is not in the report
+ *       while its release has already happened was filtered out as bounce.
+ * @param report Report as received, ID first
+ * @param length Report length
+ * @retval none
+ */
+static void simHostMatch(const uint8_t *report, uint16_t length)
+{
+	uint64_t nowUs = simClockNowUs();
+	uint32_t ii = 0;
+
+	while (ii < openCount)
+	{
+		host_edge_t *edge = &open[ii];
+		_Bool shown = 0;
+		_Bool earlier = 0;
+
+		for (uint32_t jj = 0; jj < ii; jj++)
+		{
+			earlier |= (open[jj].key == edge->key);
+		}
+		if (earlier)
+		{
+			ii++;
+			continue;
+		}
+		if (edge->modifier)
+		{
+			shown = (length > 1) && (report[1] & edge->modifier);
+		}
+		for (int kk = REPORT_KEYS_AT; kk < length && !edge->modifier; kk++)
+		{
+			shown |= (report[kk] == edge->usage);
+		}
+		if (shown == edge->pressed)
+		{
+			uint32_t latency = (uint32_t)(nowUs - edge->atUs);
+
+			stats.latencies++;
+			stats.latencySumUs += latency;
+			stats.latencyMinUs = MIN(stats.latencyMinUs, latency);
+			stats.latencyMaxUs = (latency > stats.latencyMaxUs) ? latency : stats.latencyMaxUs;
+			simHostDropEdge(ii);
+			continue;
+		}
+		if (edge->pressed)
+		{
+			uint32_t jj;
+
+			for (jj = ii + 1; jj < openCount; jj++)
+			{
+				if (open[jj].key == edge->key)
+				{
+					shown = !open[jj].pressed;
+					break;
+				}
+			}
+			if (shown)
+			{
+				stats.filtered += 2;
+				simHostDropEdge(jj);
+				simHostDropEdge(ii);
+				continue;
+			}
+		}
+		ii++;
+	}
+}
+
+/**
+ * @brief Holds a keyboard report against the next expectation
+ * @param report Report as received, ID first
+ * @param length Report length
+ * @retval none
+ */
+static void simHostCheck(const uint8_t *report, uint16_t length)
+{
+	const sim_host_expect_t *expect = &expects[expectNext];
+	_Bool repeat;
+
+	if (length != sizeof(lastReport) || report[0] != simhostKEYBOARD_REPORT_ID)
+	{
+		return;
+	}
+	repeat = !memcmp(report, lastReport, sizeof(lastReport));
+	memcpy(lastReport, report, sizeof(lastReport));
+	if (repeat || expectNext == stats.expects
+			|| simClockNowUs() < expect->fromMs * 1000ULL)
+	{
+		return;
+	}
+	if (simHostSame(expect, report))
+	{
+		expectNext++;
+		stats.expectsMet++;
+		return;
+	}
+	fprintf(stderr, "sim: line %d: expected %02x", expect->line, expect->modifiers);
+	for (int ii = 0; ii < expect->count; ii++)
+	{
+		fprintf(stderr, " %02x", expect->keys[ii]);
+	}
+	fprintf(stderr, " after %u ms, got %02x", expect->fromMs, report[1]);
+	for (int ii = REPORT_KEYS_AT; ii < length; ii++)
+	{
+		if (report[ii])
+		{
+			fprintf(stderr, " %02x", report[ii]);
+		}
+	}
+	fprintf(stderr, " at %.3f ms\n", simClockNowUs() / 1000.0);
+	expectNext = stats.expects;
+}
+
+/**
+ * @brief Compares a keyboard report with an expectation
+ * @param expect Expected modifiers and keys
+ * @param report Report as received, ID first
+ * @retval 1 if the modifiers match and the same keys are down, in any order
+ */
+static _Bool simHostSame(const sim_host_expect_t *expect, const uint8_t *report)
+{
+	uint8_t down = 0;
+
+	if (report[1] != expect->modifiers)
+	{
+		return 0;
+	}
+	for (int ii = REPORT_KEYS_AT; ii < sizeof(lastReport); ii++)
+	{
+		_Bool listed = 0;
+
+		if (report[ii] == 0)
+		{
+			continue;
+		}
+		down++;
+		for (int kk = 0; kk < expect->count; kk++)
+		{
+			listed |= (expect->keys[kk] == report[ii]);
+		}
+		if (!listed)
+		{
+			return 0;
+		}
+	}
+	return down == expect->count;
+}
+
+/**
+ * @brief Host side of one frame
+ * @param nowMs Tick count, used as the frame number
+ * @retval none
+ */
+static void simHostFrame(uint32_t nowMs)
+{
+	simHostTakeEdges();
+	if (state == HOST_DETACHED || state == HOST_FAILED)
+	{
+		simHostEnumerate(nowMs);
+		return;
+	}
+	if (!simUsbdConnected())
+	{
+		simHostLog("detach");
+		state = HOST_DETACHED;
+		return;
+	}
+	if (state > HOST_RESET)
+	{
+		USBD_LL_SOF(&hUsbDeviceFS);
+	}
+	if (state != HOST_READY)
+	{
+		simHostEnumerate(nowMs);
+		return;
+	}
+	simHostPoll(nowMs);
+}
+
+/**
+ * @brief Sets up the host and attaches it to the frame clock
+ * @param pollMs IN polling interval, 0 for the endpoint's bInterval
+ * @param log Where transfers and received reports are written, or NULL
+ * @retval none
+ */
+void simHostInit(uint32_t pollMs, FILE *log)
+{
+	state = HOST_DETACHED;
+	waitUntil = 0;
+	pollOverride = pollMs;
+	hostLog = log;
+	stats = (sim_host_stats_t) {
+		.latencyMinUs = UINT32_MAX
+	};
+	openCount = 0;
+	edgesTaken = 0;
+	expectNext = 0;
+	memset(lastReport, 0, sizeof(lastReport));
+	simClockAttach(simHostFrame);
+}
+
+/**
+ * @brief Adds a keyboard report the host must see, after the ones added so far
+ * @param expect Report and the time it is looked for from, copied
+ * @retval 1 if added, 0 if there are too many
+ */
+_Bool simHostExpect(const sim_host_expect_t *expect)
+{
+	if (stats.expects == simhostMAX_EXPECTS)
+	{
+		return 0;
+	}
+	expects[stats.expects++] = *expect;
+	return 1;
+}
+
+/**
+ * @brief Copies the host's counters
+ * @param out Destination
+ * @retval none
+ */
+void simHostGetStats(sim_host_stats_t *out)
+{
+	simHostTakeEdges();
+	*out = stats;
+	out->unreported = openCount;
+}
+/* EOF */
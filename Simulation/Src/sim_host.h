@@ -0,0 +1,81 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file sim_host.h
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief Definitions and prototypes for the simulated USB host
+ ******************************************************************************/
+// @formatter:off
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __SIM_HOST_H
+#define __SIM_HOST_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdio.h>
+
+/* Defines -------------------------------------------------------------------*/
+/* Bus timings from the USB 2.0 spec, 7.1.7.3 and 9.2.6.3 */
+#define simhostATTACH_DEBOUNCE_MS	( 100 )	/* Connect to first reset */
+#define simhostRESET_MS				( 10 )	/* Length of the bus reset */
+#define simhostRESET_RECOVERY_MS	( 10 )	/* Reset to first request */
+#define simhostSET_ADDRESS_MS		( 2 )	/* SET_ADDRESS to next request */
+
+#define simhostADDRESS				( 1 )
+#define simhostMAX_OPEN_EDGES		( 64 )	/* Key edges waiting for a report */
+#define simhostKEYBOARD_REPORT_ID	( 1 )
+#define simhostLOCK_LEDS			( 0x01 )	/* Num Lock on, as most hosts boot */
+#define simhostMAX_EXPECTS			( 64 )	/* Expected reports per script */
+
+/* Structures ----------------------------------------------------------------*/
+typedef struct _SIM_HOST_STATS_S_
+{
+	uint32_t attachMs;		/* Device connected */
+	uint32_t configuredMs;	/* SET_CONFIGURATION completed */
+	uint32_t readyMs;		/* Class requests done, IN polling started */
+	uint32_t controls;		/* Control transfers */
+	uint32_t stalls;		/* Control transfers the device stalled */
+	uint32_t pollMs;		/* IN polling interval used */
+	uint32_t frames;		/* Frames since ready */
+	uint32_t polls;			/* IN tokens on the report endpoint */
+	uint32_t naks;			/* IN tokens with no report waiting */
+	uint32_t reports;		/* Input reports received */
+	uint32_t latencies;		/* Key edges matched to a report */
+	uint64_t latencySumUs;
+	uint32_t latencyMinUs;
+	uint32_t latencyMaxUs;
+	uint32_t filtered;		/* Edges of taps too short to ever show up */
+	uint32_t unmapped;		/* Edges of keys without a plain usage */
+	uint32_t unreported;	/* Edges still unmatched at the end */
+	uint32_t expects;		/* Keyboard reports the script expects */
+	uint32_t expectsMet;	/* Of those, seen in order */
+} sim_host_stats_t;
+
+/* A keyboard report the script expects, see simHostExpect() */
+typedef struct _SIM_HOST_EXPECT_S_
+{
+	uint32_t fromMs;		/* Checked against reports received from here on */
+	uint8_t modifiers;
+	uint8_t keys[6];		/* Any order */
+	uint8_t count;			/* Keys in keys[] */
+	int line;				/* Script line, for the failure message */
+} sim_host_expect_t;
+
+/* Prototypes ----------------------------------------------------------------*/
+void simHostInit(uint32_t pollMs, FILE *log);
+_Bool simHostExpect(const sim_host_expect_t *expect);
+void simHostGetStats(sim_host_stats_t *stats);
+
+/* Exported variables --------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SIM_HOST_H */
+/* EOF */
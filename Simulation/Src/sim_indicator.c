@@ -0,0 +1,116 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file sim_indicator.c
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief Indicator LEDs kept as state, in place of the timers that run them
+ ******************************************************************************/
+// @formatter:off
+
+/* Includes ------------------------------------------------------------------*/
+#include "../../Core/Src/Indicator/indicator.h"
+
+/**
+ * indicator.c programs TIM1, TIM2 and DMA2, none of which the host has. This
+ * keeps the same API and the same choice of pattern, fallbacks included, so
+ * a run can show what the LEDs would be doing at its end.
+ */
+
+/* Private variables ---------------------------------------------------------*/
+static indicator_mode_t modes[indicatorLEDS];
+static _Bool hostConfigured;
+static uint8_t hostLocks;
+
+/* Static prototypes ---------------------------------------------------------*/
+static void simIndicatorShow(void);
+
+/* Code ----------------------------------------------------------------------*/
+/**
+ * @brief Shows the host's state, as indicator.c does
+ * @param none
+ * @retval none
+ */
+static void simIndicatorShow(void)
+{
+	if (!hostConfigured)
+	{
+		indicatorSet(indicatorLD0, indicatorBREATHE, 0);
+		indicatorSet(indicatorLD1, indicatorOFF, 0);
+		indicatorSet(indicatorLD2, indicatorOFF, 0);
+		return;
+	}
+	indicatorSet(indicatorLD0, (hostLocks & indicatorLOCK_NUM) ? indicatorON
+			: indicatorOFF, 0);
+	indicatorSet(indicatorLD1, (hostLocks & indicatorLOCK_CAPS) ? indicatorON
+			: indicatorOFF, 0);
+	indicatorSet(indicatorLD2, (hostLocks & indicatorLOCK_SCROLL) ? indicatorON
+			: indicatorOFF, 0);
+}
+
+/**
+ * @brief Records a pattern, after the board's fallbacks
+ * @param led LED
+ * @param mode Pattern
+ * @param periodMs UNUSED
+ * @retval none
+ */
+void indicatorSet(indicator_led_t led, indicator_mode_t mode, uint16_t periodMs)
+{
+	(void)periodMs;
+	if (led == indicatorLD1)
+	{
+		mode = (mode == indicatorOFF) ? indicatorOFF : indicatorON;
+	}
+	else if (led == indicatorLD2 && mode == indicatorBREATHE)
+	{
+		mode = indicatorBLINK;
+	}
+	modes[led] = mode;
+}
+
+/**
+ * @brief Tells which pattern an LED is running
+ * @param led LED
+ * @retval Pattern
+ */
+indicator_mode_t indicatorGet(indicator_led_t led)
+{
+	return modes[led];
+}
+
+/**
+ * @brief Takes the lock state from the host's output report
+ * @param locks indicatorLOCK_x bits
+ * @retval none
+ */
+void indicatorSetLocks(uint8_t locks)
+{
+	hostLocks = locks;
+	simIndicatorShow();
+}
+
+/**
+ * @brief Switches between the waiting pattern and the lock LEDs
+ * @param configured 1 once the host has set a configuration
+ * @retval none
+ */
+void indicatorSetHost(_Bool configured)
+{
+	hostConfigured = configured;
+	if (!configured)
+	{
+		hostLocks = 0;
+	}
+	simIndicatorShow();
+}
+
+/**
+ * @brief Starts out waiting for the host
+ * @param none
+ * @retval none
+ */
+void indicatorInit(void)
+{
+	indicatorSetHost(0);
+}
+/* EOF */
@@ -0,0 +1,337 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file sim_main.c
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief Runs the keyboard firmware against a scripted matrix on the host
+ ******************************************************************************/
+// @formatter:off
+
+/* Includes ------------------------------------------------------------------*/
+#include "sim_clock.h"
+#include "sim_gpio.h"
+#include "sim_matrix.h"
+#include "sim_script.h"
+#include "sim_host.h"
+#include "sim_bench.h"
+#include "sim_flash.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "main.h"
+#include "usb_device.h"
+#include "usbd_hid.h"
+#include "../../Core/Src/Keyboard/keyboard.h"
+#include "../../Core/Src/Keyboard/health.h"
+#include "../../Core/Src/Keyboard/governor.h"
+#include "../../Core/Src/UsbInterface/usb_if.h"
+#include "../../Core/Src/Utilities/utils.h"
+#include "../../Core/Src/Telemetry/telemetry.h"
+#include "../../Core/Src/Trace/trace.h"
+#include "../../Core/Src/Settings/settings.h"
+#include "../../Core/Src/Bench/bench.h"
+#include "../../Core/Src/Boot/boot.h"
+#include "../../Core/Src/Power/power.h"
+#include "../../Core/Src/Indicator/indicator.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * Usage: modelm_sim [-q] [-p poll_ms] [-s seed] script
+ *
+ * Brings the firmware up the way MX_FREERTOS_Init() does, less the power
+ * manager, runs the script to its end and prints what the host saw and how
+ * long it took. See sim_script.c for the script format. -p makes the host
+ * poll the report endpoint every poll_ms frames instead of at its bInterval.
+ * -q drops the firmware's own printf output, which otherwise goes to stdout
+ * with the host's log. The exit status is 1 if the host did not see every
+ * report the script expects.
+ */
+
+/* Global variables ----------------------------------------------------------*/
+volatile _Bool os_running;
+volatile _Bool standalone;
+
+/* Private variables ---------------------------------------------------------*/
+static StaticTask_t idleTcb;
+static StackType_t idleStack[configMINIMAL_STACK_SIZE];
+static uint32_t endMs;
+static _Bool quiet;
+
+/* Static prototypes ---------------------------------------------------------*/
+static void simMainFrame(uint32_t nowMs);
+static double simMainSeconds(void);
+static void simMainUsage(const char *name);
+static int simMainBootMs(boot_mark_t mark);
+static const char *simMainIndicator(indicator_led_t led);
+
+/* Code ----------------------------------------------------------------------*/
+/**
+ * @brief Ends the run once the script's time is up
+ * @param nowMs Tick count
+ * @retval none
+ */
+static void simMainFrame(uint32_t nowMs)
+{
+	if (nowMs >= endMs)
+	{
+		vTaskEndScheduler();
+	}
+}
+
+/**
+ * @brief Host monotonic time
+ * @param none
+ * @retval Seconds
+ */
+static double simMainSeconds(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Prints the command line
+ * @param name argv[0]
+ * @retval none
+ */
+static void simMainUsage(const char *name)
+{
+	fprintf(stderr, "usage: %s [-q] [-p poll_ms] [-s seed] script|-\n", name);
+}
+
+/**
+ * @brief When a boot milestone was reached
+ * @param mark Milestone
+ * @retval HAL tick, -1 if it never was
+ */
+static int simMainBootMs(boot_mark_t mark)
+{
+	return bootReached(mark) ? (int)bootTimes.atMs[mark] : -1;
+}
+
+/**
+ * @brief Names the pattern an LED ended the run with
+ * @param led LED
+ * @retval Pattern name
+ */
+static const char *simMainIndicator(indicator_led_t led)
+{
+	static const char *const names[] = { "off", "on", "blink", "blip", "breathe" };
+
+	return names[indicatorGet(led)];
+}
+
+/**
+ * @brief Firmware printf, see the Makefile's --wrap
+ * @param format Format string
+ * @retval Characters written
+ */
+int __wrap_printf(const char *format, ...)
+{
+	va_list args;
+	int written;
+
+	if (quiet)
+	{
+		return 0;
+	}
+	va_start(args, format);
+	written = vprintf(format, args);
+	va_end(args);
+	return written;
+}
+
+/**
+ * @brief A kernel or firmware assertion failed
+ * @param file Source file
+ * @param line Source line
+ * @retval none
+ */
+void simAssert(const char *file, int line)
+{
+	fprintf(stderr, "sim: assertion failed at %s:%d\n", file, line);
+	abort();
+}
+
+/**
+ * @brief Firmware fatal error
+ * @param none
+ * @retval none
+ */
+void Error_Handler(void)
+{
+	fprintf(stderr, "sim: Error_Handler() called\n");
+	abort();
+}
+
+/**
+ * @brief Sleep residency for the telemetry snapshot
+ * @note The simulation has no power manager and never sleeps.
+ * @param stats Destination for the counters
+ * @retval none
+ */
+void powerGetStats(power_stats_t *stats)
+{
+	*stats = (power_stats_t) { 0 };
+}
+
+/**
+ * @brief Idle task memory, as freertos.c provides on the board
+ * @param ppxIdleTaskTCBBuffer Set to the TCB
+ * @param ppxIdleTaskStackBuffer Set to the stack
+ * @param pulIdleTaskStackSize Set to the stack size
+ * @retval none
+ */
+void vApplicationGetIdleTaskMemory(StaticTask_t **ppxIdleTaskTCBBuffer,
+		StackType_t **ppxIdleTaskStackBuffer, uint32_t *pulIdleTaskStackSize)
+{
+	*ppxIdleTaskTCBBuffer = &idleTcb;
+	*ppxIdleTaskStackBuffer = &idleStack[0];
+	*pulIdleTaskStackSize = configMINIMAL_STACK_SIZE;
+}
+
+/**
+ * @brief Entry point
+ * @param argc Argument count
+ * @param argv Arguments
+ * @retval Exit status
+ */
+int main(int argc, char **argv)
+{
+	sim_script_t script;
+	sim_matrix_stats_t matrix;
+	sim_host_stats_t usb;
+	uint32_t pollMs = 0;
+	uint32_t seed = simmatrixDEFAULT_SEED;
+	double started;
+	double hostSeconds;
+	uint32_t chatter = 0;
+	uint32_t chatterKeys = 0;
+	governor_stats_t governor;
+	settings_stats_t settings;
+	sim_flash_stats_t flash;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "qp:s:")) != -1)
+	{
+		switch (opt)
+		{
+		case 'q':
+			quiet = 1;
+			break;
+		case 'p':
+			pollMs = (uint32_t)strtoul(optarg, NULL, 0);
+			break;
+		case 's':
+			seed = (uint32_t)strtoul(optarg, NULL, 0);
+			break;
+		default:
+			simMainUsage(argv[0]);
+			return 2;
+		}
+	}
+	if (optind != argc - 1)
+	{
+		simMainUsage(argv[0]);
+		return 2;
+	}
+
+	simMatrixInit(seed);
+	simGpioInit();
+	simHostInit(pollMs, stdout);
+	simBenchInit();
+	if (!simScriptLoad(argv[optind], &script))
+	{
+		return 1;
+	}
+	endMs = script.endMs;
+	simClockAttach(simMainFrame);
+
+	/* As MX_FREERTOS_Init() and StartDefaultTask() */
+	utilsInit();
+	indicatorInit();
+	telemetryInit();
+	traceInit();
+	settingsInit();
+	usbifInit();
+	keyboardInit();
+	benchInit();
+	MX_USB_DEVICE_Init();
+	bootMark(bootMARK_USB_STARTED);
+	os_running = 1;
+
+	started = simMainSeconds();
+	vTaskStartScheduler();
+	hostSeconds = simMainSeconds() - started;
+
+	fflush(stdout);
+	simMatrixGetStats(&matrix);
+	simHostGetStats(&usb);
+	fprintf(stderr, "sim: %u ms simulated in %.3f s of host time\n",
+			endMs, hostSeconds);
+	fprintf(stderr, "sim: %u scan frames, %.1f per second\n",
+			simGpioFrames(), simGpioFrames() * 1000.0 / endMs);
+	fprintf(stderr, "sim: %u presses, %u releases, %u contact changes scripted\n",
+			matrix.presses, matrix.releases, matrix.transitions);
+	fprintf(stderr, "sim: attached at %u ms, configured at %u ms, ready at %u ms,"
+			" %u control transfers, %u failed\n", usb.attachMs, usb.configuredMs,
+			usb.readyMs, usb.controls, usb.stalls);
+	fprintf(stderr, "sim: %u reports in %u polls every %u ms, %.1f%% NAKed,"
+			" %.3f reports per frame\n", usb.reports, usb.polls, usb.pollMs,
+			usb.polls ? 100.0 * usb.naks / usb.polls : 0.0,
+			usb.frames ? (double)usb.reports / usb.frames : 0.0);
+	if (usb.latencies)
+	{
+		fprintf(stderr, "sim: latency over %u edges: min %.3f ms, mean %.3f ms,"
+				" max %.3f ms\n", usb.latencies, usb.latencyMinUs / 1000.0,
+				usb.latencySumUs / 1000.0 / usb.latencies, usb.latencyMaxUs / 1000.0);
+	}
+	fprintf(stderr, "sim: %u edges filtered as bounce, %u unmapped, %u never reported\n",
+			usb.filtered, usb.unmapped, usb.unreported);
+	if (usb.expects)
+	{
+		fprintf(stderr, "sim: %u of %u expected reports seen\n", usb.expectsMet,
+				usb.expects);
+	}
+	for (uint16_t key = 0; key < keyboardNUM_KEYS; key++)
+	{
+		chatter += healthCounters.chatter[key];
+		chatterKeys += (healthCounters.chatter[key] != 0);
+	}
+	fprintf(stderr, "sim: %u changes rejected as chatter, on %u keys\n",
+			chatter, chatterKeys);
+	governorGetStats(&governor);
+	fprintf(stderr, "sim: scan rate changed %u times; ms / wakes by level:",
+			governor.transitions);
+	for (uint32_t ii = 0; ii < governorLEVELS; ii++)
+	{
+		fprintf(stderr, " %u/%u", governor.msAt[ii], governor.wakes[ii]);
+	}
+	fprintf(stderr, "\n");
+	fprintf(stderr, "sim: boot: usb %d, first frame %d, configured %d, first edge %d,"
+			" first report %d ms%s\n", simMainBootMs(bootMARK_USB_STARTED),
+			simMainBootMs(bootMARK_FIRST_FRAME), simMainBootMs(bootMARK_CONFIGURED),
+			simMainBootMs(bootMARK_FIRST_EDGE), simMainBootMs(bootMARK_FIRST_REPORT),
+			bootTimes.overBudget ? ", OVER BUDGET" : "");
+	fprintf(stderr, "sim: LEDs: num %s, caps %s, scroll %s\n",
+			simMainIndicator(indicatorLD0), simMainIndicator(indicatorLD1),
+			simMainIndicator(indicatorLD2));
+	settingsGetStats(&settings);
+	simFlashGetStats(&flash);
+	fprintf(stderr, "sim: settings: profile %d, %u of %u bytes used, %u words"
+			" programmed, %u sectors erased, %u failed, %u overwritten\n",
+			settings.profile == 0xFF ? -1 : settings.profile, settings.used,
+			settingsPAGE_SIZE, flash.programs, flash.erases, flash.failures,
+			flash.overwrites);
+	simBenchReport(stderr, simGpioFrames());
+	return (usb.expectsMet == usb.expects) ? 0 : 1;
+}
+/* EOF */
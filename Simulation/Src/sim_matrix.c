@@ -0,0 +1,337 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file sim_matrix.c
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief Virtual key matrix: switch contacts as a function of virtual time
+ ******************************************************************************/
+// @formatter:off
+
+/* Includes ------------------------------------------------------------------*/
+#include "sim_matrix.h"
+#include "sim_clock.h"
+
+#include "../../Core/Src/Keyboard/keyboard.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * Every switch contact is a list of timed changes, built up front by a script
+ * and played back as virtual time passes. Presses and releases can carry
+ * bounce: a burst of extra changes spread over a given time, with a little
+ * seeded jitter so runs stay repeatable.
+ *
+ * The matrix has no diodes. A column reads low when closed switches connect
+ * it to a driven row through any number of other rows and columns, which is
+ * exactly how the real board ghosts.
+ */
+
+/* Defines -------------------------------------------------------------------*/
+#define INITIAL_CAPACITY	( 256 )
+
+/* Private types -------------------------------------------------------------*/
+typedef struct _SIM_CONTACT_S_
+{
+	uint64_t atUs;
+	uint32_t order;			/* Keeps changes at the same time in script order */
+	uint8_t row;
+	uint8_t col;
+	uint8_t closed;
+} sim_contact_t;
+
+/* Private variables ---------------------------------------------------------*/
+static sim_contact_t *contacts;
+static uint32_t contactCount;
+static uint32_t contactCapacity;
+static uint32_t cursor;			/* Next change to apply */
+static _Bool sorted;
+static uint32_t closed[keyboardNUM_ROWS];	/* Bit per column */
+static uint32_t rng;
+static sim_matrix_stats_t stats;
+static sim_matrix_edge_t *edges;	/* Intended presses and releases, in time order */
+static uint32_t edgeCount;
+static uint32_t edgeCapacity;
+
+/* Static prototypes ---------------------------------------------------------*/
+static int simMatrixCompare(const void *a, const void *b);
+static void simMatrixBounce(uint8_t row, uint8_t col, uint64_t atUs,
+		uint8_t bounces, uint32_t bounceUs, _Bool closedAfter);
+
+/* Code ----------------------------------------------------------------------*/
+/**
+ * @brief Small seeded PRNG (xorshift32) for bounce jitter and waveforms
+ * @param none
+ * @retval Next value
+ */
+uint32_t simMatrixRandom(void)
+{
+	rng ^= rng << 13;
+	rng ^= rng >> 17;
+	rng ^= rng << 5;
+	return rng;
+}
+
+/**
+ * @brief qsort order for contact changes
+ * @param a First change
+ * @param b Second change
+ * @retval <0, 0 or >0
+ */
+static int simMatrixCompare(const void *a, const void *b)
+{
+	const sim_contact_t *ca = a;
+	const sim_contact_t *cb = b;
+
+	if (ca->atUs != cb->atUs)
+	{
+		return (ca->atUs < cb->atUs) ? -1 : 1;
+	}
+	return (ca->order < cb->order) ? -1 : (ca->order > cb->order);
+}
+
+/**
+ * @brief Adds a contact change and a burst of bounce after it
+ * @param row Matrix row
+ * @param col Matrix column
+ * @param atUs First change
+ * @param bounces Extra open and close pairs after the first change
+ * @param bounceUs Time the bounce is spread over
+ * @param closedAfter Where the contact ends up
+ * @retval none
+ */
+static void simMatrixBounce(uint8_t row, uint8_t col, uint64_t atUs,
+		uint8_t bounces, uint32_t bounceUs, _Bool closedAfter)
+{
+	uint32_t changes = 2U * bounces;
+	uint32_t step = changes ? bounceUs / changes : 0;
+
+	simMatrixEdge(row, col, atUs, closedAfter);
+	simMatrixContact(row, col, atUs, closedAfter);
+	for (uint32_t ii = 1; ii <= changes; ii++)
+	{
+		uint32_t jitter = step ? simMatrixRandom() % step : 0;
+		uint64_t at = atUs + (uint64_t)step * (ii - 1) + jitter;
+
+		/* Odd changes undo the press or release, even ones redo it */
+		simMatrixContact(row, col, at, (ii & 1) ? !closedAfter : closedAfter);
+	}
+}
+
+/**
+ * @brief Forgets every scripted change and opens every switch
+ * @param seed Bounce jitter seed, never 0
+ * @retval none
+ */
+void simMatrixInit(uint32_t seed)
+{
+	free(contacts);
+	contacts = NULL;
+	free(edges);
+	edges = NULL;
+	edgeCount = 0;
+	edgeCapacity = 0;
+	contactCount = 0;
+	contactCapacity = 0;
+	cursor = 0;
+	sorted = 1;
+	rng = seed ? seed : simmatrixDEFAULT_SEED;
+	stats = (sim_matrix_stats_t) { 0 };
+	for (int rr = 0; rr < keyboardNUM_ROWS; rr++)
+	{
+		closed[rr] = 0;
+	}
+}
+
+/**
+ * @brief Schedules one contact change
+ * @param row Matrix row
+ * @param col Matrix column
+ * @param atUs Virtual time of the change
+ * @param isClosed 1 to close the switch, 0 to open it
+ * @retval none
+ */
+void simMatrixContact(uint8_t row, uint8_t col, uint64_t atUs, _Bool isClosed)
+{
+	if (row >= keyboardNUM_ROWS || col >= keyboardNUM_COLS)
+	{
+		fprintf(stderr, "sim: no key at r%uc%u\n", row, col);
+		exit(1);
+	}
+	if (contactCount == contactCapacity)
+	{
+		contactCapacity = contactCapacity ? contactCapacity * 2 : INITIAL_CAPACITY;
+		contacts = realloc(contacts, contactCapacity * sizeof(sim_contact_t));
+		if (contacts == NULL)
+		{
+			abort();
+		}
+	}
+	contacts[contactCount] = (sim_contact_t) {
+		.atUs = atUs,
+				.order = contactCount,
+				.row = row,
+				.col = col,
+				.closed = isClosed
+	};
+	contactCount++;
+	sorted = 0;
+	stats.transitions++;
+}
+
+/**
+ * @brief Records where a press or release was meant to happen
+ * @note This is the truth that latency and missed or false edges are judged
+ *       against; it moves no contact. Kept in time order, script order for
+ *       equal times.
+ * @param row Matrix row
+ * @param col Matrix column
+ * @param atUs First contact change of the press or release
+ * @param pressed 1 for a press
+ * @retval none
+ */
+void simMatrixEdge(uint8_t row, uint8_t col, uint64_t atUs, _Bool pressed)
+{
+	uint32_t at = edgeCount;
+
+	if (edgeCount == edgeCapacity)
+	{
+		edgeCapacity = edgeCapacity ? edgeCapacity * 2 : INITIAL_CAPACITY;
+		edges = realloc(edges, edgeCapacity * sizeof(sim_matrix_edge_t));
+		if (edges == NULL)
+		{
+			abort();
+		}
+	}
+	/* Scripts are mostly in order, so this rarely moves anything */
+	while (at > 0 && edges[at - 1].atUs > atUs)
+	{
+		edges[at] = edges[at - 1];
+		at--;
+	}
+	edges[at] = (sim_matrix_edge_t) {
+		.atUs = atUs,
+				.row = row,
+				.col = col,
+				.pressed = pressed
+	};
+	edgeCount++;
+	if (pressed)
+	{
+		stats.presses++;
+	}
+	else
+	{
+		stats.releases++;
+	}
+}
+
+/**
+ * @brief Schedules a key press
+ * @param row Matrix row
+ * @param col Matrix column
+ * @param atUs Time the contact first closes
+ * @param bounces Extra open and close pairs as it settles
+ * @param bounceUs Time the bounce lasts
+ * @retval none
+ */
+void simMatrixPress(uint8_t row, uint8_t col, uint64_t atUs, uint8_t bounces,
+		uint32_t bounceUs)
+{
+	simMatrixBounce(row, col, atUs, bounces, bounceUs, 1);
+}
+
+/**
+ * @brief Schedules a key release
+ * @param row Matrix row
+ * @param col Matrix column
+ * @param atUs Time the contact first opens
+ * @param bounces Extra close and open pairs as it settles
+ * @param bounceUs Time the bounce lasts
+ * @retval none
+ */
+void simMatrixRelease(uint8_t row, uint8_t col, uint64_t atUs, uint8_t bounces,
+		uint32_t bounceUs)
+{
+	simMatrixBounce(row, col, atUs, bounces, bounceUs, 0);
+}
+
+/**
+ * @brief Plays the script forward to the current virtual time
+ * @param none
+ * @retval Count of changes applied so far, moves whenever a switch moves
+ */
+uint32_t simMatrixAdvance(void)
+{
+	uint64_t now = simClockNowUs();
+
+	if (!sorted)
+	{
+		qsort(contacts + cursor, contactCount - cursor, sizeof(sim_contact_t),
+				simMatrixCompare);
+		sorted = 1;
+	}
+	while (cursor < contactCount && contacts[cursor].atUs <= now)
+	{
+		sim_contact_t *change = &contacts[cursor++];
+
+		closed[change->row] = change->closed ? (closed[change->row] | (1UL << change->col))
+				: (closed[change->row] & ~(1UL << change->col));
+	}
+	return cursor;
+}
+
+/**
+ * @brief Every scripted press and release
+ * @param list Set to the edges, in time order
+ * @retval Number of edges
+ */
+uint32_t simMatrixGetEdges(const sim_matrix_edge_t **list)
+{
+	*list = edges;
+	return edgeCount;
+}
+
+/**
+ * @brief Works out which columns read low
+ * @param lowRows Bit per row being driven low
+ * @retval Bit per column connected to a low row
+ */
+uint32_t simMatrixColumns(uint8_t lowRows)
+{
+	uint32_t cols = 0;
+	uint8_t rows = lowRows;
+	uint8_t reached;
+
+	/* Spread through closed switches until no new row is reached */
+	do
+	{
+		reached = rows;
+		for (int rr = 0; rr < keyboardNUM_ROWS; rr++)
+		{
+			if (rows & (1U << rr))
+			{
+				cols |= closed[rr];
+			}
+		}
+		for (int rr = 0; rr < keyboardNUM_ROWS; rr++)
+		{
+			if (closed[rr] & cols)
+			{
+				rows |= 1U << rr;
+			}
+		}
+	} while (rows != reached);
+	return cols;
+}
+
+/**
+ * @brief Copies what the script has scheduled so far
+ * @param out Destination
+ * @retval none
+ */
+void simMatrixGetStats(sim_matrix_stats_t *out)
+{
+	*out = stats;
+}
+/* EOF */
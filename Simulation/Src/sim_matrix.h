@@ -0,0 +1,61 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file sim_matrix.h
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief Definitions and prototypes for the scripted virtual key matrix
+ ******************************************************************************/
+// @formatter:off
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __SIM_MATRIX_H
+#define __SIM_MATRIX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Defines -------------------------------------------------------------------*/
+#define simmatrixDEFAULT_SEED		( 0x1394100UL )
+
+/* Structures ----------------------------------------------------------------*/
+typedef struct _SIM_MATRIX_STATS_S_
+{
+	uint32_t presses;		/* Scripted presses */
+	uint32_t releases;		/* Scripted releases */
+	uint32_t transitions;	/* Contact changes, bounces included */
+} sim_matrix_stats_t;
+
+typedef struct _SIM_MATRIX_EDGE_S_
+{
+	uint64_t atUs;			/* When the contact first changed */
+	uint8_t row;
+	uint8_t col;
+	_Bool pressed;
+} sim_matrix_edge_t;
+
+/* Prototypes ----------------------------------------------------------------*/
+void simMatrixInit(uint32_t seed);
+void simMatrixContact(uint8_t row, uint8_t col, uint64_t atUs, _Bool closed);
+void simMatrixEdge(uint8_t row, uint8_t col, uint64_t atUs, _Bool pressed);
+void simMatrixPress(uint8_t row, uint8_t col, uint64_t atUs, uint8_t bounces,
+		uint32_t bounceUs);
+void simMatrixRelease(uint8_t row, uint8_t col, uint64_t atUs, uint8_t bounces,
+		uint32_t bounceUs);
+uint32_t simMatrixAdvance(void);
+uint32_t simMatrixColumns(uint8_t lowRows);
+uint32_t simMatrixGetEdges(const sim_matrix_edge_t **edges);
+uint32_t simMatrixRandom(void);
+void simMatrixGetStats(sim_matrix_stats_t *stats);
+
+/* Exported variables --------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SIM_MATRIX_H */
+/* EOF */
@@ -0,0 +1,373 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file sim_script.c
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief Reads simulation scripts into the virtual matrix and settings
+ ******************************************************************************/
+// @formatter:off
+
+/* Includes ------------------------------------------------------------------*/
+#include "sim_script.h"
+#include "sim_matrix.h"
+#include "sim_bounce.h"
+#include "sim_settings.h"
+#include "sim_host.h"
+
+#include "../../Core/Src/Settings/settings.h"
+#include "../../Core/Src/Keyboard/keyboard.h"
+#include "../../Core/Src/Keyboard/keymap.h"
+#include "../../Core/Src/Keyboard/debounce.h"
+#include "../../Core/Src/Keyboard/combo.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * One command per line, # starts a comment. Times are in ms from reset and
+ * may have decimals.
+ *
+ *   debounce <ms>                         debounce setting the firmware boots with
+ *   keymap   <profile> <file>            store a keymap as a profile and boot on it
+ *   level    <row> <col> <level>         learned debounce level a key boots with
+ *   combo    <action> <window> <row> <col> <row> <col> [...]   add a combo
+ *   press    <t> <row> <col> [<n> <ms>]   close a switch, then bounce n times over ms
+ *   release  <t> <row> <col> [<n> <ms>]   open a switch, same bounce options
+ *   tap      <t> <row> <col> <hold> [<n> <ms>]   press, then release hold ms later
+ *   strike   <t> <row> <col> <hold> <profile>    one keystroke, see sim_bounce.c
+ *   strokes  <t> <count> <profile>       keystrokes on random keys, one at a time
+ *   replay   <t> <row> <col> <file>      a recorded waveform, see simBounceReplay()
+ *   expect   <t> <mods> [<usage> ...]    next keyboard report after t, see sim_host.c
+ *   end      <t>                          stop the run
+ *
+ * Without an end, the run stops simscriptTAIL_MS after the last change.
+ * Modifiers and usages are numbers, 0x for hex. A keymap file is what
+ * Tools/settings_write.py takes: 16 bit actions separated by white space, #
+ * starts a comment, one per key row by row, and one such block per layer.
+ * A level is 0, debounceFLOOR_MS, to 15, the debounce setting, as debounce.c
+ * learns them; keys without one start at 15. A combo's action is a keymap
+ * action and its window is in ms, 0 for comboDEFAULT_WINDOW_MS.
+ */
+
+/* Defines -------------------------------------------------------------------*/
+#define US(ms)				( (uint64_t)((ms) * 1000.0 + 0.5) )
+
+/* Static prototypes ---------------------------------------------------------*/
+static _Bool simScriptKeymap(const char *path, uint8_t profile);
+static _Bool simScriptExpect(const char *line, int lineNo);
+static _Bool simScriptLevel(unsigned row, unsigned col, unsigned level);
+static _Bool simScriptCombo(const char *line);
+
+/* Code ----------------------------------------------------------------------*/
+/**
+ * @brief Stores a keymap file as a profile and selects it
+ * @param path Keymap file
+ * @param profile Profile number
+ * @retval 1 on success, 0 after printing what was wrong
+ */
+static _Bool simScriptKeymap(const char *path, uint8_t profile)
+{
+	static uint8_t raw[sizeof(settings_keymap_t)
+			+ keymapMAX_LAYERS * keyboardNUM_KEYS * sizeof(uint16_t)] __attribute__((aligned(4)));
+	settings_keymap_t *map = (settings_keymap_t *)raw;
+	FILE *in = fopen(path, "r");
+	char line[simscriptLINE_LEN];
+	uint32_t count = 0;
+	uint16_t length;
+
+	if (in == NULL)
+	{
+		perror(path);
+		return 0;
+	}
+	while (fgets(line, sizeof(line), in) != NULL)
+	{
+		char *hash = strchr(line, '#');
+		char *word;
+
+		if (hash != NULL)
+		{
+			*hash = '\0';
+		}
+		for (word = strtok(line, " \t\r\n"); word != NULL; word = strtok(NULL, " \t\r\n"))
+		{
+			char *end;
+			unsigned long action = strtoul(word, &end, 0);
+
+			if (*end != '\0' || action > UINT16_MAX
+					|| count == keymapMAX_LAYERS * keyboardNUM_KEYS)
+			{
+				fprintf(stderr, "%s: bad or one too many actions at: %s\n", path, word);
+				fclose(in);
+				return 0;
+			}
+			map->actions[count++] = (uint16_t)action;
+		}
+	}
+	fclose(in);
+	if (count == 0 || count % keyboardNUM_KEYS)
+	{
+		fprintf(stderr, "%s: %u actions is not whole layers of %u\n", path, count,
+				keyboardNUM_KEYS);
+		return 0;
+	}
+	map->numLayers = (uint16_t)(count / keyboardNUM_KEYS);
+	map->numKeys = keyboardNUM_KEYS;
+	length = (uint16_t)(sizeof(settings_keymap_t) + count * sizeof(uint16_t));
+	if (!simSettingsWrite(settingsKEY_KEYMAP(profile), raw, length)
+			|| !simSettingsSelect(profile))
+	{
+		fprintf(stderr, "%s: could not be stored as profile %u\n", path, profile);
+		return 0;
+	}
+	return 1;
+}
+
+/**
+ * @brief Stores a key's learned debounce level
+ * @note Every call rewrites the whole map, the last write is the one booted.
+ * @param row Matrix row
+ * @param col Matrix column
+ * @param level Level, 0 to debounceLEVELS - 1
+ * @retval 1 on success, 0 if out of range
+ */
+static _Bool simScriptLevel(unsigned row, unsigned col, unsigned level)
+{
+	static uint8_t map[debounceMAP_BYTES];
+	static _Bool started;
+	uint16_t key = (uint16_t)GET_IDX(col, row, keyboardNUM_COLS);
+	uint8_t shift = (key & 1) * 4;
+
+	if (row >= keyboardNUM_ROWS || col >= keyboardNUM_COLS || level >= debounceLEVELS)
+	{
+		return 0;
+	}
+	if (!started)
+	{
+		memset(map, 0xFF, sizeof(map));
+		started = 1;
+	}
+	map[key >> 1] = (uint8_t)((map[key >> 1] & ~(0x0F << shift)) | (level << shift));
+	return simSettingsWrite(settingsKEY_DEBOUNCE_MAP, map, sizeof(map));
+}
+
+/**
+ * @brief Adds a combo to the ones the firmware boots with
+ * @note Every call rewrites the whole table, the last write is the one booted.
+ * @param line Script line, comment already cut off
+ * @retval 1 on success, 0 if it does not parse or there are too many
+ */
+static _Bool simScriptCombo(const char *line)
+{
+	static combo_def_t table[comboMAX_COMBOS];
+	static uint8_t count;
+	combo_def_t combo = {
+		.count = 0
+	};
+	int action;
+	unsigned window;
+	unsigned row;
+	unsigned col;
+	int used;
+
+	if (sscanf(line, "%*s %i %u%n", &action, &window, &used) != 2
+			|| action < 0 || action > UINT16_MAX || window > UINT8_MAX || count == comboMAX_COMBOS)
+	{
+		return 0;
+	}
+	combo.action = (uint16_t)action;
+	combo.windowMs = (uint8_t)window;
+	for (line += used; sscanf(line, "%u %u%n", &row, &col, &used) == 2; line += used)
+	{
+		if (row >= keyboardNUM_ROWS || col >= keyboardNUM_COLS
+				|| combo.count == comboMAX_KEYS)
+		{
+			return 0;
+		}
+		combo.keys[combo.count++] = (uint8_t)GET_IDX(col, row, keyboardNUM_COLS);
+	}
+	if (combo.count < 2)
+	{
+		return 0;
+	}
+	table[count++] = combo;
+	return simSettingsWrite(settingsKEY_COMBOS, table, (uint16_t)(count * sizeof(combo_def_t)));
+}
+
+/**
+ * @brief Hands an expect line to the host
+ * @param line Script line, comment already cut off
+ * @param lineNo Its number
+ * @retval 1 on success, 0 if it does not parse or there are too many
+ */
+static _Bool simScriptExpect(const char *line, int lineNo)
+{
+	sim_host_expect_t expect = {
+		.line = lineNo
+	};
+	double at;
+	int value;
+	int used;
+
+	if (sscanf(line, "%*s %lf %i%n", &at, &value, &used) != 2 || value < 0 || value > 0xFF)
+	{
+		return 0;
+	}
+	expect.fromMs = (uint32_t)at;
+	expect.modifiers = (uint8_t)value;
+	for (line += used; sscanf(line, "%i%n", &value, &used) == 1; line += used)
+	{
+		if (value <= 0 || value > 0xFF || expect.count == sizeof(expect.keys))
+		{
+			return 0;
+		}
+		expect.keys[expect.count++] = (uint8_t)value;
+	}
+	return simHostExpect(&expect);
+}
+
+/**
+ * @brief Loads a script
+ * @param path File to read, "-" for stdin
+ * @param script Filled in with the run's settings
+ * @retval 1 on success, 0 after printing what was wrong
+ */
+_Bool simScriptLoad(const char *path, sim_script_t *script)
+{
+	FILE *in = strcmp(path, "-") ? fopen(path, "r") : stdin;
+	char line[simscriptLINE_LEN];
+	double lastMs = 0;
+	double endMs = -1;
+	int lineNo = 0;
+
+	if (in == NULL)
+	{
+		perror(path);
+		return 0;
+	}
+	while (fgets(line, sizeof(line), in) != NULL)
+	{
+		char command[16];
+		char name[simscriptLINE_LEN];
+		const sim_bounce_profile_t *profile = NULL;
+		uint64_t endUs = 0;
+		double at = 0;
+		double hold = 0;
+		double bounceMs = 0;
+		unsigned row = 0;
+		unsigned col = 0;
+		unsigned bounces = 0;
+		int fields;
+		char *hash = strchr(line, '#');
+
+		lineNo++;
+		if (hash != NULL)
+		{
+			*hash = '\0';
+		}
+		if (sscanf(line, "%15s", command) != 1)
+		{
+			continue;
+		}
+		if (!strcmp(command, "debounce") && sscanf(line, "%*s %lf", &at) == 1)
+		{
+			uint16_t debounce = (uint16_t)at;
+
+			simSettingsWrite(settingsKEY_DEBOUNCE, &debounce, sizeof(debounce));
+		}
+		else if (!strcmp(command, "keymap")
+				&& sscanf(line, "%*s %u %127s", &bounces, name) == 2
+				&& bounces < settingsMAX_PROFILES)
+		{
+			if (!simScriptKeymap(name, (uint8_t)bounces))
+			{
+				if (in != stdin)
+				{
+					fclose(in);
+				}
+				return 0;
+			}
+		}
+		else if (!strcmp(command, "level")
+				&& sscanf(line, "%*s %u %u %u", &row, &col, &bounces) == 3
+				&& simScriptLevel(row, col, bounces))
+		{
+		}
+		else if (!strcmp(command, "combo") && simScriptCombo(line))
+		{
+		}
+		else if (!strcmp(command, "expect") && simScriptExpect(line, lineNo))
+		{
+		}
+		else if (!strcmp(command, "end") && sscanf(line, "%*s %lf", &endMs) == 1)
+		{
+		}
+		else if ((!strcmp(command, "press") || !strcmp(command, "release"))
+				&& (fields = sscanf(line, "%*s %lf %u %u %u %lf", &at, &row, &col,
+						&bounces, &bounceMs)) >= 3 && fields != 4)
+		{
+			if (command[0] == 'p')
+			{
+				simMatrixPress(row, col, US(at), bounces, (uint32_t)US(bounceMs));
+			}
+			else
+			{
+				simMatrixRelease(row, col, US(at), bounces, (uint32_t)US(bounceMs));
+			}
+			lastMs = (at + bounceMs > lastMs) ? at + bounceMs : lastMs;
+		}
+		else if (!strcmp(command, "tap")
+				&& (fields = sscanf(line, "%*s %lf %u %u %lf %u %lf", &at, &row,
+						&col, &hold, &bounces, &bounceMs)) >= 4 && fields != 5)
+		{
+			simMatrixPress(row, col, US(at), bounces, (uint32_t)US(bounceMs));
+			simMatrixRelease(row, col, US(at + hold), bounces, (uint32_t)US(bounceMs));
+			lastMs = (at + hold + bounceMs > lastMs) ? at + hold + bounceMs : lastMs;
+		}
+		else if (!strcmp(command, "strike")
+				&& sscanf(line, "%*s %lf %u %u %lf %127s", &at, &row, &col, &hold,
+						name) == 5 && (profile = simBounceFind(name)) != NULL)
+		{
+			simBounceStrike(profile, row, col, US(at), US(hold));
+			endUs = US(at + hold) + profile->ringDelayUs + profile->ringUs;
+			lastMs = (endUs / 1000.0 > lastMs) ? endUs / 1000.0 : lastMs;
+		}
+		else if (!strcmp(command, "strokes")
+				&& sscanf(line, "%*s %lf %u %127s", &at, &bounces, name) == 3
+				&& (profile = simBounceFind(name)) != NULL)
+		{
+			endUs = simBounceStrokes(profile, US(at), bounces);
+			lastMs = (endUs / 1000.0 > lastMs) ? endUs / 1000.0 : lastMs;
+		}
+		else if (!strcmp(command, "replay")
+				&& sscanf(line, "%*s %lf %u %u %127s", &at, &row, &col, name) == 4)
+		{
+			if (!simBounceReplay(name, row, col, US(at), &endUs))
+			{
+				if (in != stdin)
+				{
+					fclose(in);
+				}
+				return 0;
+			}
+			lastMs = (endUs / 1000.0 > lastMs) ? endUs / 1000.0 : lastMs;
+		}
+		else
+		{
+			fprintf(stderr, "%s:%d: cannot make sense of: %s", path, lineNo, line);
+			if (in != stdin)
+			{
+				fclose(in);
+			}
+			return 0;
+		}
+	}
+	if (in != stdin)
+	{
+		fclose(in);
+	}
+	script->endMs = (uint32_t)((endMs >= 0) ? endMs : lastMs + simscriptTAIL_MS);
+	return 1;
+}
+/* EOF */
@@ -0,0 +1,41 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file sim_script.h
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief Definitions and prototypes for simulation scripts
+ ******************************************************************************/
+// @formatter:off
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __SIM_SCRIPT_H
+#define __SIM_SCRIPT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Defines -------------------------------------------------------------------*/
+#define simscriptLINE_LEN			( 256 )
+#define simscriptTAIL_MS			( 500 )	/* Run on after the last key, by default */
+
+/* Structures ----------------------------------------------------------------*/
+typedef struct _SIM_SCRIPT_S_
+{
+	uint32_t endMs;			/* Virtual time the run stops at */
+} sim_script_t;
+
+/* Prototypes ----------------------------------------------------------------*/
+_Bool simScriptLoad(const char *path, sim_script_t *script);
+
+/* Exported variables --------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SIM_SCRIPT_H */
+/* EOF */
@@ -0,0 +1,108 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file sim_settings.c
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief The flash settings log, with a way to fill it before the firmware boots
+ ******************************************************************************/
+// @formatter:off
+
+/* Includes ------------------------------------------------------------------*/
+#include "sim_settings.h"
+
+/**
+ * The simulation runs the real settings.c over the sectors in sim_flash.c.
+ * It is compiled in here, rather than on its own, so a script can program
+ * settings before the firmware starts, as if the keyboard had been set up on
+ * an earlier run: each write goes through the settings task's own flush,
+ * synchronously. settingsInit() then mounts whatever ended up in flash.
+ */
+#include "../../Core/Src/Settings/settings.c"
+
+/* Private variables ---------------------------------------------------------*/
+static _Bool mounted;
+
+/* Code ----------------------------------------------------------------------*/
+/**
+ * @brief Mounts the log on first use and readies the spare page
+ * @note Nothing else runs yet, so the erase need not wait for an idle matrix.
+ * @param none
+ * @retval none
+ */
+static void simSettingsPrepare(void)
+{
+	if (!mounted)
+	{
+		settingsMount();
+		mounted = 1;
+	}
+	if (spareDirty)
+	{
+		settingsEraseSpare();
+	}
+}
+
+/**
+ * @brief Programs whatever has been staged, as the settings task would
+ * @param none
+ * @retval 1 if nothing is left staged, otherwise 0
+ */
+_Bool simSettingsFlush(void)
+{
+	simSettingsPrepare();
+	settingsFlush();
+	return pendingCount == 0;
+}
+
+/**
+ * @brief Programs a setting straight away, before the scheduler starts
+ * @param key Record key
+ * @param data Payload
+ * @param length Payload bytes
+ * @retval 1 if the record is now in flash, otherwise 0
+ */
+_Bool simSettingsWrite(uint16_t key, const void *data, uint16_t length)
+{
+	const settings_record_t *before;
+
+	simSettingsPrepare();
+	before = (key < settingsMAX_KEYS) ? recordIndex[key] : NULL;
+	if (settingsWrite(key, data, length) != pdPASS)
+	{
+		return 0;
+	}
+	/* Every record programmed lands somewhere new, even with the same value */
+	return simSettingsFlush() && recordIndex[key] != before;
+}
+
+/**
+ * @brief Selects a stored profile, before the scheduler starts
+ * @param profile Profile number
+ * @retval 1 if the profile exists and the choice is in flash, otherwise 0
+ */
+_Bool simSettingsSelect(uint8_t profile)
+{
+	simSettingsPrepare();
+	if (settingsSelectProfile(profile) != pdPASS)
+	{
+		return 0;
+	}
+	return simSettingsFlush();
+}
+
+/**
+ * @brief Forgets everything held in RAM, as a reset would, and mounts the
+ *        flash again
+ * @param none
+ * @retval none
+ */
+void simSettingsReset(void)
+{
+	activeProfile = NO_PROFILE;
+	pendingCount = 0;
+	stagingUsed = 0;
+	mounted = 0;
+	settingsMount();
+	mounted = 1;
+}
+/* EOF */
@@ -0,0 +1,36 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file sim_settings.h
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief Definitions and prototypes for setting up flash before boot
+ ******************************************************************************/
+// @formatter:off
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __SIM_SETTINGS_H
+#define __SIM_SETTINGS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Defines -------------------------------------------------------------------*/
+
+/* Prototypes ----------------------------------------------------------------*/
+_Bool simSettingsFlush(void);
+_Bool simSettingsWrite(uint16_t key, const void *data, uint16_t length);
+_Bool simSettingsSelect(uint8_t profile);
+void simSettingsReset(void);
+
+/* Exported variables --------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SIM_SETTINGS_H */
+/* EOF */
@@ -0,0 +1,461 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file sim_settings_test.c
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief Runs the flash settings log through writes, compactions and failures
+ ******************************************************************************/
+// @formatter:off
+
+/* Includes ------------------------------------------------------------------*/
+#include "sim_flash.h"
+#include "sim_settings.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "../../Core/Src/Settings/settings.h"
+#include "../../Core/Src/Keyboard/keyboard.h"
+#include "../../Core/Src/Keyboard/keymap.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Usage: settings_test
+ *
+ * settings.c on its own, over the sectors in sim_flash.c. Nothing here runs
+ * the kernel: the settings task's flush is called directly, and the kernel
+ * calls settings.c makes are stubbed below, the ones it never makes here
+ * abort. A "reset" forgets RAM and mounts
+ * the flash again, so every check that matters is made after one.
+ */
+
+/* Defines -------------------------------------------------------------------*/
+#define CHECK(cond)			simTestCheck((cond), #cond, __LINE__)
+#define KEY_BLOB			( 5 )		/* Free key used to fill pages */
+#define BLOB_SIZE			( 500 )
+
+/* Private variables ---------------------------------------------------------*/
+static uint32_t checks;
+static uint32_t failures;
+static const uint16_t *usedLayers;		/* Last keymapUseLayers() */
+static uint8_t usedCount;
+
+/* Static prototypes ---------------------------------------------------------*/
+static void simTestCheck(_Bool ok, const char *what, int line);
+static _Bool simTestBlob(uint8_t fill);
+static uint8_t simTestBlobValue(void);
+static uint16_t simTestUsed(void);
+static void simTestFresh(void);
+static void simTestCompaction(void);
+static void simTestTornRecord(void);
+static void simTestTornCompaction(void);
+static void simTestPieces(void);
+static void simTestProfile(void);
+static void simTestOverfull(void);
+static void simTestNoKernel(void);
+
+/* Code ----------------------------------------------------------------------*/
+/**
+ * @brief Counts a check and reports it if it failed
+ * @param ok Outcome
+ * @param what Condition as written
+ * @param line Source line
+ * @retval none
+ */
+static void simTestCheck(_Bool ok, const char *what, int line)
+{
+	checks++;
+	if (!ok)
+	{
+		failures++;
+		fprintf(stderr, "settings_test: line %d: %s\n", line, what);
+	}
+}
+
+/**
+ * @brief Writes the filler record, every byte the same
+ * @param fill Byte value
+ * @retval 1 if it was programmed
+ */
+static _Bool simTestBlob(uint8_t fill)
+{
+	uint8_t blob[BLOB_SIZE];
+
+	memset(blob, fill, sizeof(blob));
+	return simSettingsWrite(KEY_BLOB, blob, sizeof(blob));
+}
+
+/**
+ * @brief Reads the filler record back
+ * @param none
+ * @retval Its byte value, 0 if it is missing or not uniform
+ */
+static uint8_t simTestBlobValue(void)
+{
+	uint16_t length = 0;
+	const uint8_t *blob = settingsGet(KEY_BLOB, &length);
+
+	if (blob == NULL || length != BLOB_SIZE)
+	{
+		return 0;
+	}
+	for (uint16_t ii = 1; ii < length; ii++)
+	{
+		if (blob[ii] != blob[0])
+		{
+			return 0;
+		}
+	}
+	return blob[0];
+}
+
+/**
+ * @brief Bytes in use in the active page
+ * @param none
+ * @retval As settingsGetStats() has it
+ */
+static uint16_t simTestUsed(void)
+{
+	settings_stats_t stats;
+
+	settingsGetStats(&stats);
+	return stats.used;
+}
+
+/**
+ * @brief A setting survives a reset from blank flash
+ * @param none
+ * @retval none
+ */
+static void simTestFresh(void)
+{
+	uint16_t debounce = 7;
+	uint16_t length = 0;
+	const uint16_t *saved;
+
+	simSettingsReset();
+	CHECK(settingsGet(settingsKEY_DEBOUNCE, NULL) == NULL);
+	CHECK(simSettingsWrite(settingsKEY_DEBOUNCE, &debounce, sizeof(debounce)));
+	simSettingsReset();
+	saved = settingsGet(settingsKEY_DEBOUNCE, &length);
+	CHECK(saved != NULL && length == sizeof(debounce) && *saved == 7);
+}
+
+/**
+ * @brief Writes far more than a page holds; the latest of every key stays
+ * @param none
+ * @retval none
+ */
+static void simTestCompaction(void)
+{
+	sim_flash_stats_t before;
+	sim_flash_stats_t after;
+	uint16_t used = simTestUsed();
+	uint32_t shrinks = 0;
+
+	simFlashGetStats(&before);
+	for (int ii = 1; ii <= 3 * settingsPAGE_SIZE / BLOB_SIZE; ii++)
+	{
+		CHECK(simTestBlob((uint8_t)ii));
+		shrinks += (simTestUsed() < used);
+		used = simTestUsed();
+		if (ii % 10 == 0)
+		{
+			simSettingsReset();
+			CHECK(simTestBlobValue() == (uint8_t)ii);
+			CHECK(*(const uint16_t *)settingsGet(settingsKEY_DEBOUNCE, NULL) == 7);
+		}
+	}
+	simFlashGetStats(&after);
+	CHECK(shrinks >= 2);
+	CHECK(after.erases - before.erases >= 2);
+	CHECK(after.overwrites == 0);
+}
+
+/**
+ * @brief A record cut short by a reset is ignored, and the page is retired
+ * @param none
+ * @retval none
+ */
+static void simTestTornRecord(void)
+{
+	uint8_t last;
+
+	CHECK(simTestBlob(0x11));
+	simFlashFailAfter(3);
+	CHECK(!simTestBlob(0x22));
+	simFlashFailAfter(simflashNEVER_FAIL);
+	CHECK(simTestBlobValue() == 0x11);
+	CHECK(simTestUsed() == settingsPAGE_SIZE);
+
+	/* Written again after the reset, it lands in a fresh page */
+	simSettingsReset();
+	CHECK(simTestBlobValue() == 0x11);
+	CHECK(simTestBlob(0x33));
+	last = simTestBlobValue();
+	simSettingsReset();
+	CHECK(last == 0x33 && simTestBlobValue() == 0x33);
+}
+
+/**
+ * @brief A compaction cut short leaves the old page in charge
+ * @param none
+ * @retval none
+ */
+static void simTestTornCompaction(void)
+{
+	sim_flash_stats_t stats;
+	uint16_t need = sizeof(settings_record_t) + BLOB_SIZE;
+
+	/* Fill the page until the next blob has to compact */
+	while (simTestUsed() + need <= settingsPAGE_SIZE)
+	{
+		CHECK(simTestBlob(0x44));
+	}
+	simFlashFailAfter(2);
+	CHECK(!simTestBlob(0x55));
+	simFlashFailAfter(simflashNEVER_FAIL);
+	CHECK(simTestBlobValue() == 0x44);
+
+	simSettingsReset();
+	CHECK(simTestBlobValue() == 0x44);
+	CHECK(*(const uint16_t *)settingsGet(settingsKEY_DEBOUNCE, NULL) == 7);
+	CHECK(simTestBlob(0x66));
+	CHECK(simTestUsed() < settingsPAGE_SIZE / 2);
+	simSettingsReset();
+	CHECK(simTestBlobValue() == 0x66);
+	simFlashGetStats(&stats);
+	CHECK(stats.overwrites == 0);
+}
+
+/**
+ * @brief A record sent in pieces is only programmed once complete, in order
+ * @param none
+ * @retval none
+ */
+static void simTestPieces(void)
+{
+	const uint8_t data[10] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+	const uint8_t *saved;
+	uint16_t length = 0;
+
+	CHECK(settingsWritePart(6, 0, sizeof(data), data, 4) == pdPASS);
+	CHECK(!simSettingsFlush());
+	CHECK(settingsGet(6, NULL) == NULL);
+	/* Out of order, or for another record */
+	CHECK(settingsWritePart(6, 6, sizeof(data), &data[6], 4) == pdFAIL);
+	CHECK(settingsWritePart(7, 4, sizeof(data), &data[4], 6) == pdFAIL);
+	CHECK(settingsWritePart(6, 4, sizeof(data) + 1, &data[4], 6) == pdFAIL);
+	CHECK(settingsWritePart(6, 4, sizeof(data), &data[4], 7) == pdFAIL);
+
+	/* Starting over drops the unfinished one */
+	CHECK(settingsWritePart(6, 0, sizeof(data), data, 4) == pdPASS);
+	CHECK(settingsWritePart(6, 4, sizeof(data), &data[4], 6) == pdPASS);
+	CHECK(simSettingsFlush());
+	simSettingsReset();
+	saved = settingsGet(6, &length);
+	CHECK(saved != NULL && length == sizeof(data) && !memcmp(saved, data, sizeof(data)));
+}
+
+/**
+ * @brief A selected profile's keymap follows its record through compactions
+ * @param none
+ * @retval none
+ */
+static void simTestProfile(void)
+{
+	static uint8_t raw[sizeof(settings_keymap_t) + keyboardNUM_KEYS * sizeof(uint16_t)]
+			__attribute__((aligned(4)));
+	settings_keymap_t *map = (settings_keymap_t *)raw;
+	const settings_keymap_t *stored;
+	const uint8_t *profile;
+
+	map->numLayers = 1;
+	map->numKeys = keyboardNUM_KEYS;
+	for (uint16_t kk = 0; kk < keyboardNUM_KEYS; kk++)
+	{
+		map->actions[kk] = kk;
+	}
+	CHECK(!simSettingsSelect(3));
+	CHECK(simSettingsWrite(settingsKEY_KEYMAP(3), raw, sizeof(raw)));
+	CHECK(simSettingsSelect(3));
+	stored = settingsGet(settingsKEY_KEYMAP(3), NULL);
+	CHECK(usedLayers == stored->actions && usedCount == 1);
+
+	for (int ii = 0; ii < 2 * settingsPAGE_SIZE / BLOB_SIZE; ii++)
+	{
+		CHECK(simTestBlob((uint8_t)(0x80 + ii)));
+	}
+	stored = settingsGet(settingsKEY_KEYMAP(3), NULL);
+	CHECK(usedLayers == stored->actions && !memcmp(stored, raw, sizeof(raw)));
+
+	simSettingsReset();
+	profile = settingsGet(settingsKEY_PROFILE, NULL);
+	CHECK(profile != NULL && *profile == 3);
+}
+
+/**
+ * @brief More live data than a page holds: what does not fit is refused, and
+ *        nothing is programmed past the spare page
+ * @param none
+ * @retval none
+ */
+static void simTestOverfull(void)
+{
+	static const uint16_t keys[] = { 8, 9, 10, 11, 12, 13, 14, 15, 24, 25, 26, 27 };
+	static uint8_t big[1500];
+	sim_flash_stats_t before;
+	sim_flash_stats_t after;
+	_Bool stored[sizeof(keys) / sizeof(keys[0])];
+	uint32_t refused = 0;
+	const uint8_t *saved;
+
+	simFlashGetStats(&before);
+	for (uint32_t ii = 0; ii < sizeof(keys) / sizeof(keys[0]); ii++)
+	{
+		memset(big, (int)keys[ii], sizeof(big));
+		stored[ii] = simSettingsWrite(keys[ii], big, sizeof(big));
+		refused += !stored[ii];
+	}
+	simFlashGetStats(&after);
+	CHECK(refused > 0);
+	CHECK(after.failures == before.failures && after.overwrites == 0);
+
+	simSettingsReset();
+	for (uint32_t ii = 0; ii < sizeof(keys) / sizeof(keys[0]); ii++)
+	{
+		saved = settingsGet(keys[ii], NULL);
+		CHECK(!stored[ii] || (saved != NULL && saved[0] == keys[ii]
+				&& saved[sizeof(big) - 1] == keys[ii]));
+	}
+	CHECK(simTestBlobValue() != 0);
+}
+
+/**
+ * @brief The keyboard is always idle here
+ * @param ms Unused
+ * @retval 1
+ */
+_Bool keyboardIsIdle(uint32_t ms)
+{
+	(void)ms;
+	return 1;
+}
+
+/**
+ * @brief Records the tables settings.c points the keymap at
+ * @param actions Tables
+ * @param numLayers Layers in them
+ * @retval none
+ */
+void keymapUseLayers(const uint16_t *actions, uint8_t numLayers)
+{
+	usedLayers = actions;
+	usedCount = numLayers;
+}
+
+/**
+ * @brief Swaps are taken at once here
+ * @param none
+ * @retval 0
+ */
+_Bool keymapSwapPending(void)
+{
+	return 0;
+}
+
+/**
+ * @brief Masks nothing, there are no interrupts here
+ * @param none
+ * @retval 0
+ */
+UBaseType_t ulPortSetInterruptMask(void)
+{
+	return 0;
+}
+
+/**
+ * @brief Undoes ulPortSetInterruptMask()
+ * @param ulMask Unused
+ * @retval none
+ */
+void vPortClearInterruptMask(UBaseType_t ulMask)
+{
+	(void)ulMask;
+}
+
+/**
+ * @brief Everything here runs as a task would
+ * @param none
+ * @retval pdFALSE
+ */
+BaseType_t xPortIsInsideInterrupt(void)
+{
+	return pdFALSE;
+}
+
+/**
+ * @brief settingsInit() is never called, so neither is the rest of the kernel
+ * @param none
+ * @retval none
+ */
+static void simTestNoKernel(void)
+{
+	fprintf(stderr, "settings_test: the kernel was called\n");
+	abort();
+}
+
+void vPortYield(void)
+{
+	simTestNoKernel();
+}
+
+BaseType_t xTaskGenericNotify(TaskHandle_t xTaskToNotify, uint32_t ulValue,
+		eNotifyAction eAction, uint32_t *pulPreviousNotificationValue)
+{
+	simTestNoKernel();
+	return pdFAIL;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t xTaskToNotify,
+		BaseType_t *pxHigherPriorityTaskWoken)
+{
+	simTestNoKernel();
+}
+
+BaseType_t xTaskNotifyWait(uint32_t ulBitsToClearOnEntry, uint32_t ulBitsToClearOnExit,
+		uint32_t *pulNotificationValue, TickType_t xTicksToWait)
+{
+	simTestNoKernel();
+	return pdFAIL;
+}
+
+TaskHandle_t xTaskCreateStatic(TaskFunction_t pxTaskCode, const char * const pcName,
+		const uint32_t ulStackDepth, void * const pvParameters,
+		UBaseType_t uxPriority, StackType_t * const puxStackBuffer,
+		StaticTask_t * const pxTaskBuffer)
+{
+	simTestNoKernel();
+	return NULL;
+}
+
+/**
+ * @brief Entry point
+ * @param none
+ * @retval 0 if every check passed
+ */
+int main(void)
+{
+	simTestFresh();
+	simTestCompaction();
+	simTestTornRecord();
+	simTestTornCompaction();
+	simTestPieces();
+	simTestProfile();
+	simTestOverfull();
+	printf("settings_test: %u checks, %u failed\n", checks, failures);
+	return failures ? 1 : 0;
+}
+/* EOF */
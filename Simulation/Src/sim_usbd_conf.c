@@ -0,0 +1,391 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file sim_usbd_conf.c
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief USB device library low level layer, backed by endpoints in memory
+ ******************************************************************************/
+// @formatter:off
+
+/* Includes ------------------------------------------------------------------*/
+#include "sim_usbd_conf.h"
+#include "sim_clock.h"
+
+#include "usbd_core.h"
+#include "usbd_hid.h"
+
+#include <string.h>
+
+/**
+ * Stands in for USB_DEVICE/Target/usbd_conf.c, which drives the OTG core
+ * through the PCD HAL. The core, control request and HID class code above it
+ * are the real ones. Here an endpoint is a buffer pointer and an armed flag:
+ * USBD_LL_Transmit() and USBD_LL_PrepareReceive() arm it, and the simulated
+ * host in sim_host.c moves the data and makes the DataIn/DataOut callbacks the
+ * PCD interrupt handler would, one packet at a time.
+ */
+
+/* Global variables ----------------------------------------------------------*/
+/* The unique ID words usbd_desc.c builds the serial number from */
+const uint32_t simUid[3] = { 0x00430031, 0x31385107, 0x35353634 };
+
+/* Private variables ---------------------------------------------------------*/
+static sim_usbd_ep_t inEps[simusbdMAX_EPS];
+static sim_usbd_ep_t outEps[simusbdMAX_EPS];
+static uint8_t address;
+static _Bool connected;
+
+/* Static prototypes ---------------------------------------------------------*/
+static sim_usbd_ep_t *simUsbdEp(uint8_t epAddr);
+
+/* Code ----------------------------------------------------------------------*/
+/**
+ * @brief Finds an endpoint by address
+ * @param epAddr Endpoint address, bit 7 set for IN
+ * @retval Endpoint, or NULL if the number is out of range
+ */
+static sim_usbd_ep_t *simUsbdEp(uint8_t epAddr)
+{
+	uint8_t num = epAddr & 0x7FU;
+
+	if (num >= simusbdMAX_EPS)
+	{
+		return NULL;
+	}
+	return (epAddr & 0x80U) ? &inEps[num] : &outEps[num];
+}
+
+/**
+ * @brief Endpoint state, for the host side
+ * @param epAddr Endpoint address, bit 7 set for IN
+ * @retval Endpoint, or NULL if the number is out of range
+ */
+sim_usbd_ep_t *simUsbdGetEp(uint8_t epAddr)
+{
+	return simUsbdEp(epAddr);
+}
+
+/**
+ * @brief Whether the device has its pull-up on
+ * @param none
+ * @retval 1 between USBD_LL_Start() and USBD_LL_Stop()
+ */
+_Bool simUsbdConnected(void)
+{
+	return connected;
+}
+
+/**
+ * @brief Address the device was given
+ * @param none
+ * @retval Device address, 0 until SET_ADDRESS
+ */
+uint8_t simUsbdAddress(void)
+{
+	return address;
+}
+
+/**
+ * @brief Drops every endpoint, as a bus reset does
+ * @param none
+ * @retval none
+ */
+void simUsbdReset(void)
+{
+	memset(inEps, 0, sizeof(inEps));
+	memset(outEps, 0, sizeof(outEps));
+	address = 0;
+}
+
+/**
+ * @brief Links the driver to the stack
+ * @param pdev Device handle
+ * @retval USBD status
+ */
+USBD_StatusTypeDef USBD_LL_Init(USBD_HandleTypeDef *pdev)
+{
+	pdev->pData = inEps;
+	simUsbdReset();
+	return USBD_OK;
+}
+
+/**
+ * @brief Unlinks the driver
+ * @param pdev Device handle
+ * @retval USBD status
+ */
+USBD_StatusTypeDef USBD_LL_DeInit(USBD_HandleTypeDef *pdev)
+{
+	pdev->pData = NULL;
+	connected = 0;
+	return USBD_OK;
+}
+
+/**
+ * @brief Connects to the bus
+ * @param pdev Device handle
+ * @retval USBD status
+ */
+USBD_StatusTypeDef USBD_LL_Start(USBD_HandleTypeDef *pdev)
+{
+	UNUSED(pdev);
+	connected = 1;
+	return USBD_OK;
+}
+
+/**
+ * @brief Disconnects from the bus
+ * @param pdev Device handle
+ * @retval USBD status
+ */
+USBD_StatusTypeDef USBD_LL_Stop(USBD_HandleTypeDef *pdev)
+{
+	UNUSED(pdev);
+	connected = 0;
+	return USBD_OK;
+}
+
+/**
+ * @brief Opens an endpoint
+ * @param pdev Device handle
+ * @param ep_addr Endpoint address
+ * @param ep_type Endpoint type
+ * @param ep_mps Max packet size
+ * @retval USBD status
+ */
+USBD_StatusTypeDef USBD_LL_OpenEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr,
+		uint8_t ep_type, uint16_t ep_mps)
+{
+	sim_usbd_ep_t *ep = simUsbdEp(ep_addr);
+
+	UNUSED(pdev);
+	if (ep == NULL)
+	{
+		return USBD_FAIL;
+	}
+	*ep = (sim_usbd_ep_t) {
+		.open = 1,
+				.type = ep_type,
+				.mps = ep_mps
+	};
+	return USBD_OK;
+}
+
+/**
+ * @brief Closes an endpoint, dropping anything armed on it
+ * @param pdev Device handle
+ * @param ep_addr Endpoint address
+ * @retval USBD status
+ */
+USBD_StatusTypeDef USBD_LL_CloseEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr)
+{
+	sim_usbd_ep_t *ep = simUsbdEp(ep_addr);
+
+	UNUSED(pdev);
+	if (ep == NULL)
+	{
+		return USBD_FAIL;
+	}
+	ep->open = 0;
+	ep->armed = 0;
+	return USBD_OK;
+}
+
+/**
+ * @brief Drops anything armed on an endpoint
+ * @param pdev Device handle
+ * @param ep_addr Endpoint address
+ * @retval USBD status
+ */
+USBD_StatusTypeDef USBD_LL_FlushEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr)
+{
+	sim_usbd_ep_t *ep = simUsbdEp(ep_addr);
+
+	UNUSED(pdev);
+	if (ep == NULL)
+	{
+		return USBD_FAIL;
+	}
+	ep->armed = 0;
+	return USBD_OK;
+}
+
+/**
+ * @brief Stalls an endpoint
+ * @param pdev Device handle
+ * @param ep_addr Endpoint address
+ * @retval USBD status
+ */
+USBD_StatusTypeDef USBD_LL_StallEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr)
+{
+	sim_usbd_ep_t *ep = simUsbdEp(ep_addr);
+
+	UNUSED(pdev);
+	if (ep == NULL)
+	{
+		return USBD_FAIL;
+	}
+	ep->stalled = 1;
+	return USBD_OK;
+}
+
+/**
+ * @brief Clears an endpoint stall
+ * @param pdev Device handle
+ * @param ep_addr Endpoint address
+ * @retval USBD status
+ */
+USBD_StatusTypeDef USBD_LL_ClearStallEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr)
+{
+	sim_usbd_ep_t *ep = simUsbdEp(ep_addr);
+
+	UNUSED(pdev);
+	if (ep == NULL)
+	{
+		return USBD_FAIL;
+	}
+	ep->stalled = 0;
+	return USBD_OK;
+}
+
+/**
+ * @brief Returns the stall condition
+ * @param pdev Device handle
+ * @param ep_addr Endpoint address
+ * @retval 1 if stalled
+ */
+uint8_t USBD_LL_IsStallEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr)
+{
+	sim_usbd_ep_t *ep = simUsbdEp(ep_addr);
+
+	UNUSED(pdev);
+	return (ep != NULL) && ep->stalled;
+}
+
+/**
+ * @brief Takes the address the host assigned
+ * @param pdev Device handle
+ * @param dev_addr Device address
+ * @retval USBD status
+ */
+USBD_StatusTypeDef USBD_LL_SetUSBAddress(USBD_HandleTypeDef *pdev, uint8_t dev_addr)
+{
+	UNUSED(pdev);
+	address = dev_addr;
+	return USBD_OK;
+}
+
+/**
+ * @brief Arms an IN endpoint
+ * @note Always IN, whatever bit 7 says: the control request code transmits
+ *       on EP0 as 0x00, as the PCD driver allows. The buffer is not copied.
+ * @param pdev Device handle
+ * @param ep_addr Endpoint address
+ * @param pbuf Data to send
+ * @param size Data length
+ * @retval USBD status
+ */
+USBD_StatusTypeDef USBD_LL_Transmit(USBD_HandleTypeDef *pdev, uint8_t ep_addr,
+		uint8_t *pbuf, uint16_t size)
+{
+	sim_usbd_ep_t *ep = simUsbdEp(ep_addr | 0x80U);
+
+	UNUSED(pdev);
+	if (ep == NULL || !ep->open)
+	{
+		return USBD_FAIL;
+	}
+	ep->buf = pbuf;
+	ep->length = size;
+	ep->count = 0;
+	ep->armed = 1;
+	return USBD_OK;
+}
+
+/**
+ * @brief Arms an OUT endpoint
+ * @param pdev Device handle
+ * @param ep_addr Endpoint address
+ * @param pbuf Where to put the data
+ * @param size Space at pbuf
+ * @retval USBD status
+ */
+USBD_StatusTypeDef USBD_LL_PrepareReceive(USBD_HandleTypeDef *pdev, uint8_t ep_addr,
+		uint8_t *pbuf, uint16_t size)
+{
+	sim_usbd_ep_t *ep = simUsbdEp(ep_addr & 0x7FU);
+
+	UNUSED(pdev);
+	if (ep == NULL || !ep->open)
+	{
+		return USBD_FAIL;
+	}
+	ep->buf = pbuf;
+	ep->length = size;
+	ep->count = 0;
+	ep->armed = 1;
+	return USBD_OK;
+}
+
+/**
+ * @brief Size of the last OUT packet
+ * @param pdev Device handle
+ * @param ep_addr Endpoint address
+ * @retval Bytes received
+ */
+uint32_t USBD_LL_GetRxDataSize(USBD_HandleTypeDef *pdev, uint8_t ep_addr)
+{
+	sim_usbd_ep_t *ep = simUsbdEp(ep_addr);
+
+	UNUSED(pdev);
+	return (ep != NULL) ? ep->count : 0;
+}
+
+/**
+ * @brief Frame number, as usbd_conf.c reads it from the core
+ * @note The host starts a frame every ms of the tick, see sim_host.c.
+ * @param pdev UNUSED
+ * @retval Frame number, 11 bits
+ */
+uint32_t USBD_LL_GetFrameNumber(USBD_HandleTypeDef *pdev)
+{
+	UNUSED(pdev);
+	return (uint32_t)(simClockNowUs() / 1000U) & 0x7FFU;
+}
+
+/**
+ * @brief Delay for the library
+ * @param Delay Milliseconds
+ * @retval none
+ */
+void USBD_LL_Delay(uint32_t Delay)
+{
+	HAL_Delay(Delay);
+}
+
+/**
+ * @brief Static single allocation, as usbd_conf.c has it
+ * @param size Size of allocated memory
+ * @retval Pointer to the block, or NULL if it is too small
+ */
+void *USBD_static_malloc(uint32_t size)
+{
+	static uint32_t mem[(sizeof(USBD_HID_HandleTypeDef) / 4) + 1];
+
+	if (size > sizeof(mem))
+	{
+		return NULL;
+	}
+	return mem;
+}
+
+/**
+ * @brief Dummy memory free
+ * @param p Pointer to allocated memory
+ * @retval none
+ */
+void USBD_static_free(void *p)
+{
+	UNUSED(p);
+}
+/* EOF */
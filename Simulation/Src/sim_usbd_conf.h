@@ -0,0 +1,50 @@
+/*******************************************************************************
+ * @copyright This is where we'd put a copyright... IF WE HAD ONE
+ * @file sim_usbd_conf.h
+ * @author paul.czeresko
+ * @date 19 Oct 2026
+ * @brief Definitions and prototypes for the simulated USB device controller
+ ******************************************************************************/
+// @formatter:off
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __SIM_USBD_CONF_H
+#define __SIM_USBD_CONF_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Defines -------------------------------------------------------------------*/
+#define simusbdMAX_EPS				( 4 )	/* As dev_endpoints in usbd_conf.c */
+
+/* Structures ----------------------------------------------------------------*/
+typedef struct _SIM_USBD_EP_S_
+{
+	uint8_t *buf;			/* Armed transfer, advanced packet by packet */
+	uint16_t length;		/* Bytes left to move */
+	uint16_t count;			/* Bytes in the last OUT packet */
+	uint16_t mps;			/* Max packet size */
+	uint8_t type;			/* USBD_EP_TYPE_x */
+	_Bool open;
+	_Bool armed;			/* Will answer the next token with data */
+	_Bool stalled;			/* Will answer the next token with STALL */
+} sim_usbd_ep_t;
+
+/* Prototypes ----------------------------------------------------------------*/
+sim_usbd_ep_t *simUsbdGetEp(uint8_t epAddr);
+_Bool simUsbdConnected(void);
+uint8_t simUsbdAddress(void);
+void simUsbdReset(void);
+
+/* Exported variables --------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SIM_USBD_CONF_H */
+/* EOF */
@@ -0,0 +1,90 @@
+#!/usr/bin/env python3
+"""
+Reads the microbenchmark results from Core/Src/Bench/bench.c.
+
+The input is a raw image of the benchResults struct. Grab one with GDB:
+
+    (gdb) dump binary value bench.bin benchResults
+    python3 Tools/bench_read.py bench.bin
+
+or straight from a keyboard running the benchmark build, over HID feature
+report 5 (needs the hidapi Python package):
+
+    python3 Tools/bench_read.py --usb
+"""
+
+import argparse
+import struct
+import sys
+
+HEADER = struct.Struct("<BBHIII")
+CASE = struct.Struct("<8sHHIII")
+MAX_CASES = 6
+
+USB_VID = 1155
+USB_PID = 22315
+BENCH_REPORT_ID = 5
+BENCH_REPORT_SIZE = HEADER.size + MAX_CASES * CASE.size
+
+
+def parse(image):
+    if len(image) < BENCH_REPORT_SIZE:
+        raise ValueError("results image is {} bytes, expected {}".format(
+            len(image), BENCH_REPORT_SIZE))
+    report_id, num_cases, overhead, cpu_hz, runs, uptime = HEADER.unpack_from(image, 0)
+    if report_id != BENCH_REPORT_ID or num_cases > MAX_CASES:
+        raise ValueError("not a benchmark results image")
+    cases = []
+    for ii in range(num_cases):
+        name, reps, warmup, lo, median, hi = CASE.unpack_from(image, HEADER.size + ii * CASE.size)
+        cases.append((name.split(b"\0")[0].decode("ascii", "replace"), reps, warmup, lo, median, hi))
+    header = dict(overhead=overhead, cpu_hz=cpu_hz, runs=runs, uptime=uptime)
+    return header, cases
+
+
+def usb_read(args):
+    import hid
+    dev = hid.device()
+    dev.open(args.vid, args.pid)
+    try:
+        return bytes(dev.get_feature_report(BENCH_REPORT_ID, BENCH_REPORT_SIZE))
+    finally:
+        dev.close()
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("image", nargs="?", help="raw benchResults image")
+    ap.add_argument("--usb", action="store_true", help="read the results over USB HID")
+    ap.add_argument("--vid", type=int, default=USB_VID)
+    ap.add_argument("--pid", type=int, default=USB_PID)
+    args = ap.parse_args()
+
+    if args.usb:
+        image = usb_read(args)
+    elif args.image:
+        with open(args.image, "rb") as f:
+            image = f.read()
+    else:
+        ap.error("give an image file or --usb")
+
+    header, cases = parse(image)
+    if not cases:
+        print("no results: not the benchmark build, or the run has not finished")
+        return 1
+    us = 1e6 / header["cpu_hz"]
+    print("run {} at {} ms, {} Hz, {} cycles of timer overhead taken off".format(
+        header["runs"], header["uptime"], header["cpu_hz"], header["overhead"]))
+    print("\n{:<10}{:>6}{:>12}{:>12}{:>12}{:>12}".format(
+        "case", "reps", "min", "median", "max", "median us"))
+    for name, reps, _, lo, median, hi in cases:
+        if not reps:
+            print("{:<10}{:>6}  did not run".format(name, reps))
+            continue
+        print("{:<10}{:>6}{:>12}{:>12}{:>12}{:>12.2f}".format(name, reps, lo, median, hi, median * us))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,135 @@
+#!/usr/bin/env python3
+"""
+Per-key switch health from the counters in Core/Src/Keyboard/health.c.
+
+The input is a raw image of the healthCounters struct. Grab one with GDB:
+
+    (gdb) dump binary value health.bin healthCounters
+    python3 Tools/health_read.py health.bin
+
+or straight from the keyboard over HID feature report 6 (needs the hidapi
+Python package). --clear zeroes the counters after reading:
+
+    python3 Tools/health_read.py --usb --clear
+
+Keys are listed worst first, by chatter per press. A switch that chatters
+much more than its neighbours is on its way out; the press duration
+histogram shows how short a deliberate press on this board gets, which is
+the ceiling for the debounce time.
+"""
+
+import argparse
+import struct
+import sys
+
+MAGIC = 0x31544C48
+HEADER = struct.Struct("<IHBBBBHI")
+
+USB_VID = 1155
+USB_PID = 22315
+HEALTH_REPORT_ID = 6
+HEALTH_REPORT_SIZE = 64
+CMD_REWIND, CMD_CLEAR = range(2)
+
+
+def parse(image):
+    magic, version, rows, cols, bins, bin0, _, cleared = HEADER.unpack_from(image, 0)
+    if magic != MAGIC:
+        raise ValueError("not a health counters image (magic 0x{:08x})".format(magic))
+    keys = rows * cols
+    off = HEADER.size
+    presses = struct.unpack_from("<{}H".format(keys), image, off)
+    off += 2 * keys
+    chatter = struct.unpack_from("<{}H".format(keys), image, off)
+    off += 2 * keys
+    durations = [image[off + k * bins:off + (k + 1) * bins] for k in range(keys)]
+    header = dict(version=version, rows=rows, cols=cols, bins=bins, bin0=bin0,
+                  cleared=cleared, size=off + keys * bins)
+    return header, presses, chatter, durations
+
+
+def image_size(image):
+    _, _, rows, cols, bins, _, _, _ = HEADER.unpack_from(image, 0)
+    return HEADER.size + rows * cols * (4 + bins)
+
+
+def usb_command(dev, cmd):
+    report = struct.pack("<BBxx", HEALTH_REPORT_ID, cmd)
+    dev.send_feature_report(report.ljust(HEALTH_REPORT_SIZE, b"\0"))
+
+
+def usb_read(args):
+    import hid
+    dev = hid.device()
+    dev.open(args.vid, args.pid)
+    try:
+        usb_command(dev, CMD_REWIND)
+        image = bytearray()
+        size = None
+        while size is None or len(image) < size:
+            chunk = bytes(dev.get_feature_report(HEALTH_REPORT_ID, HEALTH_REPORT_SIZE))
+            _, length, offset = struct.unpack_from("<BBH", chunk, 0)
+            if offset != len(image) or length == 0:
+                raise IOError("health read out of step at offset {}".format(offset))
+            image += chunk[4:4 + length]
+            if size is None and len(image) >= HEADER.size:
+                size = image_size(image)
+        if args.clear:
+            usb_command(dev, CMD_CLEAR)
+        return bytes(image[:size])
+    finally:
+        dev.close()
+
+
+def bin_label(index, bin0, bins):
+    if index == 0:
+        return "<{}".format(1 << bin0)
+    if index == bins - 1:
+        return ">={}".format(1 << (bin0 + index - 1))
+    return "{}-{}".format(1 << (bin0 + index - 1), (1 << (bin0 + index)) - 1)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("image", nargs="?", help="raw healthCounters image")
+    ap.add_argument("--usb", action="store_true", help="read the counters over USB HID")
+    ap.add_argument("--vid", type=int, default=USB_VID)
+    ap.add_argument("--pid", type=int, default=USB_PID)
+    ap.add_argument("--clear", action="store_true",
+                    help="with --usb, zero the counters after reading")
+    ap.add_argument("--save", help="with --usb, also write the raw image here")
+    ap.add_argument("--top", type=int, default=20, help="keys to list (default 20)")
+    args = ap.parse_args()
+
+    if args.usb:
+        image = usb_read(args)
+        if args.save:
+            with open(args.save, "wb") as f:
+                f.write(image)
+    elif args.image:
+        with open(args.image, "rb") as f:
+            image = f.read()
+    else:
+        ap.error("give an image file or --usb")
+
+    header, presses, chatter, durations = parse(image)
+    cols, bins, bin0 = header["cols"], header["bins"], header["bin0"]
+    print("{} presses, {} chatter on {} keys since {} ms".format(
+        sum(presses), sum(chatter), sum(1 for c in chatter if c), header["cleared"]))
+
+    used = [k for k in range(len(presses)) if presses[k] or chatter[k]]
+    used.sort(key=lambda k: (chatter[k] / max(presses[k], 1), chatter[k]), reverse=True)
+    print("\n{:<8}{:>8}{:>8}{:>10}  press ms: {}".format(
+        "key", "presses", "chatter", "per 100", " ".join(
+            "{:>9}".format(bin_label(b, bin0, bins)) for b in range(bins))))
+    for k in used[:args.top]:
+        print("r{}c{:<5}{:>8}{:>8}{:>10.1f}            {}".format(
+            k // cols, k % cols, presses[k], chatter[k],
+            100.0 * chatter[k] / max(presses[k], 1),
+            " ".join("{:>9}".format(n) for n in durations[k])))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
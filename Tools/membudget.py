@@ -0,0 +1,127 @@
+#!/usr/bin/env python3
+"""
+Per-subsystem memory budget from a GNU ld map file.
+
+Run as a post-build step (see .cproject) or by hand:
+
+    python3 Tools/membudget.py Debug/IBM_Model_M_1394100_Retrofit.map
+
+Every RTOS object and the USB class data are statically allocated, so task
+stacks show up as ordinary .bss input sections. Any section whose name
+contains "Stack" is counted as stack; the newlib heap and the main (MSP)
+stack come from _Min_Heap_Size and _Min_Stack_Size in the linker script.
+"""
+
+import argparse
+import re
+import sys
+
+# Application modules under Core/Src/<Module>/ are named after their directory;
+# everything else maps by object path fragment, first match wins
+MODULE_RE = re.compile(r"Core/Src/(\w+)/")
+SUBSYSTEMS = (
+    ("Core/Src/", "core"),
+    ("Core/Startup/", "core"),
+    ("Middlewares/Third_Party/FreeRTOS/", "freertos"),
+    ("Middlewares/ST/STM32_USB_Device_Library/", "usb_stack"),
+    ("USB_DEVICE/", "usb_stack"),
+    ("Drivers/", "hal"),
+)
+
+RAM_SIZE = 96 * 1024
+FLASH_SIZE = 512 * 1024
+
+SECTION_RE = re.compile(r"^ (\.[\w.$]+)\s*$")
+ENTRY_RE = re.compile(r"^ (\.[\w.$]+)?\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)\s+(\S.*)$")
+SYMBOL_RE = re.compile(r"^\s+0x([0-9a-f]+)\s+(_Min_(?:Heap|Stack)_Size)\s*=")
+
+
+def subsystem(obj):
+    obj = obj.replace("\\", "/")
+    m = MODULE_RE.search(obj)
+    if m:
+        return m.group(1).lower()
+    for frag, name in SUBSYSTEMS:
+        if frag in obj:
+            return name
+    return "libc"
+
+
+def parse(path):
+    usage = {}
+    symbols = {}
+    pending = None
+    in_memory_map = False
+    with open(path) as f:
+        for line in f:
+            if line.startswith("Linker script and memory map"):
+                in_memory_map = True
+                continue
+            if not in_memory_map:
+                continue
+            m = SYMBOL_RE.match(line)
+            if m:
+                symbols[m.group(2)] = int(m.group(1), 16)
+                continue
+            m = SECTION_RE.match(line)
+            if m:
+                pending = m.group(1)
+                continue
+            m = ENTRY_RE.match(line)
+            if not m:
+                pending = None
+                continue
+            section = m.group(1) or pending
+            pending = None
+            addr, size, obj = int(m.group(2), 16), int(m.group(3), 16), m.group(4)
+            if section is None or size == 0 or addr == 0:
+                continue
+            u = usage.setdefault(subsystem(obj), {"flash": 0, "static": 0, "stack": 0})
+            if section.startswith((".text", ".rodata", ".isr_vector", ".ARM")):
+                u["flash"] += size
+            elif section.startswith(".data"):
+                u["flash"] += size
+                u["static"] += size
+            elif section.startswith((".bss", "COMMON")):
+                if "stack" in section.lower():
+                    u["stack"] += size
+                else:
+                    u["static"] += size
+    return usage, symbols
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("map", help="linker map file")
+    ap.add_argument("--ram-budget", type=int, default=RAM_SIZE,
+                    help="fail if total RAM use exceeds this many bytes")
+    args = ap.parse_args()
+
+    usage, symbols = parse(args.map)
+    heap = symbols.get("_Min_Heap_Size", 0)
+    msp = symbols.get("_Min_Stack_Size", 0)
+
+    fmt = "{:<12}{:>10}{:>10}{:>10}{:>10}"
+    print(fmt.format("subsystem", "flash", "static", "stacks", "ram"))
+    total = {"flash": 0, "static": 0, "stack": 0}
+    for name in sorted(usage, key=lambda n: -(usage[n]["static"] + usage[n]["stack"])):
+        u = usage[name]
+        print(fmt.format(name, u["flash"], u["static"], u["stack"], u["static"] + u["stack"]))
+        for k in total:
+            total[k] += u[k]
+    print(fmt.format("heap", "", "", "", heap))
+    print(fmt.format("msp", "", "", msp, msp))
+    ram = total["static"] + total["stack"] + heap + msp
+    print(fmt.format("total", total["flash"], total["static"], total["stack"] + msp, ram))
+    print("RAM {:.1f}% of {}, flash {:.1f}% of {}".format(
+        100.0 * ram / RAM_SIZE, RAM_SIZE, 100.0 * total["flash"] / FLASH_SIZE, FLASH_SIZE))
+
+    if ram > args.ram_budget:
+        print("error: RAM use {} exceeds budget {}".format(ram, args.ram_budget), file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,167 @@
+#!/usr/bin/env python3
+"""
+Writes settings into the keyboard's flash log, Core/Src/Settings/settings.c,
+over HID feature report 7 (needs the hidapi Python package).
+
+    python3 Tools/settings_write.py keymap 1 colemak.keymap --select
+    python3 Tools/settings_write.py select 0
+    python3 Tools/settings_write.py debounce 8
+    python3 Tools/settings_write.py combos chords.combo
+    python3 Tools/settings_write.py status
+
+A keymap file holds 16 bit actions (see Core/Src/Keyboard/keymap.h) as hex or
+decimal numbers separated by white space, # starts a comment. Each layer is
+one action per key, row by row, 8 rows of 20; layers follow one another.
+
+A combo file has one combo per line: its action, its window in ms (0 for the
+default), then the row and column of each of its 2 to 4 keys. An empty file
+removes them all.
+
+Records are staged in RAM and programmed in the background, so a keymap
+written and selected takes effect on the next key press. The debounce time
+and the combos are read at boot.
+"""
+
+import argparse
+import struct
+import sys
+import time
+
+USB_VID = 1155
+USB_PID = 22315
+SETTINGS_REPORT_ID = 7
+SETTINGS_REPORT_SIZE = 64
+CMD_WRITE, CMD_SELECT = range(2)
+
+COMMAND = struct.Struct("<BBHHHB3x")
+STATUS = struct.Struct("<BBBBH")
+PIECE = SETTINGS_REPORT_SIZE - COMMAND.size
+
+NUM_ROWS, NUM_COLS = 8, 20
+NUM_KEYS = NUM_ROWS * NUM_COLS
+MAX_LAYERS = 16
+MAX_PROFILES = 8
+MAX_COMBOS = 16
+COMBO_KEYS = 4
+KEY_DEBOUNCE = 1
+KEY_COMBOS = 5
+KEY_KEYMAP = 16
+
+COMBO = struct.Struct("<4BBBH")  # combo_def_t
+
+
+def load_keymap(path):
+    actions = []
+    with open(path) as f:
+        for line in f:
+            actions += [int(word, 0) for word in line.split("#")[0].split()]
+    layers, extra = divmod(len(actions), NUM_KEYS)
+    if extra or not 1 <= layers <= MAX_LAYERS:
+        raise ValueError("{}: {} actions, expected 1 to {} layers of {}".format(
+            path, len(actions), MAX_LAYERS, NUM_KEYS))
+    if any(not 0 <= act <= 0xFFFF for act in actions):
+        raise ValueError("{}: actions are 16 bit".format(path))
+    return struct.pack("<HH{}H".format(len(actions)), layers, NUM_KEYS, *actions)
+
+
+def load_combos(path):
+    combos = []
+    with open(path) as f:
+        for number, line in enumerate(f, 1):
+            words = [int(word, 0) for word in line.split("#")[0].split()]
+            if not words:
+                continue
+            action, window, places = words[0], words[1:2], words[2:]
+            if (not window or len(places) % 2 or not 2 <= len(places) // 2 <= COMBO_KEYS
+                    or not 0 <= action <= 0xFFFF or not 0 <= window[0] <= 0xFF
+                    or any(not 0 <= r < NUM_ROWS for r in places[0::2])
+                    or any(not 0 <= c < NUM_COLS for c in places[1::2])):
+                raise ValueError("{}:{}: expected action, window and 2 to {} row column "
+                                 "pairs".format(path, number, COMBO_KEYS))
+            keys = [r * NUM_COLS + c for r, c in zip(places[0::2], places[1::2])]
+            combos.append(COMBO.pack(*(keys + [0] * (COMBO_KEYS - len(keys))),
+                                     len(keys), window[0], action))
+    if len(combos) > MAX_COMBOS:
+        raise ValueError("{}: {} combos, at most {}".format(path, len(combos), MAX_COMBOS))
+    return b"".join(combos)
+
+
+def status(dev):
+    report = bytes(dev.get_feature_report(SETTINGS_REPORT_ID, SETTINGS_REPORT_SIZE))
+    _, ok, profile, pending, used = STATUS.unpack_from(report, 0)
+    return dict(ok=bool(ok), profile=None if profile == 0xFF else profile,
+                pending=pending, used=used)
+
+
+def command(dev, cmd, key, offset=0, total=0, data=b""):
+    report = COMMAND.pack(SETTINGS_REPORT_ID, cmd, key, offset, total, len(data)) + data
+    dev.send_feature_report(report.ljust(SETTINGS_REPORT_SIZE, b"\0"))
+    if not status(dev)["ok"]:
+        raise IOError("keyboard refused the command (key {}, offset {})".format(key, offset))
+
+
+def write(dev, key, payload):
+    for offset in range(0, max(len(payload), 1), PIECE):
+        command(dev, CMD_WRITE, key, offset, len(payload), payload[offset:offset + PIECE])
+
+
+def settle(dev, timeout=2.0):
+    # Programming a keymap takes a few ms, an erase up to a few hundred
+    deadline = time.monotonic() + timeout
+    while status(dev)["pending"] and time.monotonic() < deadline:
+        time.sleep(0.05)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--vid", type=int, default=USB_VID)
+    ap.add_argument("--pid", type=int, default=USB_PID)
+    sub = ap.add_subparsers(dest="what", required=True)
+    km = sub.add_parser("keymap", help="store a keymap as a profile")
+    km.add_argument("profile", type=int, choices=range(MAX_PROFILES))
+    km.add_argument("file")
+    km.add_argument("--select", action="store_true", help="switch to it once stored")
+    sel = sub.add_parser("select", help="switch to a stored profile")
+    sel.add_argument("profile", type=int, choices=range(MAX_PROFILES))
+    deb = sub.add_parser("debounce", help="debounce time used from the next boot")
+    deb.add_argument("ms", type=int)
+    cmb = sub.add_parser("combos", help="combos used from the next boot")
+    cmb.add_argument("file")
+    sub.add_parser("status", help="show the active profile and how full the log is")
+    args = ap.parse_args()
+
+    payload = None
+    if args.what == "keymap":
+        payload = load_keymap(args.file)
+    elif args.what == "combos":
+        payload = load_combos(args.file)
+
+    import hid
+    dev = hid.device()
+    dev.open(args.vid, args.pid)
+    try:
+        if args.what == "keymap":
+            write(dev, KEY_KEYMAP + args.profile, payload)
+            settle(dev)
+            if args.select:
+                command(dev, CMD_SELECT, args.profile)
+        elif args.what == "select":
+            command(dev, CMD_SELECT, args.profile)
+        elif args.what == "debounce":
+            write(dev, KEY_DEBOUNCE, struct.pack("<H", args.ms))
+        elif args.what == "combos":
+            write(dev, KEY_COMBOS, payload)
+        settle(dev)
+        st = status(dev)
+    finally:
+        dev.close()
+
+    print("profile {}, {} of 16384 bytes of the log in use{}".format(
+        "built-in" if st["profile"] is None else st["profile"], st["used"],
+        ", {} records still to program".format(st["pending"]) if st["pending"] else ""))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,123 @@
+#!/usr/bin/env python3
+"""
+Reads the telemetry snapshot from Core/Src/Telemetry/telemetry.c.
+
+The input is a raw image of the published snapshot. Grab one with GDB:
+
+    (gdb) dump binary value telemetry.bin published
+    python3 Tools/telemetry_read.py telemetry.bin
+
+or straight from the keyboard over HID feature report 3 (needs the hidapi
+Python package):
+
+    python3 Tools/telemetry_read.py --usb
+
+The snapshot is refreshed once a second while the host has the keyboard
+configured.
+"""
+
+import argparse
+import struct
+import sys
+
+HEADER = struct.Struct("<BBHIIHHHH")
+TASK = struct.Struct("<8sHHI")
+MAX_TASKS = 8
+POWER = struct.Struct("<6I")
+GOVERNOR_LEVELS = 5
+GOVERNOR_FRAME_MS = (1, 2, 4, 8, 16)
+GOVERNOR = struct.Struct("<BxHI{0}I{0}II".format(GOVERNOR_LEVELS))
+
+USB_VID = 1155
+USB_PID = 22315
+TELEMETRY_REPORT_ID = 3
+TELEMETRY_REPORT_SIZE = HEADER.size + MAX_TASKS * TASK.size + POWER.size + GOVERNOR.size
+
+
+def parse(image):
+    if len(image) < TELEMETRY_REPORT_SIZE:
+        raise ValueError("snapshot image is {} bytes, expected {}".format(
+            len(image), TELEMETRY_REPORT_SIZE))
+    (report_id, num_tasks, window, uptime, sent, per_sec, drops, poll,
+     _) = HEADER.unpack_from(image, 0)
+    if report_id != TELEMETRY_REPORT_ID or num_tasks > MAX_TASKS:
+        raise ValueError("not a telemetry snapshot")
+    header = dict(window=window, uptime=uptime, sent=sent, per_sec=per_sec,
+                  drops=drops, poll=poll)
+    tasks = []
+    for ii in range(num_tasks):
+        name, permille, stack_free, max_run = TASK.unpack_from(image, HEADER.size + ii * TASK.size)
+        tasks.append((name.split(b"\0")[0].decode("ascii", "replace"), permille, stack_free, max_run))
+    at = HEADER.size + MAX_TASKS * TASK.size
+    power = dict(zip(("sleeps", "aborts", "requested", "slept", "early", "since"),
+                     POWER.unpack_from(image, at)))
+    at += POWER.size
+    fields = GOVERNOR.unpack_from(image, at)
+    governor = dict(level=fields[0], active=fields[1], transitions=fields[2],
+                    ms_at=fields[3:3 + GOVERNOR_LEVELS],
+                    wakes=fields[3 + GOVERNOR_LEVELS:3 + 2 * GOVERNOR_LEVELS],
+                    since=fields[-1])
+    return header, tasks, power, governor
+
+
+def usb_read(args):
+    import hid
+    dev = hid.device()
+    dev.open(args.vid, args.pid)
+    try:
+        return bytes(dev.get_feature_report(TELEMETRY_REPORT_ID, TELEMETRY_REPORT_SIZE))
+    finally:
+        dev.close()
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("image", nargs="?", help="raw telemetry snapshot image")
+    ap.add_argument("--usb", action="store_true", help="read the snapshot over USB HID")
+    ap.add_argument("--vid", type=int, default=USB_VID)
+    ap.add_argument("--pid", type=int, default=USB_PID)
+    args = ap.parse_args()
+
+    if args.usb:
+        image = usb_read(args)
+    elif args.image:
+        with open(args.image, "rb") as f:
+            image = f.read()
+    else:
+        ap.error("give an image file or --usb")
+
+    header, tasks, power, governor = parse(image)
+    print("at {} ms: {} reports sent, {} per second, {} changes dropped, host polls {}".format(
+        header["uptime"], header["sent"], header["per_sec"], header["drops"],
+        "every {} ms".format(header["poll"]) if header["poll"] else "at an unknown rate"))
+
+    print("\n{:<10}{:>8}{:>12}{:>12}".format("task", "cpu %", "stack free", "max run us"))
+    for name, permille, stack_free, max_run in tasks:
+        print("{:<10}{:>8.1f}{:>12}{:>12}".format(name, permille / 10.0, stack_free, max_run))
+    if not header["window"]:
+        print("(no CPU window yet)")
+
+    window = header["uptime"] - power["since"]
+    print("\nsleep: {} sleeps, {} aborted, {} ended early by another interrupt".format(
+        power["sleeps"], power["aborts"], power["early"]))
+    print("sleep: {} of {} ticks offered slept, {:.1f}% of the last {} ms".format(
+        power["slept"], power["requested"],
+        100.0 * power["slept"] / window if window else 0.0, window))
+
+    window = header["uptime"] - governor["since"]
+    if not governor["active"]:
+        print("\nscan rate: governor off, full rate throughout")
+        return 0
+    print("\nscan rate: level {} now, {} changes, full rate for {} ms after activity".format(
+        governor["level"], governor["transitions"], governor["active"]))
+    print("{:<8}{:>10}{:>12}{:>8}".format("level", "frame ms", "time ms", "wakes"))
+    for level in range(GOVERNOR_LEVELS):
+        print("{:<8}{:>10}{:>12}{:>8}".format(level, GOVERNOR_FRAME_MS[level],
+                                              governor["ms_at"][level], governor["wakes"][level]))
+    print("over the last {} ms".format(window))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
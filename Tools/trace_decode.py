@@ -0,0 +1,211 @@
+#!/usr/bin/env python3
+"""
+Timeline decoder for the event recorder in Core/Src/Trace/trace.c.
+
+The input is a raw image of the traceRecorder struct. Grab one with GDB:
+
+    (gdb) dump binary value trace.bin traceRecorder
+    python3 Tools/trace_decode.py trace.bin
+
+or straight from the keyboard over HID feature report 4 (needs the hidapi
+Python package). This freezes the recorder, reads it out and restarts it:
+
+    python3 Tools/trace_decode.py --usb --restart
+
+--threshold-us arms the recorder to freeze itself on the next key edge whose
+report takes longer than that to reach the host.
+"""
+
+import argparse
+import struct
+import sys
+
+MAGIC = 0x31435254
+HEADER = struct.Struct("<IHHIIBBHII")
+EVENT = struct.Struct("<IBBH")
+NAME_LEN = 8
+MAX_TASKS = 8
+
+USB_VID = 1155
+USB_PID = 22315
+TRACE_REPORT_ID = 4
+TRACE_REPORT_SIZE = 64
+CMD_RESTART, CMD_FREEZE, CMD_THRESHOLD, CMD_REWIND = range(4)
+
+EVENTS = {
+    1: "TASK_IN", 2: "TASK_OUT", 3: "ISR_ENTER", 4: "ISR_EXIT", 5: "TICK",
+    6: "NOTIFY", 7: "NOTIFY_ISR", 8: "NOTIFY_BLOCK", 9: "NOTIFY_TAKEN",
+    10: "QUEUE_SEND", 11: "QUEUE_RECEIVE", 12: "EVENT_BITS", 13: "KEY_EDGE",
+    14: "REPORT_QUEUED", 15: "REPORT_SENT", 16: "TRIGGER", 17: "SCAN_RATE",
+}
+TASK_EVENTS = {1, 2, 6, 7, 8, 9, 10, 11, 12}
+
+# Exception numbers as read from IPSR
+EXCEPTIONS = {11: "SVCall", 14: "PendSV", 15: "SysTick", 16 + 50: "TIM5", 16 + 67: "OTG_FS"}
+FROZEN = {0: "recording", 1: "frozen by request", 2: "frozen on latency trigger"}
+
+
+def parse(image):
+    (magic, version, capacity, cpu_hz, head, frozen, _, post, worst, threshold) = \
+        HEADER.unpack_from(image, 0)
+    if magic != MAGIC:
+        raise ValueError("not a trace recorder image (magic 0x{:08x})".format(magic))
+    off = HEADER.size
+    names = []
+    for _ in range(MAX_TASKS):
+        names.append(image[off:off + NAME_LEN].split(b"\0")[0].decode("ascii", "replace"))
+        off += NAME_LEN
+    raw = [EVENT.unpack_from(image, off + i * EVENT.size) for i in range(capacity)]
+    if head <= capacity:
+        ordered = raw[:head]
+    else:
+        start = head % capacity
+        ordered = raw[start:] + raw[:start]
+
+    # Unwrap the 32 bit cycle counter; events are in order so any step back
+    # is a wrap
+    events, base, last = [], 0, None
+    for cycles, kind, arg, data in ordered:
+        if last is not None and cycles < last:
+            base += 1 << 32
+        last = cycles
+        events.append((base + cycles, kind, arg, data))
+    header = dict(version=version, capacity=capacity, cpu_hz=cpu_hz, head=head,
+                  frozen=frozen, post=post, worst=worst, threshold=threshold)
+    return header, names, events
+
+
+def describe(kind, arg, data, names):
+    label = EVENTS.get(kind, "EVT{}".format(kind))
+    if kind in TASK_EVENTS:
+        who = names[arg] if arg < len(names) and names[arg] else "#{}".format(arg)
+        text = "{:<14}{}".format(label, who)
+        if kind in (10, 11):
+            text += " queue {}".format(data)
+        elif kind == 12:
+            text += " bits 0x{:04x}".format(data)
+        return text
+    if kind in (3, 4):
+        return "{:<14}{}".format(label, EXCEPTIONS.get(arg, "IRQ{}".format(arg - 16)))
+    if kind == 5:
+        return "{:<14}{}".format(label, data)
+    if kind == 13:
+        return "{:<14}key {} {}".format(label, data, "down" if arg else "up")
+    if kind == 17:
+        return "{:<14}level {}, {} ms".format(label, arg, data)
+    if kind in (15, 16):
+        return "{:<14}{} us".format(label, data) if data else label
+    return label
+
+
+def summarize(events, names, cpu_hz):
+    """Per-task activation counts and lengths, ISR durations, key latencies."""
+    us = 1e6 / cpu_hz
+    running, runs = {}, {}
+    isr_open, isrs = {}, {}
+    latencies = []
+    for cycles, kind, arg, data in events:
+        if kind == 1:
+            running[arg] = cycles
+        elif kind == 2 and arg in running:
+            runs.setdefault(arg, []).append((cycles - running.pop(arg)) * us)
+        elif kind == 3:
+            isr_open[arg] = cycles
+        elif kind == 4 and arg in isr_open:
+            isrs.setdefault(arg, []).append((cycles - isr_open.pop(arg)) * us)
+        elif kind == 15 and data:
+            latencies.append(data)
+
+    print("\n{:<10}{:>8}{:>12}{:>12}".format("task", "runs", "mean us", "max us"))
+    for arg in sorted(runs):
+        r = runs[arg]
+        name = names[arg] if arg < len(names) and names[arg] else "#{}".format(arg)
+        print("{:<10}{:>8}{:>12.1f}{:>12.1f}".format(name, len(r), sum(r) / len(r), max(r)))
+    for arg in sorted(isrs):
+        r = isrs[arg]
+        name = EXCEPTIONS.get(arg, "IRQ{}".format(arg - 16))
+        print("{:<10}{:>8}{:>12.1f}{:>12.1f}".format(name, len(r), sum(r) / len(r), max(r)))
+    if latencies:
+        print("\nkey edge to report delivered: {} samples, mean {:.0f} us, max {} us".format(
+            len(latencies), sum(latencies) / len(latencies), max(latencies)))
+
+
+def usb_command(dev, cmd, arg=0):
+    report = struct.pack("<BBxxI", TRACE_REPORT_ID, cmd, arg)
+    dev.send_feature_report(report.ljust(TRACE_REPORT_SIZE, b"\0"))
+
+
+def usb_read(args):
+    import hid
+    dev = hid.device()
+    dev.open(args.vid, args.pid)
+    try:
+        if args.threshold_us is not None:
+            usb_command(dev, CMD_THRESHOLD, args.threshold_us)
+        usb_command(dev, CMD_FREEZE)
+        usb_command(dev, CMD_REWIND)
+        image = bytearray()
+        size = None
+        while size is None or len(image) < size:
+            chunk = bytes(dev.get_feature_report(TRACE_REPORT_ID, TRACE_REPORT_SIZE))
+            _, length, offset = struct.unpack_from("<BBH", chunk, 0)
+            if offset != len(image) or length == 0:
+                raise IOError("trace read out of step at offset {}".format(offset))
+            image += chunk[4:4 + length]
+            if size is None and len(image) >= HEADER.size:
+                capacity = HEADER.unpack_from(image, 0)[2]
+                size = HEADER.size + MAX_TASKS * NAME_LEN + capacity * EVENT.size
+        if args.restart:
+            usb_command(dev, CMD_RESTART)
+        return bytes(image[:size])
+    finally:
+        dev.close()
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("image", nargs="?", help="raw traceRecorder image")
+    ap.add_argument("--usb", action="store_true", help="read the recorder over USB HID")
+    ap.add_argument("--vid", type=int, default=USB_VID)
+    ap.add_argument("--pid", type=int, default=USB_PID)
+    ap.add_argument("--restart", action="store_true",
+                    help="with --usb, clear and restart the recorder after reading")
+    ap.add_argument("--threshold-us", type=int,
+                    help="with --usb, set the latency that freezes the recorder (0 is off)")
+    ap.add_argument("--save", help="with --usb, also write the raw image here")
+    ap.add_argument("--summary-only", action="store_true")
+    args = ap.parse_args()
+
+    if args.usb:
+        image = usb_read(args)
+        if args.save:
+            with open(args.save, "wb") as f:
+                f.write(image)
+    elif args.image:
+        with open(args.image, "rb") as f:
+            image = f.read()
+    else:
+        ap.error("give an image file or --usb")
+
+    header, names, events = parse(image)
+    print("{} events of {} ({} written), {}, worst latency {} us, threshold {}".format(
+        len(events), header["capacity"], header["head"], FROZEN.get(header["frozen"], "?"),
+        header["worst"], "{} us".format(header["threshold"]) if header["threshold"] else "off"))
+    if not events:
+        return 0
+
+    t0 = events[0][0]
+    us = 1e6 / header["cpu_hz"]
+    if not args.summary_only:
+        prev = t0
+        for cycles, kind, arg, data in events:
+            print("{:>14.3f} {:>+10.3f}  {}".format(
+                (cycles - t0) * us, (cycles - prev) * us, describe(kind, arg, data, names)))
+            prev = cycles
+    summarize(events, names, header["cpu_hz"])
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
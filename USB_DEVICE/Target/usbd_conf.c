@@ -24,6 +24,7 @@
 #include "stm32f4xx_hal.h"
 #include "usbd_def.h"
 #include "usbd_core.h"
+#include "usbd_hid.h"
 
 /* USER CODE BEGIN Includes */
 
@@ -57,7 +58,20 @@ USBD_StatusTypeDef USBD_Get_USB_Status(HAL_StatusTypeDef hal_status);
 /* Private functions ---------------------------------------------------------*/
 
 /* USER CODE BEGIN 1 */
+/**
+  * @brief  Returns the number of the last frame started on the bus.
+  * @note   Read from the core, so the SOF interrupt can stay off: at 1 kHz it
+  *         would wake the core out of tickless idle every frame.
+  * @param  pdev: Device handle
+  * @retval Frame number, 11 bits at full speed
+  */
+uint32_t USBD_LL_GetFrameNumber(USBD_HandleTypeDef *pdev)
+{
+  PCD_HandleTypeDef *hpcd = (PCD_HandleTypeDef *)pdev->pData;
+  uint32_t USBx_BASE = (uint32_t)hpcd->Instance;
 
+  return (USBx_DEVICE->DSTS & USB_OTG_DSTS_FNSOF) >> USB_OTG_DSTS_FNSOF_Pos;
+}
 /* USER CODE END 1 */
 
 /*******************************************************************************
@@ -94,6 +108,10 @@ void HAL_PCD_MspInit(PCD_HandleTypeDef* pcdHandle)
 
     /* Peripheral clock enable */
     __HAL_RCC_USB_OTG_FS_CLK_ENABLE();
+
+    /* Peripheral interrupt init */
+    HAL_NVIC_SetPriority(OTG_FS_IRQn, 5, 0);
+    HAL_NVIC_EnableIRQ(OTG_FS_IRQn);
   /* USER CODE BEGIN USB_OTG_FS_MspInit 1 */
 
   /* USER CODE END USB_OTG_FS_MspInit 1 */
@@ -117,6 +135,9 @@ void HAL_PCD_MspDeInit(PCD_HandleTypeDef* pcdHandle)
     */
     HAL_GPIO_DeInit(GPIOA, GPIO_PIN_9|GPIO_PIN_11|GPIO_PIN_12);
 
+    /* Peripheral interrupt Deinit*/
+    HAL_NVIC_DisableIRQ(OTG_FS_IRQn);
+
   /* USER CODE BEGIN USB_OTG_FS_MspDeInit 1 */
 
   /* USER CODE END USB_OTG_FS_MspDeInit 1 */
@@ -610,6 +631,35 @@ void USBD_LL_Delay(uint32_t Delay)
   HAL_Delay(Delay);
 }
 
+/**
+  * @brief  Static single allocation.
+  * @note   The HID class is the only user and allocates its handle on every
+  *         SET_CONFIGURATION, so it is served from one fixed block instead of
+  *         the newlib heap.
+  * @param  size: Size of allocated memory
+  * @retval Pointer to the block, or NULL if it is too small
+  */
+void *USBD_static_malloc(uint32_t size)
+{
+  static uint32_t mem[(sizeof(USBD_HID_HandleTypeDef)/4)+1];/* On 32-bit boundary */
+
+  if (size > sizeof(mem))
+  {
+    return NULL;
+  }
+  return mem;
+}
+
+/**
+  * @brief  Dummy memory free
+  * @param  p: Pointer to allocated  memory address
+  * @retval None
+  */
+void USBD_static_free(void *p)
+{
+  UNUSED(p);
+}
+
 /**
   * @brief  Retuns the USB status depending on the HAL status:
   * @param  hal_status: HAL status
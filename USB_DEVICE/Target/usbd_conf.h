@@ -93,10 +93,10 @@
 /* Memory management macros */
 
 /** Alias for memory allocation. */
-#define USBD_malloc         malloc
+#define USBD_malloc         (uint32_t *)USBD_static_malloc
 
 /** Alias for memory release. */
-#define USBD_free           free
+#define USBD_free           USBD_static_free
 
 /** Alias for memory set. */
 #define USBD_memset         memset
@@ -152,6 +152,12 @@
   */
 
 /* Exported functions -------------------------------------------------------*/
+void *USBD_static_malloc(uint32_t size);
+void USBD_static_free(void *p);
+
+/* usbd_def.h includes this file before it defines USBD_HandleTypeDef */
+struct _USBD_HandleTypeDef;
+uint32_t USBD_LL_GetFrameNumber(struct _USBD_HandleTypeDef *pdev);
 
 /**
   * @}